@@ -0,0 +1,1097 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#include "MockIMAPServer.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <zlib.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/x509v3.h>
+
+namespace {
+    constexpr size_t bodyLineLength = 80;           ///< length of every body line including CRLF
+    constexpr size_t sendThreshold = 256 * 1024;    ///< FETCH output collected before it is sent
+    constexpr time_t firstMessageTime = 1704067200; ///< date of UID 1, 2024-01-01 00:00:00 UTC
+    constexpr time_t messageInterval = 7 * 3600;    ///< time between the dates of two messages
+
+    uint32_t mix(int mailbox, int uid) {
+        return static_cast<uint32_t>(uid) * 2654435761u ^ static_cast<uint32_t>(mailbox) * 40503u;
+    }
+
+    std::string upper(std::string_view text) {
+        std::string result(text);
+        for (char& c : result) {
+            c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        }
+        return result;
+    }
+
+    /**
+     * @brief Removes the quotes and escapes of a quoted string, atoms are returned as they are.
+     */
+    std::string unquote(std::string_view token) {
+        if (token.size() < 2 || token.front() != '"' || token.back() != '"') {
+            return std::string(token);
+        }
+        std::string result;
+        for (size_t i = 1; i + 1 < token.size(); ++i) {
+            if (token[i] == '\\' && i + 2 < token.size()) {
+                ++i;
+            }
+            result += token[i];
+        }
+        return result;
+    }
+
+    /**
+     * @brief Splits command arguments at spaces outside of quoted strings, parentheses and brackets.
+     */
+    std::vector<std::string> tokenize(std::string_view text) {
+        std::vector<std::string> tokens;
+        std::string token;
+        int depth = 0;
+        bool quoted = false;
+
+        for (size_t i = 0; i < text.size(); ++i) {
+            char c = text[i];
+            if (quoted) {
+                if (c == '\\' && i + 1 < text.size()) {
+                    token += c;
+                    c = text[++i];
+                } else if (c == '"') {
+                    quoted = false;
+                }
+            } else if (c == '"') {
+                quoted = true;
+            } else if (c == '(' || c == '[') {
+                ++depth;
+            } else if (c == ')' || c == ']') {
+                --depth;
+            } else if (c == ' ' && depth == 0) {
+                if (!token.empty()) {
+                    tokens.push_back(std::move(token));
+                    token.clear();
+                }
+                continue;
+            }
+            token += c;
+        }
+        if (!token.empty()) {
+            tokens.push_back(std::move(token));
+        }
+        return tokens;
+    }
+
+    /**
+     * @brief Parses a sequence set like `1:5,7,9:*` into the sorted numbers it contains, at most last.
+     * @return False if the set is malformed.
+     */
+    bool parseSet(std::string_view set, int last, std::vector<int>& numbers) {
+        std::vector<bool> contained(static_cast<size_t>(last) + 1, false);
+        auto number = [last](std::string_view text, long& value) {
+            if (text == "*") {
+                value = last;
+                return true;
+            }
+            if (text.empty() || text.size() > 9 || !std::all_of(text.begin(), text.end(), ::isdigit)) {
+                return false;
+            }
+            value = std::stol(std::string(text));
+            return value > 0;
+        };
+
+        while (!set.empty()) {
+            size_t comma = set.find(',');
+            std::string_view range = set.substr(0, comma);
+            set = comma == std::string_view::npos ? std::string_view() : set.substr(comma + 1);
+
+            size_t colon = range.find(':');
+            long from, to;
+            if (!number(range.substr(0, colon), from) ||
+                !number(colon == std::string_view::npos ? range : range.substr(colon + 1), to)) {
+                return false;
+            }
+            if (from > to) {
+                std::swap(from, to);
+            }
+            for (long i = std::max(from, 1L); i <= std::min<long>(to, last); ++i) {
+                contained[i] = true;
+            }
+        }
+
+        numbers.clear();
+        for (int i = 1; i <= last; ++i) {
+            if (contained[i]) {
+                numbers.push_back(i);
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Picks the header fields named in a `HEADER.FIELDS (...)` or `HEADER.FIELDS.NOT (...)` section.
+     */
+    std::string headerFields(std::string_view headers, std::string_view list, bool exclude) {
+        std::vector<std::string> names;
+        for (const std::string& name : tokenize(list.substr(1, list.size() - 2))) {
+            names.push_back(upper(unquote(name)));
+        }
+
+        std::string result;
+        size_t lineStart = 0;
+        bool keep = false;
+        while (lineStart < headers.size()) {
+            size_t lineEnd = headers.find("\r\n", lineStart);
+            lineEnd = lineEnd == std::string_view::npos ? headers.size() : lineEnd + 2;
+            std::string_view line = headers.substr(lineStart, lineEnd - lineStart);
+
+            if (line != "\r\n" && line[0] != ' ' && line[0] != '\t') {
+                std::string name = upper(line.substr(0, line.find(':')));
+                keep = (std::find(names.begin(), names.end(), name) != names.end()) != exclude;
+            }
+            if (keep && line != "\r\n") {
+                result.append(line);
+            }
+            lineStart = lineEnd;
+        }
+        return result + "\r\n";
+    }
+
+    /**
+     * @brief One client connection: reads the commands and answers them until LOGOUT.
+     */
+    class Session {
+    public:
+        Session(const MockIMAPServer& server, int fd, SSL* ssl) : server(server), config(server.getConfig()), fd(fd), ssl(ssl) {}
+
+        void run() {
+            std::string capabilities = capabilityList();
+            send("* OK [CAPABILITY " + capabilities + "] imapcl mock server ready\r\n");
+
+            std::string line;
+            while (readLine(line)) {
+                if (config.latencyMs > 0) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(config.latencyMs));
+                }
+                if (!handle(line)) {
+                    return;
+                }
+            }
+        }
+
+    private:
+        const MockIMAPServer& server;
+        const MockIMAPServer::Config& config;
+        int fd;
+        SSL* ssl;
+        std::string input;          ///< received data not processed yet
+        int selected = -1;          ///< index of the selected mailbox
+        size_t sentBytes = 0;       ///< bytes sent on the connection, for dropAfter
+        std::unique_ptr<z_stream, int (*)(z_streamp)> inflater{nullptr, inflateEnd};
+        std::unique_ptr<z_stream, int (*)(z_streamp)> deflater{nullptr, deflateEnd};
+
+        [[nodiscard]] std::string capabilityList() const {
+            return std::string("IMAP4rev1 LITERAL+") + (config.compress ? " COMPRESS=DEFLATE" : "");
+        }
+
+        /**
+         * @brief Answers one command line.
+         * @return False once the connection is to be closed.
+         */
+        bool handle(const std::string& line) {
+            size_t tagEnd = line.find(' ');
+            if (tagEnd == std::string::npos) {
+                send("* BAD Missing command\r\n");
+                return true;
+            }
+            std::string tag = line.substr(0, tagEnd);
+            std::vector<std::string> words = tokenize(std::string_view(line).substr(tagEnd + 1));
+            if (words.empty()) {
+                send(tag + " BAD Missing command\r\n");
+                return true;
+            }
+
+            std::string command = upper(words[0]);
+            bool byUid = false;
+            words.erase(words.begin());
+            if (command == "UID" && !words.empty()) {
+                byUid = true;
+                command = upper(words[0]);
+                words.erase(words.begin());
+            }
+
+            if (command == "CAPABILITY") {
+                send("* CAPABILITY " + capabilityList() + "\r\n" + tag + " OK CAPABILITY completed\r\n");
+            } else if (command == "NOOP") {
+                send(tag + " OK NOOP completed\r\n");
+            } else if (command == "LOGIN") {
+                send(tag + " OK [CAPABILITY " + capabilityList() + "] Logged in\r\n");
+            } else if (command == "LIST") {
+                list(tag);
+            } else if (command == "SELECT" || command == "EXAMINE") {
+                select(tag, command, words);
+            } else if (command == "SEARCH" && selected >= 0) {
+                search(tag, byUid, words);
+            } else if (command == "FETCH" && selected >= 0 && !words.empty()) {
+                fetch(tag, byUid, words);
+            } else if (command == "COMPRESS" && config.compress && !deflater && !words.empty() && upper(words[0]) == "DEFLATE") {
+                send(tag + " OK DEFLATE active\r\n");
+                startCompression();
+            } else if (command == "LOGOUT") {
+                send("* BYE Logging out\r\n" + tag + " OK LOGOUT completed\r\n");
+                return false;
+            } else {
+                send(tag + " BAD Command not supported\r\n");
+            }
+            return true;
+        }
+
+        void list(const std::string& tag) {
+            std::string response;
+            for (int i = 0; i < config.mailboxes; ++i) {
+                response += "* LIST (\\HasNoChildren) \"/\" \"" + MockIMAPServer::mailboxName(i) + "\"\r\n";
+            }
+            send(response + tag + " OK LIST completed\r\n");
+        }
+
+        void select(const std::string& tag, const std::string& command, const std::vector<std::string>& words) {
+            selected = -1;
+            std::string name = words.empty() ? "" : unquote(words[0]);
+            for (int i = 0; i < config.mailboxes; ++i) {
+                std::string candidate = MockIMAPServer::mailboxName(i);
+                if (name == candidate || (i == 0 && upper(name) == candidate)) {
+                    selected = i;
+                }
+            }
+            if (selected < 0) {
+                send(tag + " NO Mailbox does not exist\r\n");
+                return;
+            }
+
+            send("* FLAGS (\\Seen \\Answered \\Flagged \\Deleted \\Draft)\r\n"
+                 "* " + std::to_string(config.messages) + " EXISTS\r\n"
+                 "* 0 RECENT\r\n"
+                 "* OK [UIDVALIDITY " + std::to_string(1700000000 + selected) + "] UIDs valid\r\n"
+                 "* OK [UIDNEXT " + std::to_string(config.messages + 1) + "] Predicted next UID\r\n" +
+                 tag + " OK [READ-" + (command == "EXAMINE" ? "ONLY" : "WRITE") + "] " + command + " completed\r\n");
+        }
+
+        /**
+         * @brief One search key; NOT, OR and parenthesized lists keep their keys as children.
+         */
+        struct SearchKey {
+            std::string name;
+            std::string field;              ///< header field of FROM and HEADER, uppercase
+            std::string text;               ///< string argument, uppercase
+            long number = 0;                ///< size of LARGER and SMALLER, day of SINCE, BEFORE and ON
+            std::vector<bool> set;          ///< UIDs of a UID or sequence set
+            std::vector<SearchKey> children;
+        };
+
+        /**
+         * @brief Answers SEARCH with the criteria ALL, SEEN, UNSEEN, UID set, sequence set, SINCE, BEFORE, ON,
+         *        LARGER, SMALLER, FROM, HEADER, NOT, OR and parenthesized lists, combined with AND.
+         *
+         * UIDs are 1 to `messages`, so message sequence numbers and UIDs are the same. Strings are
+         * matched as substrings of the raw header values, in any case.
+         */
+        void search(const std::string& tag, bool byUid, std::vector<std::string> criteria) {
+            if (criteria.size() >= 2 && upper(criteria[0]) == "CHARSET") {
+                std::string charset = upper(unquote(criteria[1]));
+                if (charset != "UTF-8" && charset != "US-ASCII") {
+                    send(tag + " NO [BADCHARSET (UTF-8 US-ASCII)] Charset not supported\r\n");
+                    return;
+                }
+                criteria.erase(criteria.begin(), criteria.begin() + 2);
+            }
+
+            SearchKey all;
+            all.name = "AND";
+            for (size_t i = 0; i < criteria.size();) {
+                all.children.emplace_back();
+                if (!parseKey(criteria, i, all.children.back())) {
+                    send(tag + " BAD Search criterion not supported\r\n");
+                    return;
+                }
+            }
+
+            std::vector<bool> matches(static_cast<size_t>(config.messages) + 1, false);
+            for (int uid = 1; uid <= config.messages; ++uid) {
+                std::string message;
+                matches[uid] = matchesKey(all, uid, message);
+            }
+
+            std::string response = "* SEARCH";
+            for (int uid = 1; uid <= config.messages; ++uid) {
+                if (matches[uid]) {
+                    response += ' ';
+                    response += std::to_string(uid);
+                }
+            }
+            send(response + "\r\n" + tag + " OK " + (byUid ? "UID " : "") + "SEARCH completed\r\n");
+        }
+
+        /**
+         * @brief Parses the search key starting at words[i] and moves i past it.
+         * @return False if the key is not supported or malformed.
+         */
+        bool parseKey(const std::vector<std::string>& words, size_t& i, SearchKey& key) {
+            if (i >= words.size()) {
+                return false;
+            }
+            const std::string& word = words[i++];
+            if (word.size() >= 2 && word.front() == '(' && word.back() == ')') {
+                key.name = "AND";
+                std::vector<std::string> inner = tokenize(std::string_view(word).substr(1, word.size() - 2));
+                for (size_t j = 0; j < inner.size();) {
+                    key.children.emplace_back();
+                    if (!parseKey(inner, j, key.children.back())) {
+                        return false;
+                    }
+                }
+                return !key.children.empty();
+            }
+
+            key.name = upper(word);
+            if (key.name == "ALL" || key.name == "SEEN" || key.name == "UNSEEN") {
+                return true;
+            } else if (key.name == "NOT" || key.name == "OR") {
+                key.children.resize(key.name == "OR" ? 2 : 1);
+                return std::all_of(key.children.begin(), key.children.end(), [&](SearchKey& child) {
+                    return parseKey(words, i, child);
+                });
+            } else if (key.name == "LARGER" || key.name == "SMALLER") {
+                if (i >= words.size() || words[i].empty() || words[i].size() > 9 ||
+                    !std::all_of(words[i].begin(), words[i].end(), ::isdigit)) {
+                    return false;
+                }
+                key.number = std::stol(words[i++]);
+                return true;
+            } else if (key.name == "SINCE" || key.name == "BEFORE" || key.name == "ON") {
+                return i < words.size() && parseDate(unquote(words[i++]), key.number);
+            } else if (key.name == "FROM" || key.name == "HEADER") {
+                size_t arguments = key.name == "FROM" ? 1 : 2;
+                if (i + arguments > words.size()) {
+                    return false;
+                }
+                key.field = key.name == "FROM" ? "FROM" : upper(unquote(words[i++]));
+                key.text = upper(unquote(words[i++]));
+                return true;
+            }
+
+            std::string_view setText = key.name;
+            if (key.name == "UID") {
+                if (i >= words.size()) {
+                    return false;
+                }
+                setText = words[i++];
+            }
+            std::vector<int> set;
+            if (!parseSet(setText, config.messages, set)) {
+                return false;
+            }
+            key.name = "SET";
+            key.set.assign(static_cast<size_t>(config.messages) + 1, false);
+            for (int uid : set) {
+                key.set[uid] = true;
+            }
+            return true;
+        }
+
+        /**
+         * @brief Evaluates a search key for one message.
+         * @param message The message, generated on first use when a key needs its size or headers.
+         */
+        bool matchesKey(const SearchKey& key, int uid, std::string& message) {
+            if (key.name == "AND") {
+                return std::all_of(key.children.begin(), key.children.end(), [&](const SearchKey& child) {
+                    return matchesKey(child, uid, message);
+                });
+            } else if (key.name == "OR") {
+                return matchesKey(key.children[0], uid, message) || matchesKey(key.children[1], uid, message);
+            } else if (key.name == "NOT") {
+                return !matchesKey(key.children[0], uid, message);
+            } else if (key.name == "ALL") {
+                return true;
+            } else if (key.name == "SEEN" || key.name == "UNSEEN") {
+                return server.isSeen(selected, uid) == (key.name == "SEEN");
+            } else if (key.name == "SET") {
+                return key.set[uid];
+            } else if (key.name == "SINCE" || key.name == "BEFORE" || key.name == "ON") {
+                time_t time = firstMessageTime + static_cast<time_t>(uid) * messageInterval;
+                long day = static_cast<long>(time - time % (24 * 3600));
+                return key.name == "SINCE" ? day >= key.number : key.name == "BEFORE" ? day < key.number : day == key.number;
+            }
+
+            if (message.empty()) {
+                message = server.message(selected, uid);
+            }
+            if (key.name == "LARGER" || key.name == "SMALLER") {
+                long size = static_cast<long>(message.size());
+                return key.name == "LARGER" ? size > key.number : size < key.number;
+            }
+
+            // FROM and HEADER: a substring of the field value, an empty string only needs the field
+            std::string value = headerFields(sectionOf(message, "HEADER"), "(" + key.field + ")", false);
+            if (value == "\r\n") {
+                return false;
+            }
+            return upper(value.substr(value.find(':') + 1)).find(key.text) != std::string::npos;
+        }
+
+        /**
+         * @brief Parses an IMAP date like `1-Feb-2024` into the start of the day in UTC.
+         */
+        static bool parseDate(const std::string& text, long& day) {
+            static constexpr const char* months[] = {"JAN", "FEB", "MAR", "APR", "MAY", "JUN",
+                                                     "JUL", "AUG", "SEP", "OCT", "NOV", "DEC"};
+            int mday, year;
+            char month[4];
+            if (std::sscanf(text.c_str(), "%2d-%3s-%4d", &mday, month, &year) != 3) {
+                return false;
+            }
+            struct tm date{};
+            date.tm_mday = mday;
+            date.tm_year = year - 1900;
+            date.tm_mon = -1;
+            for (int i = 0; i < 12; ++i) {
+                if (upper(month) == months[i]) {
+                    date.tm_mon = i;
+                }
+            }
+            if (date.tm_mon < 0) {
+                return false;
+            }
+            day = static_cast<long>(timegm(&date));
+            return true;
+        }
+
+        void fetch(const std::string& tag, bool byUid, const std::vector<std::string>& words) {
+            std::vector<int> uids;
+            if (!parseSet(words[0], config.messages, uids) || words.size() < 2) {
+                send(tag + " BAD Invalid sequence set\r\n");
+                return;
+            }
+
+            std::vector<std::string> items;
+            for (size_t i = 1; i < words.size(); ++i) {
+                std::string_view item = words[i];
+                if (words.size() == 2 && item.size() >= 2 && item.front() == '(' && item.back() == ')') {
+                    items = tokenize(item.substr(1, item.size() - 2));
+                } else {
+                    items.emplace_back(item);
+                }
+            }
+            if (byUid && std::none_of(items.begin(), items.end(), [](const std::string& item) { return upper(item) == "UID"; })) {
+                items.insert(items.begin(), "UID");     // UID FETCH always returns the UID
+            }
+
+            std::string output;
+            for (int uid : uids) {
+                std::string message = server.message(selected, uid);
+                output += "* " + std::to_string(uid) + " FETCH (";
+                for (size_t i = 0; i < items.size(); ++i) {
+                    if (i > 0) {
+                        output += ' ';
+                    }
+                    if (!fetchItem(output, items[i], uid, message)) {
+                        send(tag + " BAD Fetch item not supported\r\n");
+                        return;
+                    }
+                }
+                output += ")\r\n";
+
+                if (output.size() >= sendThreshold) {
+                    send(output);
+                    output.clear();
+                }
+            }
+            send(output + tag + " OK " + (byUid ? "UID " : "") + "FETCH completed\r\n");
+        }
+
+        /**
+         * @brief Appends one data item of a FETCH response.
+         * @return False if the item is not supported.
+         */
+        bool fetchItem(std::string& output, const std::string& item, int uid, const std::string& message) {
+            std::string name = upper(item);
+            if (name == "UID") {
+                output += "UID " + std::to_string(uid);
+                return true;
+            } else if (name == "FLAGS") {
+                output += server.isSeen(selected, uid) ? "FLAGS (\\Seen)" : "FLAGS ()";
+                return true;
+            } else if (name == "RFC822.SIZE") {
+                output += "RFC822.SIZE " + std::to_string(message.size());
+                return true;
+            } else if (name == "INTERNALDATE") {
+                char date[40];
+                time_t time = firstMessageTime + static_cast<time_t>(uid) * messageInterval;
+                struct tm utc{};
+                gmtime_r(&time, &utc);
+                std::strftime(date, sizeof(date), "\"%d-%b-%Y %H:%M:%S +0000\"", &utc);
+                output += std::string("INTERNALDATE ") + date;
+                return true;
+            } else if (name == "ENVELOPE") {
+                envelope(output, message);
+                return true;
+            } else if (name == "RFC822" || name == "RFC822.HEADER" || name == "RFC822.TEXT") {
+                std::string section = name == "RFC822" ? "" : name.substr(7);
+                output += name + " ";
+                literal(output, sectionOf(message, section));
+                return true;
+            }
+
+            // BODY[section]<offset.length> and BODY.PEEK[...]
+            size_t open = name.find('[');
+            size_t close = name.rfind(']');
+            if (open == std::string::npos || close == std::string::npos || close < open ||
+                (name.compare(0, open, "BODY") != 0 && name.compare(0, open, "BODY.PEEK") != 0)) {
+                return false;
+            }
+            std::string section = item.substr(open + 1, close - open - 1);
+            std::string data = sectionOf(message, section);
+            std::string origin;
+
+            std::string_view partial = std::string_view(name).substr(close + 1);
+            if (!partial.empty()) {
+                size_t dot = partial.find('.');
+                auto isNumber = [](std::string_view text) {
+                    return !text.empty() && text.size() < 10 && std::all_of(text.begin(), text.end(), ::isdigit);
+                };
+                if (partial.front() != '<' || partial.back() != '>' || dot == std::string_view::npos ||
+                    !isNumber(partial.substr(1, dot - 1)) || !isNumber(partial.substr(dot + 1, partial.size() - dot - 2))) {
+                    return false;
+                }
+                size_t offset = std::stoul(std::string(partial.substr(1, dot - 1)));
+                size_t length = std::stoul(std::string(partial.substr(dot + 1, partial.size() - dot - 2)));
+                data = offset < data.size() ? data.substr(offset, length) : "";
+                origin = "<" + std::to_string(offset) + ">";
+            }
+
+            output += "BODY[" + section + "]" + origin + " ";
+            literal(output, data);
+            return true;
+        }
+
+        /**
+         * @brief Returns a body section: the whole message, HEADER, TEXT or HEADER.FIELDS[.NOT] (...).
+         */
+        static std::string sectionOf(const std::string& message, const std::string& section) {
+            size_t headersEnd = message.find("\r\n\r\n");
+            headersEnd = headersEnd == std::string::npos ? message.size() : headersEnd + 4;
+            std::string name = upper(section);
+
+            if (name.empty()) {
+                return message;
+            } else if (name == "HEADER") {
+                return message.substr(0, headersEnd);
+            } else if (name == "TEXT") {
+                return message.substr(headersEnd);
+            }
+
+            bool exclude = name.compare(0, 18, "HEADER.FIELDS.NOT ") == 0;
+            size_t list = section.find('(');
+            if ((exclude || name.compare(0, 14, "HEADER.FIELDS ") == 0) && list != std::string::npos) {
+                return headerFields(std::string_view(message).substr(0, headersEnd), std::string_view(section).substr(list), exclude);
+            }
+            return "";
+        }
+
+        /**
+         * @brief Appends the ENVELOPE of a message; the mock messages have exactly one From and To address.
+         */
+        static void envelope(std::string& output, const std::string& message) {
+            std::string headers = sectionOf(message, "HEADER");
+            auto field = [&headers](const std::string& name) {
+                std::string value = headerFields(headers, "(" + name + ")", false);
+                size_t colon = value.find(':');
+                size_t end = value.find("\r\n");
+                return colon == std::string::npos ? std::string() : value.substr(colon + 2, end - colon - 2);
+            };
+            auto address = [&output](const std::string& value) {
+                // "Name <mailbox@host>" or "mailbox@host"
+                size_t open = value.find('<');
+                std::string name = open == std::string::npos || open == 0 ? "" : value.substr(0, open - 1);
+                std::string address = open == std::string::npos ? value : value.substr(open + 1, value.find('>') - open - 1);
+                size_t at = address.find('@');
+                output += "((";
+                nstring(output, name);
+                output += " NIL ";
+                nstring(output, address.substr(0, at));
+                output += ' ';
+                nstring(output, at == std::string::npos ? "" : address.substr(at + 1));
+                output += "))";
+            };
+
+            std::string from = field("From");
+            output += "ENVELOPE (";
+            nstring(output, field("Date"));
+            output += ' ';
+            nstring(output, field("Subject"));
+            for (const std::string& value : {from, from, from, field("To")}) {    // From, Sender, Reply-To, To
+                output += ' ';
+                address(value);
+            }
+            output += " NIL NIL NIL ";
+            nstring(output, field("Message-ID"));
+            output += ')';
+        }
+
+        /**
+         * @brief Appends NIL, a quoted string or, for 8-bit text and special characters, a literal.
+         */
+        static void nstring(std::string& output, const std::string& value) {
+            if (value.empty()) {
+                output += "NIL";
+            } else if (std::any_of(value.begin(), value.end(), [](char c) {
+                return c == '"' || c == '\\' || c == '\r' || c == '\n' || static_cast<unsigned char>(c) >= 0x80;
+            })) {
+                literal(output, value);
+            } else {
+                output += "\"" + value + "\"";
+            }
+        }
+
+        static void literal(std::string& output, const std::string& data) {
+            output += "{" + std::to_string(data.size()) + "}\r\n";
+            output += data;
+        }
+
+        /**
+         * @brief Reads one command without its CRLF; its literals are turned into quoted strings.
+         *
+         * A synchronizing literal (`{n}`) is answered with a continuation request, a LITERAL+ one
+         * (`{n+}`) is read right away.
+         * @return False if the client closed the connection.
+         */
+        bool readLine(std::string& line) {
+            line.clear();
+            while (true) {
+                size_t lineEnd;
+                while ((lineEnd = input.find('\n')) == std::string::npos) {
+                    if (!receive()) {
+                        return false;
+                    }
+                }
+                line.append(input, 0, lineEnd > 0 && input[lineEnd - 1] == '\r' ? lineEnd - 1 : lineEnd);
+                input.erase(0, lineEnd + 1);
+
+                size_t open = line.rfind('{');
+                if (line.empty() || line.back() != '}' || open == std::string::npos) {
+                    return true;
+                }
+                std::string size = line.substr(open + 1, line.size() - open - 2);
+                bool synchronizing = size.empty() || size.back() != '+';
+                if (!synchronizing) {
+                    size.pop_back();
+                }
+                if (size.empty() || size.size() > 9 || !std::all_of(size.begin(), size.end(), ::isdigit)) {
+                    return true;
+                }
+                line.erase(open);
+
+                size_t length = std::stoul(size);
+                if (synchronizing) {
+                    send("+ Ready for literal data\r\n");
+                }
+                while (input.size() < length) {
+                    if (!receive()) {
+                        return false;
+                    }
+                }
+                line += '"';
+                for (size_t i = 0; i < length; ++i) {
+                    if (input[i] == '"' || input[i] == '\\') {
+                        line += '\\';
+                    }
+                    line += input[i];
+                }
+                line += '"';
+                input.erase(0, length);
+            }
+        }
+
+        /**
+         * @brief Receives more data into input, inflating it once compression is active.
+         */
+        bool receive() {
+            char buffer[64 * 1024];
+            size_t received = receiveRaw(buffer, sizeof(buffer));
+            if (received == 0) {
+                return false;
+            }
+            if (!inflater) {
+                input.append(buffer, received);
+                return true;
+            }
+
+            char inflated[64 * 1024];
+            inflater->next_in = reinterpret_cast<Bytef*>(buffer);
+            inflater->avail_in = static_cast<uInt>(received);
+            do {
+                inflater->next_out = reinterpret_cast<Bytef*>(inflated);
+                inflater->avail_out = sizeof(inflated);
+                int status = inflate(inflater.get(), Z_SYNC_FLUSH);
+                if (status != Z_OK && status != Z_BUF_ERROR) {
+                    throw std::runtime_error("Invalid compressed data");
+                }
+                input.append(inflated, sizeof(inflated) - inflater->avail_out);
+            } while (inflater->avail_in > 0 || inflater->avail_out == 0);
+            return true;
+        }
+
+        size_t receiveRaw(char* buffer, size_t size) {
+            if (ssl) {
+                int received = SSL_read(ssl, buffer, static_cast<int>(size));
+                return received > 0 ? static_cast<size_t>(received) : 0;
+            }
+            ssize_t received;
+            do {
+                received = recv(fd, buffer, size, 0);
+            } while (received < 0 && errno == EINTR);
+            return received > 0 ? static_cast<size_t>(received) : 0;
+        }
+
+        void send(std::string_view data) {
+            if (!deflater) {
+                sendRaw(data.data(), data.size());
+                return;
+            }
+
+            char deflated[64 * 1024];
+            deflater->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+            deflater->avail_in = static_cast<uInt>(data.size());
+            do {
+                deflater->next_out = reinterpret_cast<Bytef*>(deflated);
+                deflater->avail_out = sizeof(deflated);
+                deflate(deflater.get(), Z_SYNC_FLUSH);
+                sendRaw(deflated, sizeof(deflated) - deflater->avail_out);
+            } while (deflater->avail_out == 0);
+        }
+
+        void sendRaw(const char* data, size_t size) {
+            bool drop = config.dropAfter > 0 && sentBytes + size > config.dropAfter;
+            if (drop) {
+                size = config.dropAfter - sentBytes;
+            }
+            sentBytes += size;
+
+            while (size > 0) {
+                ssize_t sent;
+                if (ssl) {
+                    int written = SSL_write(ssl, data, static_cast<int>(std::min<size_t>(size, INT32_MAX)));
+                    sent = written > 0 ? written : -1;
+                } else {
+                    sent = ::send(fd, data, size, MSG_NOSIGNAL);
+                    if (sent < 0 && errno == EINTR) {
+                        continue;
+                    }
+                }
+                if (sent <= 0) {
+                    throw std::runtime_error("Connection closed by client");
+                }
+                data += sent;
+                size -= static_cast<size_t>(sent);
+            }
+            if (drop) {
+                throw std::runtime_error("Connection dropped");
+            }
+        }
+
+        /**
+         * @brief Starts COMPRESS=DEFLATE (RFC 4978); data received behind the command is already compressed.
+         */
+        void startCompression() {
+            inflater.reset(new z_stream{});
+            deflater.reset(new z_stream{});
+            if (inflateInit2(inflater.get(), -15) != Z_OK ||
+                deflateInit2(deflater.get(), Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+                throw std::runtime_error("Failed to start compression");
+            }
+
+            std::string compressed = std::move(input);
+            input.clear();
+            if (!compressed.empty()) {
+                char inflated[64 * 1024];
+                inflater->next_in = reinterpret_cast<Bytef*>(compressed.data());
+                inflater->avail_in = static_cast<uInt>(compressed.size());
+                do {
+                    inflater->next_out = reinterpret_cast<Bytef*>(inflated);
+                    inflater->avail_out = sizeof(inflated);
+                    inflate(inflater.get(), Z_SYNC_FLUSH);
+                    input.append(inflated, sizeof(inflated) - inflater->avail_out);
+                } while (inflater->avail_in > 0 || inflater->avail_out == 0);
+            }
+        }
+    };
+}
+
+MockIMAPServer::MockIMAPServer(Config config) : config(std::move(config)) {
+    // the longest message body is 1.5 times the average message size
+    size_t bodySize = this->config.messageSize * 2 + bodyLineLength;
+    for (int i = 1; bodyText.size() < bodySize; ++i) {
+        std::string line = "Line " + std::to_string(i) + ": the quick brown fox jumps over the lazy dog.";
+        line.resize(bodyLineLength - 2, ' ');
+        bodyText += line + "\r\n";
+    }
+}
+
+MockIMAPServer::~MockIMAPServer() {
+    stop();
+}
+
+void MockIMAPServer::start() {
+    stopping = false;
+    if (config.tlsPort >= 0) {
+        createContext();
+        tlsListenFd = listen(config.tlsPort, boundTlsPort);
+        acceptors.emplace_back(&MockIMAPServer::accept, this, tlsListenFd, true);
+    }
+    if (config.port >= 0) {
+        listenFd = listen(config.port, boundPort);
+        acceptors.emplace_back(&MockIMAPServer::accept, this, listenFd, false);
+    }
+}
+
+void MockIMAPServer::stop() {
+    stopping = true;
+    for (int fd : {listenFd, tlsListenFd}) {
+        if (fd >= 0) {
+            shutdown(fd, SHUT_RDWR);   // wakes the accepting thread
+        }
+    }
+    for (auto& thread : acceptors) {
+        thread.join();
+    }
+    acceptors.clear();
+    for (int* fd : {&listenFd, &tlsListenFd}) {
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(connectionsMutex);
+    for (int fd : connections) {
+        shutdown(fd, SHUT_RDWR);
+    }
+    connectionsDone.wait(lock, [this] { return running == 0; });
+    lock.unlock();
+
+    if (ctx) {
+        SSL_CTX_free(ctx);
+        ctx = nullptr;
+    }
+}
+
+int MockIMAPServer::getPort() const {
+    return boundPort;
+}
+
+int MockIMAPServer::getTlsPort() const {
+    return boundTlsPort;
+}
+
+const MockIMAPServer::Config& MockIMAPServer::getConfig() const {
+    return config;
+}
+
+std::string MockIMAPServer::mailboxName(int index) {
+    return index == 0 ? "INBOX" : "Folder " + std::to_string(index);
+}
+
+std::string MockIMAPServer::message(int mailbox, int uid) const {
+    uint32_t hash = mix(mailbox, uid);
+    std::string mailboxText = mailboxName(mailbox);
+
+    // subjects alternate between plain text and RFC 2047 encoded words
+    std::string subject;
+    switch (uid % 4) {
+        case 0: subject = "Quarterly report " + std::to_string(uid) + " for " + mailboxText; break;
+        case 1: {
+            std::string text = "Zpr\xc3\xa1va \xc4\x8d. " + std::to_string(uid);
+            std::string encoded(4 * ((text.size() + 2) / 3), '\0');
+            EVP_EncodeBlock(reinterpret_cast<unsigned char*>(encoded.data()),
+                            reinterpret_cast<const unsigned char*>(text.data()), static_cast<int>(text.size()));
+            subject = "=?UTF-8?B?" + encoded + "?=";
+            break;
+        }
+        case 2: subject = "=?ISO-8859-2?Q?Zpr=E1va_=E8=2E_" + std::to_string(uid) + "?="; break;
+        default: subject = "Re: Meeting notes " + std::to_string(uid); break;
+    }
+
+    char date[64];
+    time_t time = firstMessageTime + static_cast<time_t>(uid) * messageInterval;
+    struct tm utc{};
+    gmtime_r(&time, &utc);
+    std::strftime(date, sizeof(date), "%a, %d %b %Y %H:%M:%S +0000", &utc);
+
+    std::string sender = "sender" + std::to_string(hash % 97);
+    std::string message = "Return-Path: <" + sender + "@example.org>\r\n"
+                          "From: Sender " + std::to_string(hash % 97) + " <" + sender + "@example.org>\r\n"
+                          "To: user@example.com\r\n"
+                          "Subject: " + subject + "\r\n"
+                          "Date: " + date + "\r\n"
+                          "Message-ID: <" + std::to_string(uid) + "." + std::to_string(mailbox) + "@mock.example.org>\r\n"
+                          "MIME-Version: 1.0\r\n"
+                          "Content-Type: text/plain; charset=UTF-8\r\n"
+                          "\r\n";
+
+    // sizes are spread evenly between 0.5 and 1.5 times the average
+    size_t size = config.messageSize / 2 + hash % (config.messageSize + 1);
+    size_t body = size > message.size() ? size - message.size() : 0;
+    body = std::max<size_t>(body / bodyLineLength, 1) * bodyLineLength;
+    message.append(bodyText, 0, std::min(body, bodyText.size()));
+    return message;
+}
+
+bool MockIMAPServer::isSeen(int mailbox, int uid) const {
+    return static_cast<int>((mix(mailbox, uid) >> 7) % 100) >= config.unseenPercent;
+}
+
+/**
+ * @brief Binds a listening socket to the configured address.
+ * @param port The port, 0 for any free one.
+ * @param boundTo Set to the bound port.
+ */
+int MockIMAPServer::listen(int port, int& boundTo) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to create socket");
+    }
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    socklen_t length = sizeof(address);
+    if (inet_pton(AF_INET, config.address.c_str(), &address.sin_addr) != 1 ||
+        bind(fd, reinterpret_cast<sockaddr*>(&address), length) != 0 || ::listen(fd, 128) != 0 ||
+        getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+        close(fd);
+        throw std::runtime_error("Failed to listen on " + config.address + ":" + std::to_string(port));
+    }
+    boundTo = ntohs(address.sin_port);
+    return fd;
+}
+
+/**
+ * @brief Creates the server context with a new self-signed certificate for localhost and 127.0.0.1.
+ */
+void MockIMAPServer::createContext() {
+    ctx = SSL_CTX_new(TLS_server_method());
+    EVP_PKEY* key = EVP_EC_gen("P-256");
+    X509* cert = X509_new();
+    bool ok = ctx && key && cert;
+
+    if (ok) {
+        X509_set_version(cert, 2);
+        ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+        X509_gmtime_adj(X509_getm_notBefore(cert), -3600);
+        X509_gmtime_adj(X509_getm_notAfter(cert), 365L * 24 * 3600);
+        X509_set_pubkey(cert, key);
+
+        X509_NAME* name = X509_get_subject_name(cert);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+        X509_set_issuer_name(cert, name);
+
+        X509V3_CTX extensions;
+        X509V3_set_ctx_nodb(&extensions);
+        X509V3_set_ctx(&extensions, cert, cert, nullptr, nullptr, 0);
+        for (auto [nid, value] : {std::pair{NID_subject_alt_name, "DNS:localhost,IP:127.0.0.1"},
+                                  std::pair{NID_basic_constraints, "critical,CA:TRUE"}}) {
+            X509_EXTENSION* extension = X509V3_EXT_conf_nid(nullptr, &extensions, nid, value);
+            ok = ok && extension && X509_add_ext(cert, extension, -1);
+            X509_EXTENSION_free(extension);
+        }
+
+        ok = ok && X509_sign(cert, key, EVP_sha256()) > 0 &&
+             SSL_CTX_use_certificate(ctx, cert) == 1 && SSL_CTX_use_PrivateKey(ctx, key) == 1;
+    }
+
+    if (ok && !config.certFile.empty()) {
+        FILE* file = std::fopen(config.certFile.c_str(), "w");
+        ok = file && PEM_write_X509(file, cert) == 1;
+        if (file && std::fclose(file) != 0) {
+            ok = false;
+        }
+    }
+
+    X509_free(cert);
+    EVP_PKEY_free(key);
+    if (!ok) {
+        ERR_print_errors_fp(stderr);
+        throw std::runtime_error("Failed to create the self-signed certificate");
+    }
+}
+
+void MockIMAPServer::accept(int fd, bool tls) {
+    while (!stopping) {
+        int client = accept4(fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            break;      // the listening socket was shut down
+        }
+
+        // responses are written in several pieces, Nagle would hold them back for the delayed ACK
+        int noDelay = 1;
+        setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        std::lock_guard<std::mutex> lock(connectionsMutex);
+        if (stopping) {
+            close(client);
+            break;
+        }
+        connections.insert(client);
+        ++running;
+        std::thread(&MockIMAPServer::serve, this, client, tls).detach();
+    }
+}
+
+void MockIMAPServer::serve(int fd, bool tls) {
+    SSL* ssl = nullptr;
+    try {
+        if (tls) {
+            ssl = SSL_new(ctx);
+            if (!ssl || SSL_set_fd(ssl, fd) != 1 || SSL_accept(ssl) <= 0) {
+                throw std::runtime_error("TLS handshake failed");
+            }
+        }
+        Session(*this, fd, ssl).run();
+    } catch (const std::exception&) {
+        // the client went away, nothing to report
+    }
+
+    if (ssl) {
+        SSL_shutdown(ssl);
+        SSL_free(ssl);
+    }
+    ERR_clear_error();
+
+    std::lock_guard<std::mutex> lock(connectionsMutex);
+    connections.erase(fd);
+    close(fd);
+    --running;
+    connectionsDone.notify_all();
+}
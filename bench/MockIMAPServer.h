@@ -0,0 +1,126 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#ifndef IMAP_TLS_CLIENT_MOCKIMAPSERVER_H
+#define IMAP_TLS_CLIENT_MOCKIMAPSERVER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <set>
+#include <thread>
+#include <atomic>
+#include <cstddef>
+#include <openssl/ssl.h>
+
+/**
+ * @brief Localhost IMAP server serving synthetic mailboxes, for benchmarks and manual tests.
+ *
+ * The server listens on a plain and a TLS port (a self-signed certificate is generated at
+ * start) and answers the subset of IMAP4rev1 used by imapcl: CAPABILITY, NOOP, LOGIN, LIST,
+ * SELECT, EXAMINE, [UID] SEARCH, [UID] FETCH, COMPRESS=DEFLATE and LOGOUT. Every login is
+ * accepted.
+ *
+ * The mailboxes are `INBOX` and `Folder 1` ... `Folder n-1`, each holding messages with the
+ * UIDs 1 to `messages`. Messages are generated from their mailbox and UID on every FETCH, so
+ * large mailboxes take no memory; their sizes vary around `messageSize`, a part of their
+ * subjects is RFC 2047 encoded and `unseenPercent` of them are not \\Seen. The mailboxes are
+ * read-only: FETCH does not set \\Seen, so repeated runs see the same state.
+ *
+ * Every connection is served by its own thread.
+ */
+class MockIMAPServer {
+public:
+    struct Config {
+        std::string address = "127.0.0.1";
+        int port = 0;               // plain port, 0 picks a free one, -1 disables it
+        int tlsPort = 0;            // TLS port, 0 picks a free one, -1 disables it
+        std::string certFile;       // the generated certificate is written here, empty for none
+        int mailboxes = 1;          // INBOX and mailboxes - 1 folders
+        int messages = 1000;        // messages per mailbox
+        size_t messageSize = 16 * 1024; // average message size in bytes
+        int unseenPercent = 10;     // messages without the \Seen flag
+        bool compress = true;       // announce COMPRESS=DEFLATE
+        int latencyMs = 0;          // delay before answering every command, simulating a slow server
+        size_t dropAfter = 0;       // close every connection after sending this many bytes, simulating a flaky link, 0 never
+    };
+
+    explicit MockIMAPServer(Config config);
+
+    /**
+     * @brief Stops the server if it is running.
+     */
+    ~MockIMAPServer();
+
+    MockIMAPServer(const MockIMAPServer&) = delete;
+    MockIMAPServer& operator=(const MockIMAPServer&) = delete;
+
+    /**
+     * @brief Binds the ports, prepares the TLS context and starts accepting connections.
+     * @throws std::runtime_error if a port cannot be bound or the certificate cannot be created.
+     */
+    void start();
+
+    /**
+     * @brief Closes the listening sockets and all connections and waits for their threads.
+     */
+    void stop();
+
+    /**
+     * @brief Returns the bound plain port, -1 if disabled.
+     */
+    [[nodiscard]] int getPort() const;
+
+    /**
+     * @brief Returns the bound TLS port, -1 if disabled.
+     */
+    [[nodiscard]] int getTlsPort() const;
+
+    [[nodiscard]] const Config& getConfig() const;
+
+    /**
+     * @brief Returns the name of a mailbox by its index, INBOX for 0.
+     */
+    [[nodiscard]] static std::string mailboxName(int index);
+
+    /**
+     * @brief Builds the message with the given UID, the same on every call.
+     * @param mailbox The index of the mailbox.
+     * @param uid The UID, 1 to `messages`.
+     */
+    [[nodiscard]] std::string message(int mailbox, int uid) const;
+
+    /**
+     * @brief Tells whether the message has the \\Seen flag.
+     */
+    [[nodiscard]] bool isSeen(int mailbox, int uid) const;
+
+private:
+    Config config;
+    int listenFd = -1;                  ///< plain listening socket
+    int tlsListenFd = -1;               ///< TLS listening socket
+    int boundPort = -1;                 ///< port of listenFd
+    int boundTlsPort = -1;              ///< port of tlsListenFd
+    SSL_CTX* ctx = nullptr;             ///< server context with the self-signed certificate
+    std::string bodyText;               ///< text the message bodies are cut from
+    std::vector<std::thread> acceptors; ///< one accepting thread per listening socket
+
+    std::atomic<bool> stopping{false};
+    std::mutex connectionsMutex;        ///< guards connections and running
+    std::condition_variable connectionsDone;
+    std::set<int> connections;          ///< sockets of the served connections
+    size_t running = 0;                 ///< connection threads not finished yet
+
+    int listen(int port, int& boundTo);
+
+    void createContext();
+
+    void accept(int fd, bool tls);
+
+    void serve(int fd, bool tls);
+};
+
+#endif //IMAP_TLS_CLIENT_MOCKIMAPSERVER_H
@@ -0,0 +1,337 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#include "MockIMAPServer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <getopt.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+    /**
+     * @brief One imapcl invocation measured by the benchmark.
+     */
+    struct Scenario {
+        std::string name;
+        bool tls;
+        std::vector<std::string> arguments;     // added to the server, auth and output arguments
+    };
+
+    struct Options {
+        std::string imapcl = "./imapcl";
+        std::string workDir;            // output directories and files, a new temporary directory if empty
+        std::string json;               // results as JSON, empty for none
+        std::vector<std::string> only;  // scenarios to run, all if empty
+        int iterations = 5;
+        int warmup = 1;
+        MockIMAPServer::Config server;
+    };
+
+    /**
+     * @brief Measurements of one run, read from the wait status and the --stats-json output of imapcl.
+     */
+    struct Run {
+        double seconds = 0;
+        long peakRssKb = 0;
+        double bytes = 0;
+        double messages = 0;
+        std::vector<double> phaseMs;    // average latency of every phase in `phases`, -1 if not measured
+    };
+
+    const std::vector<Scenario> scenarios = {
+            {"plain", false, {}},
+            {"plain-new", false, {"-n"}},
+            {"plain-headers", false, {"-h"}},
+            {"tls", true, {}},
+            {"tls-new", true, {"-n"}},
+            {"tls-connections", true, {"--connections", "4"}},
+            {"plain-event-loops", false, {"--all-mailboxes", "--event-loops", "2"}},
+            {"tls-event-loops", true, {"--all-mailboxes", "--event-loops", "2"}},
+    };
+
+    const std::vector<std::string> phases = {"tcp_connect", "tls_handshake", "greeting", "login", "select",
+                                             "search", "metadata", "fetch", "disk_write", "logout"};
+
+    /**
+     * @brief Returns the nearest-rank percentile of the values.
+     */
+    double percentile(std::vector<double> values, double fraction) {
+        if (values.empty()) {
+            return 0;
+        }
+        std::sort(values.begin(), values.end());
+        size_t rank = static_cast<size_t>(fraction * static_cast<double>(values.size()) + 0.999999);
+        return values[std::clamp<size_t>(rank, 1, values.size()) - 1];
+    }
+
+    /**
+     * @brief Reads the number following `"key":` in the JSON written by imapcl, starting at from.
+     */
+    double jsonNumber(const std::string& json, const std::string& key, size_t from = 0) {
+        size_t position = json.find("\"" + key + "\":", from);
+        if (position == std::string::npos) {
+            throw std::runtime_error("Missing " + key + " in the stats of imapcl");
+        }
+        return std::strtod(json.c_str() + position + key.size() + 3, nullptr);
+    }
+
+    /**
+     * @brief Runs imapcl once and waits for it.
+     * @throws std::runtime_error if imapcl fails.
+     */
+    Run runOnce(const Options& options, const Scenario& scenario, const MockIMAPServer& server,
+                const std::filesystem::path& workDir) {
+        std::filesystem::path outDir = workDir / ("out-" + scenario.name);
+        std::filesystem::path statsFile = workDir / "stats.json";
+        std::filesystem::path logFile = workDir / "imapcl.log";
+        std::filesystem::remove_all(outDir);
+
+        std::vector<std::string> arguments = {options.imapcl, "127.0.0.1", "-p",
+                                              std::to_string(scenario.tls ? server.getTlsPort() : server.getPort())};
+        if (scenario.tls) {
+            arguments.insert(arguments.end(), {"-T", "-c", "cert.pem", "-C", workDir.string()});
+        }
+        arguments.insert(arguments.end(), {"-a", (workDir / "auth").string(), "-o", outDir.string(),
+                                           "--stats-json", statsFile.string()});
+        arguments.insert(arguments.end(), scenario.arguments.begin(), scenario.arguments.end());
+
+        std::vector<char*> argv;
+        for (std::string& argument : arguments) {
+            argv.push_back(argument.data());
+        }
+        argv.push_back(nullptr);
+
+        auto start = std::chrono::steady_clock::now();
+        pid_t pid = fork();
+        if (pid == 0) {
+            int devNull = open("/dev/null", O_WRONLY);
+            int log = open(logFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            dup2(devNull, STDOUT_FILENO);
+            dup2(log, STDERR_FILENO);
+            execv(argv[0], argv.data());
+            _exit(127);
+        } else if (pid < 0) {
+            throw std::runtime_error("Failed to start imapcl");
+        }
+
+        int status;
+        struct rusage usage{};
+        if (wait4(pid, &status, 0, &usage) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            throw std::runtime_error("imapcl failed in the " + scenario.name + " scenario, see " + logFile.string());
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::ifstream statsStream(statsFile);
+        std::stringstream stats;
+        stats << statsStream.rdbuf();
+        std::string json = stats.str();
+
+        Run run;
+        run.seconds = elapsed.count();
+        run.peakRssKb = usage.ru_maxrss;
+        run.bytes = jsonNumber(json, "response_bytes");
+        run.messages = jsonNumber(json, "messages_saved");
+        for (const std::string& phase : phases) {
+            size_t position = json.find("\"" + phase + "\":{");
+            run.phaseMs.push_back(position != std::string::npos && jsonNumber(json, "count", position) > 0
+                                  ? jsonNumber(json, "avg_ms", position) : -1);
+        }
+
+        std::filesystem::remove_all(outDir);
+        return run;
+    }
+
+    /**
+     * @brief Prints the results of a scenario and appends them to the JSON array.
+     */
+    void report(const Scenario& scenario, const std::vector<Run>& runs, std::ostream& json) {
+        std::vector<double> wallMs, megabytesPerSecond, messagesPerSecond;
+        long peakRssKb = 0;
+        for (const Run& run : runs) {
+            wallMs.push_back(run.seconds * 1000);
+            megabytesPerSecond.push_back(run.bytes / run.seconds / 1e6);
+            messagesPerSecond.push_back(run.messages / run.seconds);
+            peakRssKb = std::max(peakRssKb, run.peakRssKb);
+        }
+
+        char line[256];
+        std::snprintf(line, sizeof(line), "%s: %zu runs, %.0f messages and %.2f MB per run\n", scenario.name.c_str(),
+                      runs.size(), runs.front().messages, runs.front().bytes / 1e6);
+        std::cout << line;
+        std::snprintf(line, sizeof(line), "  throughput  %.1f MB/s, %.0f messages/s (median)\n",
+                      percentile(megabytesPerSecond, 0.5), percentile(messagesPerSecond, 0.5));
+        std::cout << line;
+        std::snprintf(line, sizeof(line), "  peak RSS    %.1f MiB (max)\n", static_cast<double>(peakRssKb) / 1024);
+        std::cout << line;
+        std::snprintf(line, sizeof(line), "  wall time   p50 %.2f ms, p90 %.2f ms, p99 %.2f ms\n",
+                      percentile(wallMs, 0.5), percentile(wallMs, 0.9), percentile(wallMs, 0.99));
+        std::cout << line << "  phases      p50 / p99 ms:";
+
+        json << "{\"scenario\":\"" << scenario.name << "\",\"runs\":" << runs.size()
+             << ",\"messages\":" << runs.front().messages << ",\"bytes\":" << runs.front().bytes
+             << ",\"mb_per_second\":" << percentile(megabytesPerSecond, 0.5)
+             << ",\"messages_per_second\":" << percentile(messagesPerSecond, 0.5)
+             << ",\"peak_rss_kb\":" << peakRssKb
+             << ",\"wall_ms\":{\"p50\":" << percentile(wallMs, 0.5) << ",\"p90\":" << percentile(wallMs, 0.9)
+             << ",\"p99\":" << percentile(wallMs, 0.99) << "},\"phases\":{";
+
+        bool first = true;
+        for (size_t i = 0; i < phases.size(); ++i) {
+            std::vector<double> samples;
+            for (const Run& run : runs) {
+                if (run.phaseMs[i] >= 0) {
+                    samples.push_back(run.phaseMs[i]);
+                }
+            }
+            if (samples.empty()) {
+                continue;
+            }
+            std::snprintf(line, sizeof(line), " %s %.3f/%.3f", phases[i].c_str(), percentile(samples, 0.5),
+                          percentile(samples, 0.99));
+            std::cout << line;
+            json << (first ? "" : ",") << "\"" << phases[i] << "\":{\"p50\":" << percentile(samples, 0.5)
+                 << ",\"p99\":" << percentile(samples, 0.99) << "}";
+            first = false;
+        }
+        std::cout << "\n" << std::endl;
+        json << "}}";
+    }
+
+    Options parseOptions(int argc, char* argv[]) {
+        static const struct option longOptions[] = {
+                {"imapcl", required_argument, nullptr, 'i'},
+                {"work-dir", required_argument, nullptr, 'd'},
+                {"json", required_argument, nullptr, 'j'},
+                {"scenario", required_argument, nullptr, 'S'},
+                {"iterations", required_argument, nullptr, 'n'},
+                {"warmup", required_argument, nullptr, 'w'},
+                {"mailboxes", required_argument, nullptr, 'b'},
+                {"messages", required_argument, nullptr, 'm'},
+                {"size", required_argument, nullptr, 's'},
+                {"unseen", required_argument, nullptr, 'u'},
+                {"latency", required_argument, nullptr, 'l'},
+                {"no-compress", no_argument, nullptr, 'Z'},
+                {nullptr, 0, nullptr, 0}
+        };
+
+        Options options;
+        options.server.messages = 2000;
+        options.server.messageSize = 20 * 1024;
+
+        int opt;
+        while ((opt = getopt_long(argc, argv, "", longOptions, nullptr)) != -1) {
+            switch (opt) {
+                case 'i': options.imapcl = optarg; break;
+                case 'd': options.workDir = optarg; break;
+                case 'j': options.json = optarg; break;
+                case 'S': options.only.emplace_back(optarg); break;
+                case 'n': options.iterations = std::stoi(optarg); break;
+                case 'w': options.warmup = std::stoi(optarg); break;
+                case 'b': options.server.mailboxes = std::stoi(optarg); break;
+                case 'm': options.server.messages = std::stoi(optarg); break;
+                case 's': options.server.messageSize = std::stoul(optarg); break;
+                case 'u': options.server.unseenPercent = std::stoi(optarg); break;
+                case 'l': options.server.latencyMs = std::stoi(optarg); break;
+                case 'Z': options.server.compress = false; break;
+                default: throw std::invalid_argument("invalid argument");
+            }
+        }
+        if (options.iterations < 1 || options.warmup < 0 || options.server.messages < 1 || options.server.messageSize == 0) {
+            throw std::invalid_argument("iterations, messages and size must be positive");
+        }
+        for (const std::string& name : options.only) {
+            if (std::none_of(scenarios.begin(), scenarios.end(), [&name](const Scenario& s) { return s.name == name; })) {
+                throw std::invalid_argument("unknown scenario: " + name);
+            }
+        }
+        options.imapcl = std::filesystem::absolute(options.imapcl).string();
+        return options;
+    }
+}
+
+/**
+ * @brief Starts the mock server in this process and measures imapcl against it in every scenario.
+ *
+ * imapcl-bench [--imapcl path] [--scenario name]... [--iterations N] [--warmup N] [--messages N]
+ *              [--size bytes] [--mailboxes N] [--unseen percent] [--latency ms] [--no-compress]
+ *              [--work-dir dir] [--json file]
+ */
+int main(int argc, char* argv[]) {
+    std::filesystem::path workDir;
+    bool temporary = false;
+    try {
+        Options options = parseOptions(argc, argv);
+
+        if (options.workDir.empty()) {
+            char pattern[] = "/tmp/imapcl-bench-XXXXXX";
+            if (!mkdtemp(pattern)) {
+                throw std::runtime_error("Failed to create a temporary directory");
+            }
+            workDir = pattern;
+            temporary = true;
+        } else {
+            workDir = options.workDir;
+            std::filesystem::create_directories(workDir);
+        }
+        workDir = std::filesystem::absolute(workDir);
+        std::ofstream(workDir / "auth") << "username = bench password = secret\n";
+
+        options.server.certFile = (workDir / "cert.pem").string();
+        MockIMAPServer server(options.server);
+        server.start();
+
+        char line[256];
+        std::snprintf(line, sizeof(line), "mock server: %d messages of %zu bytes on average, %d%% unseen, compression %s\n\n",
+                      options.server.messages, options.server.messageSize, options.server.unseenPercent,
+                      options.server.compress ? "offered" : "off");
+        std::cout << line;
+
+        std::ostringstream json;
+        json << "[";
+        bool first = true;
+        for (const Scenario& scenario : scenarios) {
+            if (!options.only.empty() && std::find(options.only.begin(), options.only.end(), scenario.name) == options.only.end()) {
+                continue;
+            }
+            for (int i = 0; i < options.warmup; ++i) {
+                runOnce(options, scenario, server, workDir);
+            }
+            std::vector<Run> runs;
+            for (int i = 0; i < options.iterations; ++i) {
+                runs.push_back(runOnce(options, scenario, server, workDir));
+            }
+
+            json << (first ? "" : ",");
+            report(scenario, runs, json);
+            first = false;
+        }
+        json << "]\n";
+
+        server.stop();
+        if (!options.json.empty()) {
+            std::ofstream(options.json) << json.str();
+        }
+        if (temporary) {
+            std::filesystem::remove_all(workDir);
+        }
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
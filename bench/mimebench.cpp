@@ -0,0 +1,591 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#include "MimeDecoder.h"
+#include "HeaderDecoder.h"
+#include "ResponseParser.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <getopt.h>
+#include <pthread.h>
+#include <openssl/bio.h>
+#include <openssl/evp.h>
+
+namespace {
+    /*
+     * The decoders IMAPClient used before MimeDecoder, kept as the baseline.
+     */
+
+    std::string legacyDecodeBase64(const std::string &encoded) {
+        BIO *bio, *b64;
+        char buffer[1024];
+        std::string decoded;
+
+        bio = BIO_new_mem_buf(encoded.data(), encoded.size());
+        b64 = BIO_new(BIO_f_base64());
+        BIO_set_flags(b64, BIO_FLAGS_BASE64_NO_NL);
+        bio = BIO_push(b64, bio);
+
+        int decodedLength;
+        while ((decodedLength = BIO_read(bio, buffer, sizeof(buffer))) > 0) {
+            decoded.append(buffer, decodedLength);
+        }
+        BIO_free_all(bio);
+        return decoded;
+    }
+
+    std::string legacyDecodeQuotedPrintable(const std::string &encoded) {
+        std::ostringstream decoded;
+        for (size_t i = 0; i < encoded.size(); ++i) {
+            if (encoded[i] == '=' && i + 2 < encoded.size()) {
+                std::string hex = encoded.substr(i + 1, 2);
+                char decodedChar = static_cast<char>(std::stoi(hex, nullptr, 16));
+                decoded << decodedChar;
+                i += 2;
+            } else {
+                decoded << encoded[i];
+            }
+        }
+        return decoded.str();
+    }
+
+    /*
+     * The std::regex parsers IMAPClient used before ResponseParser::searchIds() and the subject scanner.
+     */
+
+    std::vector<uint32_t> regexSearchIds(const std::string &searchResponse) {
+        std::vector<uint32_t> ids;
+        std::regex searchRegex(R"(\* SEARCH\s((?:\d+\s*)+))");
+        std::smatch match;
+
+        if (std::regex_search(searchResponse, match, searchRegex) && match.size() > 1) {
+            std::istringstream iss(match[1].str());
+            int id;
+
+            while (iss >> id) {
+                ids.push_back(id);
+            }
+        }
+        return ids;
+    }
+
+    std::string regexExtractSubject(const std::string &headers) {
+        std::regex encodedSubjectRegex(R"(Subject:\s=\?([A-Za-z0-9-]+)\?(B|Q)\?([A-Za-z0-9+/=]+)\?=)", std::regex::icase);
+        std::smatch match;
+
+        // check if the subject is encoded
+        if (std::regex_search(headers, match, encodedSubjectRegex)) {
+            std::string encoding = match[2].str();
+            std::string encodedSubject = match[3].str();
+
+            if (encoding == "B" || encoding == "b") {
+                return legacyDecodeBase64(encodedSubject);
+            }
+            return legacyDecodeQuotedPrintable(encodedSubject);
+        }
+
+        // extract plain text subject if not encoded
+        std::regex plainSubjectRegex(R"(Subject:\s(.+))", std::regex::icase);
+        if (std::regex_search(headers, match, plainSubjectRegex)) {
+            return match[1].str();
+        }
+        return "no_subject";
+    }
+
+    struct Options {
+        size_t size = 16 * 1024 * 1024;     // decoded bytes per input
+        size_t chunk = 16 * 1024;           // chunk size of the streaming runs
+        size_t subjects = 200000;           // header blocks of the subject extraction run
+        size_t searchIds = 500000;          // IDs in the SEARCH response of the search run
+        int iterations = 5;
+        std::string json;                   // results as JSON, empty for none
+    };
+
+    double median(std::vector<double> values) {
+        std::sort(values.begin(), values.end());
+        return values[values.size() / 2];
+    }
+
+    bool legacySplitEncodedWord(std::string_view value, std::string_view &charset,
+                                std::string_view &encoding, std::string_view &text) {
+        auto isCharsetChar = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '-'; };
+        auto isTextChar = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '+' || c == '/' || c == '='; };
+
+        if (value.substr(0, 2) != "=?") {
+            return false;
+        }
+
+        size_t pos = 2;
+        while (pos < value.size() && isCharsetChar(value[pos])) {
+            ++pos;
+        }
+        if (pos == 2 || pos + 3 > value.size() || value[pos] != '?' || value[pos + 2] != '?' ||
+            std::string_view("BbQq").find(value[pos + 1]) == std::string_view::npos) {
+            return false;
+        }
+        charset = value.substr(2, pos - 2);
+        encoding = value.substr(pos + 1, 1);
+
+        size_t textStart = pos + 3;
+        size_t textEnd = value.find("?=", textStart);
+        if (textEnd == std::string_view::npos || textEnd == textStart) {
+            return false;
+        }
+        text = value.substr(textStart, textEnd - textStart);
+        return std::all_of(text.begin(), text.end(), isTextChar);
+    }
+
+    /**
+     * @brief The subject extraction IMAPClient used before HeaderDecoder: one encoded word, no charsets.
+     */
+    std::string legacyExtractSubject(const std::string &headers) {
+        static constexpr std::string_view name = "subject:";
+        std::string_view view(headers);
+        size_t lineStart = 0;
+
+        while (lineStart < view.size()) {
+            size_t lineEnd = view.find_first_of("\r\n", lineStart);
+            if (lineEnd == std::string_view::npos) {
+                lineEnd = view.size();
+            }
+            std::string_view line = view.substr(lineStart, lineEnd - lineStart);
+
+            if (line.size() > name.size() + 1 && std::isspace(static_cast<unsigned char>(line[name.size()])) &&
+                std::equal(name.begin(), name.end(), line.begin(),
+                           [](char a, char b) { return a == std::tolower(static_cast<unsigned char>(b)); })) {
+                std::string_view value = line.substr(name.size() + 1);
+                std::string_view charset, encoding, text;
+                if (legacySplitEncodedWord(value, charset, encoding, text)) {
+                    if (encoding == "B" || encoding == "b") {
+                        return Base64Decoder::decode(text);
+                    }
+                    return QuotedPrintableDecoder::decode(text);
+                }
+                return std::string(value);
+            }
+
+            lineStart = view.find_first_not_of("\r\n", lineEnd);
+        }
+        return "no_subject";
+    }
+
+    std::string newExtractSubject(const std::string &headers) {
+        std::string_view value;
+        if (!HeaderDecoder::findField(headers, "Subject", value)) {
+            return "no_subject";
+        }
+        return HeaderDecoder::decode(value);
+    }
+
+    /**
+     * @brief Header blocks of typical messages, a quarter each with a plain, a base64 UTF-8, a Q
+     *        ISO-8859-2 and a folded subject of two encoded words.
+     */
+    std::vector<std::string> headerBlocks(size_t count) {
+        static const std::string subjects[] = {
+                "Subject: Re: Quarterly report for the mailbox\r\n",
+                "Subject: =?UTF-8?B?WnByw6F2YSDEjS4gMSBvIHN5bmNocm9uaXphY2k=?=\r\n",
+                "Subject: =?ISO-8859-2?Q?Zpr=E1va_=E8=2E_2_o_synchronizaci?=\r\n",
+                "Subject: =?UTF-8?Q?P=C5=99=C3=ADli=C5=A1_?=\r\n =?UTF-8?Q?=C5=BElu=C5=A5ou=C4=8Dk=C3=BD_k=C5=AF=C5=88?=\r\n",
+        };
+        std::vector<std::string> blocks;
+        for (size_t i = 0; i < count; ++i) {
+            blocks.push_back("Return-Path: <sender@example.com>\r\n"
+                             "Received: from mail.example.com by imap.example.com; Mon, 1 Jan 2024 07:00:00 +0000\r\n"
+                             "Date: Mon, 1 Jan 2024 07:00:00 +0000\r\n"
+                             "From: Sender <sender@example.com>\r\n"
+                             "To: Receiver <receiver@example.com>\r\n"
+                             "Message-ID: <" + std::to_string(i) + "@example.com>\r\n" +
+                             subjects[i % std::size(subjects)] +
+                             "MIME-Version: 1.0\r\n"
+                             "Content-Type: text/plain; charset=UTF-8\r\n\r\n");
+        }
+        return blocks;
+    }
+
+    /**
+     * @brief Extracts the subject of every header block and returns the median MB/s of headers.
+     */
+    double measureSubjects(const std::vector<std::string>& blocks, const Options& options,
+                           const std::function<std::string(const std::string&)>& extract) {
+        size_t bytes = 0;
+        for (const auto& block : blocks) {
+            bytes += block.size();
+        }
+        std::vector<double> throughput;
+        size_t checksum = 0;
+        for (int i = 0; i < options.iterations; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            for (const auto& block : blocks) {
+                checksum += extract(block).size();
+            }
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            throughput.push_back(static_cast<double>(bytes) / 1e6 / elapsed.count());
+        }
+        if (checksum == 0) {
+            throw std::runtime_error("no subjects extracted");
+        }
+        return median(throughput);
+    }
+
+    /**
+     * @brief Builds the answer to `SEARCH ALL` on a mailbox holding `count` messages.
+     */
+    std::string searchResponse(size_t count) {
+        std::string response = "* SEARCH";
+        for (size_t id = 1; id <= count; ++id) {
+            response += ' ';
+            response += std::to_string(id);
+        }
+        response += "\r\nA5 OK SEARCH completed\r\n";
+        return response;
+    }
+
+    /**
+     * @brief Parses the SEARCH response `iterations` times and returns the median MB/s of response.
+     */
+    double measureSearch(const std::string& response, size_t count, const Options& options,
+                         const std::function<std::vector<uint32_t>(const std::string&)>& parse) {
+        std::vector<double> throughput;
+        for (int i = 0; i < options.iterations; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            std::vector<uint32_t> ids = parse(response);
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            if (ids.size() != count || (count && ids.back() != count)) {
+                throw std::runtime_error("wrong output parsing the SEARCH response");
+            }
+            throughput.push_back(static_cast<double>(response.size()) / 1e6 / elapsed.count());
+        }
+        return median(throughput);
+    }
+
+    /**
+     * @brief Runs the function on a thread with a stack of the given size and rethrows its exception.
+     *
+     * std::regex matches a repeated group recursively, a few KiB of stack per SEARCH ID.
+     */
+    void runWithStack(size_t stackSize, const std::function<void()>& function) {
+        struct Call {
+            const std::function<void()>* function;
+            std::exception_ptr error;
+        } call{&function, nullptr};
+
+        pthread_attr_t attributes;
+        pthread_attr_init(&attributes);
+        pthread_attr_setstacksize(&attributes, stackSize);
+        pthread_t thread;
+        int result = pthread_create(&thread, &attributes, [](void* argument) -> void* {
+            auto* call = static_cast<Call*>(argument);
+            try {
+                (*call->function)();
+            } catch (...) {
+                call->error = std::current_exception();
+            }
+            return nullptr;
+        }, &call);
+        pthread_attr_destroy(&attributes);
+        if (result != 0) {
+            throw std::runtime_error("cannot start a thread with a " + std::to_string(stackSize >> 20) + " MiB stack");
+        }
+        pthread_join(thread, nullptr);
+        if (call.error) {
+            std::rethrow_exception(call.error);
+        }
+    }
+
+    /**
+     * @brief One encoded input and the bytes it decodes to.
+     */
+    struct Input {
+        std::string name;
+        std::string encoded;
+        std::string decoded;
+        bool quotedPrintable;
+        bool legacy;        // the legacy decoder handles it (no line breaks in base64, no soft breaks in QP)
+    };
+
+    std::string randomBytes(size_t size, std::mt19937& random) {
+        std::string bytes(size, '\0');
+        for (auto& byte : bytes) {
+            byte = static_cast<char>(random());
+        }
+        return bytes;
+    }
+
+    /**
+     * @brief Mostly ASCII text with some Latin-2 letters, as in QP encoded bodies.
+     */
+    std::string randomText(size_t size, std::mt19937& random) {
+        static const std::string words[] = {"the", "mailbox", "message", "server", "fetch", "body", "p\xF8\xEDli\xB9",
+                                            "\xBEluou\xE8k\xFD", "k\xF9\xF2", "IMAP", "with", "and", "=", "50%"};
+        std::string text;
+        size_t lineLength = 0;
+        while (text.size() < size) {
+            const std::string& word = words[random() % std::size(words)];
+            text += word;
+            lineLength += word.size();
+            if (lineLength > 60) {
+                text += "\r\n";
+                lineLength = 0;
+            } else {
+                text += ' ';
+                ++lineLength;
+            }
+        }
+        // the legacy decoder copies an escape at the very end as it is
+        text.resize(size);
+        text.back() = '.';
+        return text;
+    }
+
+    /**
+     * @brief Encodes base64, in lines of 76 characters with CRLF or as one line.
+     */
+    std::string encodeBase64(const std::string& data, bool lines) {
+        std::string encoded;
+        size_t step = lines ? 57 : data.size();
+        std::vector<unsigned char> line(4 * ((step + 2) / 3) + 1);
+        for (size_t i = 0; i < data.size(); i += step) {
+            size_t length = std::min(step, data.size() - i);
+            int written = EVP_EncodeBlock(line.data(), reinterpret_cast<const unsigned char*>(data.data() + i),
+                                          static_cast<int>(length));
+            encoded.append(reinterpret_cast<const char*>(line.data()), written);
+            if (lines) {
+                encoded += "\r\n";
+            }
+        }
+        return encoded;
+    }
+
+    /**
+     * @brief Encodes quoted-printable, keeping CRLF line breaks and optionally adding soft ones.
+     */
+    std::string encodeQuotedPrintable(const std::string& text, bool softBreaks) {
+        static const char hex[] = "0123456789ABCDEF";
+        std::string encoded;
+        size_t lineLength = 0;
+        for (size_t i = 0; i < text.size(); ++i) {
+            auto c = static_cast<unsigned char>(text[i]);
+            if (c == '\r' && i + 1 < text.size() && text[i + 1] == '\n') {
+                encoded += "\r\n";
+                ++i;
+                lineLength = 0;
+                continue;
+            }
+            bool trailingSpace = (c == ' ' || c == '\t') &&
+                                 (i + 1 == text.size() || text[i + 1] == '\r');
+            std::string piece;
+            if (c == '=' || c >= 127 || (c < 32 && c != '\t') || trailingSpace) {
+                piece = {'=', hex[c >> 4], hex[c & 15]};
+            } else {
+                piece = std::string(1, static_cast<char>(c));
+            }
+            if (softBreaks && lineLength + piece.size() > 75) {
+                encoded += "=\r\n";
+                lineLength = 0;
+            }
+            encoded += piece;
+            lineLength += piece.size();
+        }
+        return encoded;
+    }
+
+    /**
+     * @brief Runs the decoder `iterations` times and returns the median throughput in MB/s of input.
+     */
+    double measure(const Input& input, const Options& options, const std::function<std::string()>& decode) {
+        std::vector<double> throughput;
+        for (int i = 0; i < options.iterations; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            std::string decoded = decode();
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            if (decoded != input.decoded) {
+                throw std::runtime_error("wrong output decoding " + input.name);
+            }
+            throughput.push_back(static_cast<double>(input.encoded.size()) / 1e6 / elapsed.count());
+        }
+        return median(throughput);
+    }
+
+    /**
+     * @brief Decodes the input in chunks of the given size, as when streaming a FETCH literal.
+     */
+    std::string decodeChunked(const Input& input, size_t chunk) {
+        std::string decoded;
+        decoded.reserve(input.decoded.size());
+        if (input.quotedPrintable) {
+            QuotedPrintableDecoder decoder;
+            for (size_t i = 0; i < input.encoded.size(); i += chunk) {
+                decoder.update(std::string_view(input.encoded).substr(i, chunk), decoded);
+            }
+            decoder.finish(decoded);
+        } else {
+            Base64Decoder decoder;
+            for (size_t i = 0; i < input.encoded.size(); i += chunk) {
+                decoder.update(std::string_view(input.encoded).substr(i, chunk), decoded);
+            }
+            decoder.finish(decoded);
+        }
+        return decoded;
+    }
+
+    /**
+     * @brief Checks every level on inputs split at random points, before anything is timed.
+     */
+    void verify(const std::vector<Input>& inputs, std::mt19937& random) {
+        for (const auto& input : inputs) {
+            for (SimdLevel level : {SimdLevel::SCALAR, SimdLevel::SSE4, SimdLevel::AVX2}) {
+                MimeDecoder::setLevel(level);
+                for (int split = 0; split < 20; ++split) {
+                    size_t chunk = split == 0 ? input.encoded.size() : 1 + random() % 200;
+                    if (decodeChunked(input, chunk) != input.decoded) {
+                        throw std::runtime_error(std::string("wrong output decoding ") + input.name + " with " +
+                                                 MimeDecoder::levelName(MimeDecoder::level()) + " in chunks of " +
+                                                 std::to_string(chunk) + " bytes");
+                    }
+                }
+            }
+        }
+        MimeDecoder::setLevel(SimdLevel::AVX2);
+    }
+}
+
+/**
+ * @brief Compares the MIME decoders with the OpenSSL BIO and stoi based ones they replaced,
+ *        the RFC 2047 subject decoding with the single encoded word and std::regex ones it replaced,
+ *        and the SEARCH response scanner with the std::regex parser it replaced.
+ *
+ * imapcl-mime-bench [--size MiB] [--chunk bytes] [--subjects N] [--search-ids N] [--iterations N] [--json file]
+ */
+int main(int argc, char* argv[]) {
+    static const struct option longOptions[] = {
+            {"size", required_argument, nullptr, 's'},
+            {"chunk", required_argument, nullptr, 'c'},
+            {"subjects", required_argument, nullptr, 'h'},
+            {"search-ids", required_argument, nullptr, 'n'},
+            {"iterations", required_argument, nullptr, 'i'},
+            {"json", required_argument, nullptr, 'j'},
+            {nullptr, 0, nullptr, 0}
+    };
+
+    try {
+        Options options;
+        int opt;
+        while ((opt = getopt_long(argc, argv, "", longOptions, nullptr)) != -1) {
+            switch (opt) {
+                case 's': options.size = std::stoul(optarg) * 1024 * 1024; break;
+                case 'c': options.chunk = std::stoul(optarg); break;
+                case 'h': options.subjects = std::stoul(optarg); break;
+                case 'n': options.searchIds = std::stoul(optarg); break;
+                case 'i': options.iterations = std::stoi(optarg); break;
+                case 'j': options.json = optarg; break;
+                default: throw std::invalid_argument("invalid argument");
+            }
+        }
+        if (options.size == 0 || options.chunk == 0 || options.subjects == 0 || options.searchIds == 0 ||
+            options.iterations < 1) {
+            throw std::invalid_argument("size, chunk, subjects, search-ids and iterations must be positive");
+        }
+
+        std::mt19937 random(2047);
+        std::string binary = randomBytes(options.size, random);
+        std::string text = randomText(options.size, random);
+        std::vector<Input> inputs = {
+                {"base64-lines", encodeBase64(binary, true), binary, false, false},
+                {"base64-single-line", encodeBase64(binary, false), binary, false, true},
+                {"qp-soft-breaks", encodeQuotedPrintable(text, true), text, true, false},
+                {"qp-hard-breaks", encodeQuotedPrintable(text, false), text, true, true},
+        };
+        verify(inputs, random);
+
+        std::cout << "supported: " << MimeDecoder::levelName(MimeDecoder::supportedLevel())
+                  << ", MB/s of encoded input (median of " << options.iterations << ")\n";
+        std::ostringstream json;
+        json << "[";
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            const Input& input = inputs[i];
+            std::cout << "\n" << input.name << ": " << input.encoded.size() / 1024 << " KiB\n";
+            json << (i ? "," : "") << "{\"input\":\"" << input.name << "\",\"encoded_bytes\":" << input.encoded.size();
+
+            auto print = [&](const std::string& name, double mbPerSecond) {
+                std::cout << "  " << name << std::string(name.size() < 16 ? 16 - name.size() : 1, ' ')
+                          << mbPerSecond << " MB/s\n";
+                json << ",\"" << name << "\":" << mbPerSecond;
+            };
+
+            if (input.legacy) {
+                print("legacy", measure(input, options, [&]() {
+                    return input.quotedPrintable ? legacyDecodeQuotedPrintable(input.encoded)
+                                                 : legacyDecodeBase64(input.encoded);
+                }));
+            }
+            for (SimdLevel level : {SimdLevel::SCALAR, SimdLevel::SSE4, SimdLevel::AVX2}) {
+                if (level > MimeDecoder::supportedLevel()) {
+                    continue;
+                }
+                MimeDecoder::setLevel(level);
+                std::string name = MimeDecoder::levelName(level);
+                print(name, measure(input, options, [&]() {
+                    return input.quotedPrintable ? QuotedPrintableDecoder::decode(input.encoded)
+                                                 : Base64Decoder::decode(input.encoded);
+                }));
+                print(name + "-chunked", measure(input, options, [&]() {
+                    return decodeChunked(input, options.chunk);
+                }));
+            }
+            json << "}";
+        }
+
+        std::vector<std::string> blocks = headerBlocks(options.subjects);
+        std::cout << "\nsubjects: " << blocks.size() << " header blocks\n";
+        json << ",{\"input\":\"subjects\",\"headers\":" << blocks.size();
+        // the regexes are compiled per message, a part of the blocks is enough for their throughput
+        std::vector<std::string> regexBlocks(blocks.begin(), blocks.begin() + std::min<size_t>(blocks.size(), 20000));
+        double regex = measureSubjects(regexBlocks, options, regexExtractSubject);
+        double legacy = measureSubjects(blocks, options, legacyExtractSubject);
+        double decoder = measureSubjects(blocks, options, newExtractSubject);
+        std::cout << "  regex           " << regex << " MB/s\n"
+                  << "  legacy          " << legacy << " MB/s\n"
+                  << "  header-decoder  " << decoder << " MB/s\n";
+        json << ",\"regex\":" << regex << ",\"legacy\":" << legacy << ",\"header-decoder\":" << decoder << "}";
+
+        std::string response = searchResponse(options.searchIds);
+        std::cout << "\nsearch: " << options.searchIds << " IDs, " << response.size() / 1024 << " KiB\n";
+        json << ",{\"input\":\"search\",\"ids\":" << options.searchIds;
+        double regexSearch = 0;
+        runWithStack(64 * 1024 * 1024 + options.searchIds * 4096, [&]() {
+            regexSearch = measureSearch(response, options.searchIds, options, regexSearchIds);
+        });
+        double scanner = measureSearch(response, options.searchIds, options, [](const std::string& response) {
+            std::vector<uint32_t> ids;
+            ResponseParser::searchIds(response, ids);
+            return ids;
+        });
+        std::cout << "  regex           " << regexSearch << " MB/s\n"
+                  << "  scanner         " << scanner << " MB/s\n";
+        json << ",\"regex\":" << regexSearch << ",\"scanner\":" << scanner;
+        json << "}]\n";
+
+        if (!options.json.empty()) {
+            std::ofstream(options.json) << json.str();
+        }
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
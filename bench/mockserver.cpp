@@ -0,0 +1,83 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#include "MockIMAPServer.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <csignal>
+#include <getopt.h>
+
+/**
+ * @brief Runs the mock IMAP server until SIGINT or SIGTERM.
+ *
+ * imapcl-mock-server [--port N] [--tls-port N] [--cert file] [--mailboxes N] [--messages N]
+ *                    [--size bytes] [--unseen percent] [--latency ms] [--drop-after bytes] [--no-compress]
+ */
+int main(int argc, char* argv[]) {
+    static const struct option longOptions[] = {
+            {"address", required_argument, nullptr, 'A'},
+            {"port", required_argument, nullptr, 'p'},
+            {"tls-port", required_argument, nullptr, 't'},
+            {"cert", required_argument, nullptr, 'c'},
+            {"mailboxes", required_argument, nullptr, 'b'},
+            {"messages", required_argument, nullptr, 'm'},
+            {"size", required_argument, nullptr, 's'},
+            {"unseen", required_argument, nullptr, 'u'},
+            {"latency", required_argument, nullptr, 'l'},
+            {"drop-after", required_argument, nullptr, 'd'},
+            {"no-compress", no_argument, nullptr, 'Z'},
+            {nullptr, 0, nullptr, 0}
+    };
+
+    try {
+        MockIMAPServer::Config config;
+        config.port = 1143;
+        config.tlsPort = 1993;
+
+        int opt;
+        while ((opt = getopt_long(argc, argv, "", longOptions, nullptr)) != -1) {
+            switch (opt) {
+                case 'A': config.address = optarg; break;
+                case 'p': config.port = std::stoi(optarg); break;
+                case 't': config.tlsPort = std::stoi(optarg); break;
+                case 'c': config.certFile = optarg; break;
+                case 'b': config.mailboxes = std::stoi(optarg); break;
+                case 'm': config.messages = std::stoi(optarg); break;
+                case 's': config.messageSize = std::stoul(optarg); break;
+                case 'u': config.unseenPercent = std::stoi(optarg); break;
+                case 'l': config.latencyMs = std::stoi(optarg); break;
+                case 'd': config.dropAfter = std::stoul(optarg); break;
+                case 'Z': config.compress = false; break;
+                default: throw std::invalid_argument("invalid argument");
+            }
+        }
+        if (config.mailboxes < 1 || config.messages < 0 || config.messageSize == 0) {
+            throw std::invalid_argument("mailboxes, messages and size must be positive");
+        }
+
+        // the signals are taken by sigwait() below, not delivered to any thread
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+        MockIMAPServer server(config);
+        server.start();
+        std::cout << "Serving " << config.mailboxes << " mailbox(es) of " << config.messages << " messages on "
+                  << config.address << ", plain port " << server.getPort() << ", TLS port " << server.getTlsPort()
+                  << std::endl;
+
+        int signal;
+        sigwait(&signals, &signal);
+        server.stop();
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
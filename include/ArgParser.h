@@ -6,6 +6,10 @@
 #define IMAP_TLS_CLIENT_ARGPARSER_H
 
 #include <string>
+#include <vector>
+#include <utility>
+#include <ctime>
+#include <cstddef>
 
 /**
  * @brief The ArgParser class is responsible for parsing command-line arguments
@@ -19,7 +23,7 @@ public:
      */
     struct Config{
         std::string server;
-        int port = useSSL ? 993 : 143; // imap default port
+        int port = 143;             // imap default port, parse() picks 993 with TLS unless -p is given
         bool useSSL = false;
         std::string cert;
         std::string certDir = "/etc/ssl/certs";
@@ -27,15 +31,52 @@ public:
         bool onlyHeaders = false;
         std::string authFile;
         std::string mailbox = "INBOX";
+        std::vector<std::string> mailboxes;   // all mailboxes given by -b
+        bool allMailboxes = false;  // sync every mailbox returned by LIST
+        int workers = 4;            // parallel connections when syncing several mailboxes
+        int connections = 1;        // parallel connections downloading one mailbox
+        int eventLoops = 0;         // epoll threads driving the mailbox connections, 0 uses a thread per connection
         std::string outDir;
+        std::string format = "files";   // files, mbox, maildir or pack
         std::string username;
         std::string password;
+        int pipelineWindow = 16;    // FETCH commands kept in flight
+        int writers = 0;            // threads writing messages to disk, 0 writes on the receiving thread
+        size_t writeBuffer = 64;    // MB of messages queued for the writer threads
+        std::string tlsSessionCache;    // file persisting TLS sessions between runs
+        bool compress = true;       // use COMPRESS=DEFLATE when the server supports it
+        bool verbose = false;       // report connection details on stderr
+        std::string jobsFile;       // run the jobs of this file instead of a single sync
+        int jobWorkers = 4;         // jobs of the jobs file run at the same time
+        bool stats = false;         // print the timing and traffic summary on stderr at exit
+        std::string statsJson;      // write the same stats as JSON to this file, "-" for stdout
+        size_t maxSize = 0;         // download only messages up to this many bytes, 0 for any size
+        std::time_t receivedAfter = 0;  // download only messages received at or after this time, 0 for any
+        std::time_t receivedBefore = 0; // download only messages received before this time, 0 for any
+        std::string sender;         // download only messages whose From contains this text
+        std::string uidSet;         // server-side: only UIDs of this sequence set
+        std::time_t since = 0;      // server-side: only messages received on or after this day, 0 for any
+        std::time_t before = 0;     // server-side: only messages received before this day, 0 for any
+        size_t larger = 0;          // server-side: only messages larger than this, 0 for any
+        size_t smaller = 0;         // server-side: only messages smaller than this, 0 for any
+        std::vector<std::string> fromAddresses;     // server-side: From contains any of these
+        std::vector<std::pair<std::string, std::string>> headers;  // server-side: header field contains text
+        size_t chunkSize = 0;       // download messages larger than this in resumable chunks of this size, 0 never
+        std::vector<std::string> processOptions;    // process-wide options given, e.g. --writers; rejected on job lines
     };
 
     Config parse(int argc, char* argv[]);
 
 private:
     std::pair<std::string, std::string> readAuthFile(const std::string& authFilePath);
+
+    static bool expectsValue(const char* arg);
+
+    static size_t parseSize(const std::string& text);
+
+    static std::time_t parseDate(const std::string& text);
+
+    static std::time_t parseDay(const std::string& text);
 };
 
 #endif //IMAP_TLS_CLIENT_ARGPARSER_H
@@ -0,0 +1,146 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#ifndef IMAP_TLS_CLIENT_ASYNCIMAPCLIENT_H
+#define IMAP_TLS_CLIENT_ASYNCIMAPCLIENT_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include "ArgParser.h"
+#include "IMAPCommand.h"
+#include "IMAPResponceType.h"
+#include "ConnectionStrategy.h"
+#include "Executor.h"
+#include "Task.h"
+#include "MessageWriter.h"
+#include "MessageSet.h"
+#include "MessageTable.h"
+#include "MessageSink.h"
+#include "SyncState.h"
+#include "WriterPool.h"
+
+/**
+ * @brief Awaitable variant of IMAPClient, for running many sessions on one Executor thread.
+ *
+ * Every command is a coroutine, e.g. `co_await client.fetch("1:100")`. While a response is
+ * incomplete the coroutine waits for its socket through the executor instead of blocking, so
+ * other sessions run in the meantime. The connection is the same ConnectionStrategy as used by
+ * IMAPClient, in non-blocking mode, including TLS and COMPRESS=DEFLATE; fetched messages are
+ * saved with the same MessageWriter, sync state and output formats.
+ *
+ * The TCP connect and the TLS handshake in connect() are still blocking.
+ *
+ * Usage (a named coroutine function rather than a capturing lambda; GCC 12 miscompiles
+ * `co_await` directly inside an `if` condition, so the result is stored first):
+ * @code
+ * Task<> syncMailbox(AsyncIMAPClient& client) {
+ *     co_await client.connect();
+ *     co_await client.login();
+ *     co_await client.select();
+ *     bool found = co_await client.search();
+ *     if (found) {
+ *         co_await client.fetch();
+ *     }
+ *     client.commitSync();
+ *     co_await client.logout();
+ * }
+ * executor.spawn(syncMailbox(client));
+ * executor.run();
+ * @endcode
+ */
+class AsyncIMAPClient {
+public:
+    AsyncIMAPClient(ArgParser::Config config, Executor& executor);
+
+    /**
+     * @brief Connects to the server and reads the greeting.
+     * @throws std::runtime_error if the connection fails.
+     */
+    Task<> connect();
+
+    /**
+     * @brief Authenticates and enables COMPRESS=DEFLATE if the server supports it, like IMAPClient::login().
+     */
+    Task<> login();
+
+    Task<> select();
+
+    /**
+     * @brief Searches for the messages not synced yet, like IMAPClient::search(), including the
+     *        metadata filter of `--max-size`, `--received-after`, `--received-before` and `--sender`.
+     * @return True if there are messages to fetch.
+     */
+    Task<bool> search();
+
+    /**
+     * @brief Fetches the messages found by search(), keeping `pipelineWindow` FETCH commands in flight.
+     */
+    Task<> fetch();
+
+    /**
+     * @brief Fetches the messages of one UID sequence set; after search() only the found UIDs are saved.
+     * @param sequenceSet The UIDs to fetch, e.g. `3:17,20`.
+     */
+    Task<> fetch(std::string sequenceSet);
+
+    /**
+     * @brief Closes the sink and saves the sync state, like IMAPClient::commitSync().
+     */
+    void commitSync();
+
+    Task<> logout();
+
+    void setWriterPool(std::shared_ptr<WriterPool> pool);
+
+    [[nodiscard]] const std::vector<uint32_t>& getIds() const;
+
+    [[nodiscard]] const MessageTable& getMetadata() const;
+
+    [[nodiscard]] int getSavedCount() const;
+
+private:
+    ArgParser::Config config;   ///< config with cli parameters
+    Executor& executor;         ///< resumes the client when its socket is ready
+    int currTagNum = 1;         ///< current number used in tag
+    std::string currTag;        ///< last generated tag
+    std::atomic<int> messageSaved{0};   ///< the amount of saved messages, counted by the writer threads too
+    std::vector<uint32_t> ids;  ///< UIDs of messages got by SEARCH command
+    MessageSet wanted;          ///< the same UIDs for fast lookups while fetching
+    MessageTable metadata;      ///< size, arrival time and envelope of the found messages, only with a filter
+    bool searched = false;      ///< search() ran, so only the found UIDs are saved
+    uint32_t uidValidity = 0;   ///< UIDVALIDITY of the selected mailbox
+    uint32_t uidNext = 0;       ///< UIDNEXT of the selected mailbox, 0 if not reported
+    bool literalPlus = false;   ///< the server accepts non-synchronizing literals (LITERAL+)
+    std::shared_ptr<SyncState> state; ///< state of the previous syncs of the mailbox
+    std::shared_ptr<MessageSink> sink; ///< mbox, maildir or pack output, nullptr for one file per message
+    std::unique_ptr<ConnectionStrategy> strategy; ///< strategy for TCP or SSL connection
+    MessageWriter writer;       ///< streams fetched messages into the output directory
+
+    std::string sendCommand(const IMAPCommand& command);
+
+    Task<> sendLiterals(const IMAPCommand& command);
+
+    Task<std::string_view> readLine();
+
+    Task<> readLiteral(size_t size, const std::function<void(const char*, size_t)>& sink);
+
+    Task<std::string> readUntil(const std::function<IMAPResponseType(std::string_view)>& completion, bool saveMessages);
+
+    Task<std::string> readWholeResponse(bool greeting = false);
+
+    Task<> filterByMetadata();
+
+    Task<> fetchPipelined(const std::vector<std::string>& sequenceSets);
+
+    Task<> saveLiteral(const std::string& line, size_t size, std::string& rest);
+
+    Task<> compress(std::string capabilities);
+};
+
+#endif //IMAP_TLS_CLIENT_ASYNCIMAPCLIENT_H
@@ -0,0 +1,172 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#ifndef IMAP_TLS_CLIENT_ASYNCSESSION_H
+#define IMAP_TLS_CLIENT_ASYNCSESSION_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <chrono>
+#include <sys/socket.h>
+#include <openssl/ssl.h>
+#include "ArgParser.h"
+#include "IMAPCommand.h"
+#include "MessageWriter.h"
+#include "MessageSet.h"
+#include "MessageTable.h"
+#include "SyncState.h"
+#include "WriterPool.h"
+
+/**
+ * @brief Syncs one mailbox over a non-blocking connection driven by an EventLoop.
+ *
+ * The session is a state machine going through connect, TLS handshake, greeting, LOGIN,
+ * SELECT, UID SEARCH, UID FETCH and LOGOUT. Every time the socket becomes readable or
+ * writable, handle() sends what is queued, receives what is available (TLS reads and
+ * writes that want the other direction are retried on the next event) and parses all
+ * complete response lines and literals. It never blocks, except for the name lookup in
+ * start() and, when the writer pool is full, for handing over messages.
+ *
+ * The result is the same as IMAPClient's connect/login/select/search/fetch/commitSync/logout
+ * sequence: the same files, sync state and output formats. COMPRESS=DEFLATE is not used.
+ */
+class AsyncSession {
+public:
+    AsyncSession(ArgParser::Config config, std::shared_ptr<WriterPool> writerPool);
+
+    ~AsyncSession();
+
+    AsyncSession(const AsyncSession&) = delete;
+    AsyncSession& operator=(const AsyncSession&) = delete;
+
+    /**
+     * @brief Resolves the server and starts connecting; the session may be finished right away on failure.
+     */
+    void start();
+
+    /**
+     * @brief Advances the session after epoll reported events on its socket.
+     * @param events The epoll events.
+     */
+    void handle(uint32_t events);
+
+    [[nodiscard]] int getFd() const;
+
+    /**
+     * @brief Returns the epoll events the session waits for.
+     */
+    [[nodiscard]] uint32_t getInterest() const;
+
+    [[nodiscard]] bool isFinished() const;
+
+    [[nodiscard]] bool hasFailed() const;
+
+private:
+    enum class Phase {
+        CONNECTING,
+        HANDSHAKING,
+        GREETING,
+        LOGGING_IN,
+        SELECTING,
+        SEARCHING,
+        FILTERING,
+        FETCHING,
+        LOGGING_OUT,
+        DONE
+    };
+
+    static constexpr size_t readChunk = 256 * 1024;     ///< bytes received per read call
+    static constexpr size_t maxUnparsed = 1024 * 1024;  ///< received bytes parsed before reading more
+
+    ArgParser::Config config;               ///< config with cli parameters
+    Phase phase = Phase::CONNECTING;           ///< current step of the session
+    std::chrono::steady_clock::time_point phaseStarted; ///< start of the current phase, set only with stats enabled
+    bool failed = false;                    ///< the session ended with an error
+    int sockfd = -1;                        ///< non-blocking socket
+    SSL* ssl = nullptr;                     ///< TLS connection, nullptr for plain TCP
+    bool sslWantsWrite = false;             ///< the last TLS call waits for the socket to become writable
+    bool serverClosed = false;              ///< the server closed the connection, the buffered input is still to be parsed
+    std::vector<sockaddr_storage> addresses; ///< resolved server addresses
+    std::vector<socklen_t> addressLengths;  ///< lengths of the addresses
+    size_t nextAddress = 0;                 ///< address tried next if connecting fails
+
+    std::string output;                     ///< commands not sent yet
+    std::deque<std::string> continuation;   ///< parts of the last command sent after the server's continuation request
+    std::vector<char> input;                ///< receive buffer
+    size_t inputHead = 0;                   ///< first unparsed byte of input
+    size_t inputTail = 0;                   ///< end of received data
+    std::string response;                   ///< untagged lines of the running SELECT, SEARCH or metadata FETCH
+    int tagNumber = 1;                      ///< number of the next tag
+    std::string tag;                        ///< tag of the last sent command
+    std::deque<std::string> inFlight;       ///< tags of the outstanding FETCH commands
+    std::vector<std::string> sequenceSets;  ///< FETCH sequence sets
+    size_t nextSet = 0;                     ///< first sequence set not sent yet
+
+    bool inLiteral = false;                 ///< the next bytes belong to a literal
+    size_t literalLeft = 0;                 ///< bytes of the current literal not received yet
+    bool afterLiteral = false;              ///< the next line continues the response after a literal
+    bool writingLiteral = false;            ///< the current literal is a message being saved
+    bool uidKnown = false;                  ///< the UID of the message was sent before its literal
+    uint32_t messageId = 0;                 ///< UID of the message being saved
+
+    uint32_t uidValidity = 0;               ///< UIDVALIDITY of the mailbox
+    uint32_t uidNext = 0;                   ///< UIDNEXT of the mailbox, 0 if not reported
+    bool fetched = false;                   ///< SEARCH found messages to fetch
+    std::vector<uint32_t> ids;              ///< UIDs to fetch
+    MessageSet wanted;                      ///< the same UIDs for fast lookups
+    MessageTable metadata;                  ///< metadata of the found messages, only with a filter
+    std::shared_ptr<SyncState> state;       ///< state of the previous syncs of the mailbox
+    std::shared_ptr<MessageSink> sink;      ///< mbox, maildir or pack output, nullptr for files
+    std::atomic<int> saved{0};              ///< messages saved, counted by writer threads too
+    MessageWriter writer;                   ///< saves the fetched messages
+
+    void enter(Phase next);
+
+    void connectNext();
+
+    void finishConnect();
+
+    bool handshake();
+
+    void send(const IMAPCommand& command);
+
+    void flush();
+
+    void receive();
+
+    void parse();
+
+    void handleLine(std::string_view line);
+
+    void completed();
+
+    void beginLiteral(std::string_view line, size_t size);
+
+    void finishLiteral(std::string_view rest);
+
+    void selected();
+
+    void searched();
+
+    void sendMetadataFetch();
+
+    void filtered();
+
+    void startFetching();
+
+    void sendFetches();
+
+    void finishSync();
+
+    void fail(const std::string& message);
+
+    void closeConnection();
+};
+
+#endif //IMAP_TLS_CLIENT_ASYNCSESSION_H
@@ -0,0 +1,23 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#ifndef IMAP_TLS_CLIENT_CAPABILITYCOMMAND_H
+#define IMAP_TLS_CLIENT_CAPABILITYCOMMAND_H
+
+#include "IMAPCommand.h"
+#include <string>
+
+/**
+ * @brief Represents the IMAP CAPABILITY command listing the extensions supported by the server.
+ */
+class CapabilityCommand : public IMAPCommand {
+public:
+    std::string generate() const override {
+        return "CAPABILITY\r\n";
+    }
+
+    int getType() const override {return CAPABILITY;}
+};
+
+#endif //IMAP_TLS_CLIENT_CAPABILITYCOMMAND_H
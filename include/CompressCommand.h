@@ -0,0 +1,23 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#ifndef IMAP_TLS_CLIENT_COMPRESSCOMMAND_H
+#define IMAP_TLS_CLIENT_COMPRESSCOMMAND_H
+
+#include "IMAPCommand.h"
+#include <string>
+
+/**
+ * @brief Represents the IMAP COMPRESS DEFLATE command (RFC 4978).
+ */
+class CompressCommand : public IMAPCommand {
+public:
+    std::string generate() const override {
+        return "COMPRESS DEFLATE\r\n";
+    }
+
+    int getType() const override {return COMPRESS;}
+};
+
+#endif //IMAP_TLS_CLIENT_COMPRESSCOMMAND_H
@@ -6,6 +6,11 @@
 #define IMAP_TLS_CLIENT_CONNECTIONSTRATEGY_H
 
 #include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <zlib.h>
 #include "IMAPCommand.h"
 
 /**
@@ -13,6 +18,18 @@
  *
  * The ConnectionStrategy class is used to define the interface for establishing,
  * disconnecting, sending commands, and reading responses over different types of connections (e.g., TCP or SSL).
+ *
+ * Received data goes through one reusable buffer owned by the base class. Derived classes only
+ * implement receive(), which fills the buffer directly; callers read it through readLine(),
+ * peekLine(), readExact() and readSome(), which return views into the buffer instead of new strings.
+ *
+ * After startCompression() (IMAP COMPRESS=DEFLATE, RFC 4978) all data is passed through a raw
+ * deflate stream in both directions: commands are deflated before transmit(), received data
+ * is inflated into the buffer, so the callers and the derived classes are not aware of it.
+ *
+ * After setNonBlocking() the socket does not wait for data: tryReadLine() and tryReadSome()
+ * return false instead, and the caller waits until the socket is readable (see AsyncIMAPClient).
+ * Commands are still sent completely, waiting for the socket to accept them if needed.
  */
 class ConnectionStrategy {
 public:
@@ -32,14 +49,168 @@ public:
     virtual void disconnect() = 0;
 
     /**
-     * @brief Sends an IMAP command to the server.
+     * @brief Sends an IMAP command to the server, compressed if compression is enabled.
+     * @throws std::runtime_error if sending fails.
+     */
+    void sendCommand(const std::string& command);
+
+    /**
+     * @brief Turns on COMPRESS=DEFLATE once the server has accepted the COMPRESS command.
+     *
+     * Data already received behind the server's response is taken as compressed.
+     */
+    void startCompression();
+
+    [[nodiscard]] bool isCompressed() const;
+
+    /**
+     * @brief Byte counters of the connection.
+     */
+    struct Traffic {
+        uint64_t sent = 0;          ///< bytes of commands before compression
+        uint64_t wireSent = 0;      ///< bytes transmitted
+        uint64_t received = 0;      ///< bytes of responses after decompression
+        uint64_t wireReceived = 0;  ///< bytes received
+    };
+
+    [[nodiscard]] const Traffic& getTraffic() const;
+
+    /**
+     * @brief Returns the socket of the connection, -1 if not connected.
+     */
+    [[nodiscard]] virtual int getSocket() const = 0;
+
+    /**
+     * @brief Switches the connected socket to non-blocking mode for tryReadLine() and tryReadSome().
+     * @throws std::runtime_error if the mode cannot be set.
      */
-    virtual void sendCommand(std::string command) = 0;
+    void setNonBlocking();
 
     /**
-     * @brief Reads the server's response to the previously sent command.
+     * @brief Reads one response line.
+     * @return The line without the trailing CRLF, valid until the next read call.
+     * @throws std::runtime_error if the connection is closed before the line is complete.
      */
-    virtual std::string readResponse() const = 0;
+    std::string_view readLine();
+
+    /**
+     * @brief Returns the next response line without consuming it.
+     * @return The line without the trailing CRLF, valid until the next read call.
+     * @throws std::runtime_error if the connection is closed before the line is complete.
+     */
+    std::string_view peekLine();
+
+    /**
+     * @brief Reads exactly the given number of bytes.
+     * @return View of the data, valid until the next read call.
+     * @throws std::runtime_error if the connection is closed before all bytes arrive.
+     */
+    std::string_view readExact(size_t size);
+
+    /**
+     * @brief Reads at least one and at most maxSize bytes, receiving only if nothing is buffered.
+     * @return View of the data, valid until the next read call.
+     * @throws std::runtime_error if the connection is closed.
+     */
+    std::string_view readSome(size_t maxSize);
+
+    /**
+     * @brief Reads exactly size bytes and writes them to a file descriptor.
+     *
+     * The data is written straight from the receive buffer; derived classes may move it
+     * inside the kernel instead (see TCPConnectionStrategy). All bytes are consumed from
+     * the connection even if writing fails.
+     * @return False if writing to the file descriptor failed.
+     * @throws std::runtime_error if the connection is closed before all bytes arrive.
+     */
+    virtual bool readToFile(int fd, size_t size);
+
+    /**
+     * @brief Reads one response line if it can be completed without waiting.
+     * @param line Set to the line without the trailing CRLF, valid until the next read call.
+     * @return False if the socket has no more data yet; nothing is consumed then.
+     * @throws std::runtime_error if the connection is closed.
+     */
+    bool tryReadLine(std::string_view& line);
+
+    /**
+     * @brief Reads at least one and at most maxSize bytes if they are available without waiting.
+     * @param data Set to the data, valid until the next read call.
+     * @return False if the socket has no data yet.
+     * @throws std::runtime_error if the connection is closed.
+     */
+    bool tryReadSome(size_t maxSize, std::string_view& data);
+
+protected:
+    static constexpr size_t wouldBlock = SIZE_MAX;  ///< returned by receive() when a non-blocking socket has no data
+
+    /**
+     * @brief Receives up to size bytes from the connection into data.
+     * @return The number of bytes received, 0 if the connection was closed by the server,
+     *         wouldBlock if the socket is non-blocking and has no data.
+     * @throws std::runtime_error on receive errors.
+     */
+    virtual size_t receive(char* data, size_t size) = 0;
+
+    /**
+     * @brief Transmits the whole data over the connection, also when the socket is non-blocking.
+     * @throws std::runtime_error on send errors.
+     */
+    virtual void transmit(const char* data, size_t size) = 0;
+
+    /**
+     * @brief Counts data received by derived classes outside of receive(), e.g. spliced into a file.
+     */
+    void countReceived(size_t size);
+
+    /**
+     * @brief Drops any buffered data, used when a new connection is established.
+     */
+    void resetBuffer();
+
+    /**
+     * @brief Consumes up to maxSize bytes that are already buffered, without receiving.
+     * @return View of the data, empty if nothing is buffered.
+     */
+    std::string_view takeBuffered(size_t maxSize);
+
+    /**
+     * @brief Writes the whole data to a file descriptor.
+     * @return False if the write failed.
+     */
+    static bool writeAll(int fd, std::string_view data);
+
+private:
+    static constexpr size_t initialBufferSize = 256 * 1024;
+
+    std::vector<char> buffer;   ///< receive buffer, grows only for lines longer than its size
+    size_t head = 0;            ///< first unread byte
+    size_t tail = 0;            ///< end of received data
+    size_t scanned = 0;         ///< bytes after head already searched for a line end
+    Traffic traffic;            ///< byte counters
+
+    std::unique_ptr<z_stream, int (*)(z_streamp)> inflater{nullptr, inflateEnd};    ///< set while compressed
+    std::unique_ptr<z_stream, int (*)(z_streamp)> deflater{nullptr, deflateEnd};    ///< set while compressed
+    std::vector<char> compressed;       ///< received data waiting to be inflated
+    size_t compressedHead = 0;          ///< first byte not inflated yet
+    size_t compressedTail = 0;          ///< end of received compressed data
+    std::vector<char> deflated;         ///< output buffer of deflate
+
+    void fill();
+
+    bool tryFill();
+
+    bool findLine(size_t& length);
+
+    size_t receiveCounted(char* data, size_t size);
+
+    void countSent(size_t size);
+
+    size_t receiveInflated(char* data, size_t size);
+
+    size_t bufferLine();
+
+    std::string_view consumeLine(size_t length);
 };
 
 #endif //IMAP_TLS_CLIENT_CONNECTIONSTRATEGY_H
@@ -0,0 +1,64 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#ifndef IMAP_TLS_CLIENT_EVENTLOOP_H
+#define IMAP_TLS_CLIENT_EVENTLOOP_H
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <cstdint>
+#include "AsyncSession.h"
+
+/**
+ * @brief Drives many AsyncSessions on one thread with epoll.
+ *
+ * At most maxSessions sessions are connected at a time, the others wait in a queue and
+ * are started as running ones finish. Each session is registered with the events it
+ * currently waits for, which are updated after every handle() call.
+ */
+class EventLoop {
+public:
+    explicit EventLoop(size_t maxSessions);
+
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    void add(std::unique_ptr<AsyncSession> session);
+
+    /**
+     * @brief Runs until every added session has finished.
+     * @return The amount of sessions that failed.
+     * @throws std::runtime_error if epoll fails.
+     */
+    int run();
+
+private:
+    /**
+     * @brief A running session and what it is registered with in epoll.
+     */
+    struct Active {
+        std::unique_ptr<AsyncSession> session;
+        int fd = -1;                // registered socket, -1 if none
+        uint32_t interest = 0;      // registered events
+    };
+
+    static constexpr int maxEvents = 64;    ///< events taken from epoll at once
+
+    size_t maxSessions;                             ///< sessions connected at the same time
+    int epollFd = -1;                               ///< epoll instance
+    std::deque<std::unique_ptr<AsyncSession>> waiting; ///< sessions not started yet
+    std::vector<std::unique_ptr<Active>> active;    ///< running sessions
+    int failed = 0;                                 ///< sessions that ended with an error
+
+    void startWaiting();
+
+    void update(Active& entry);
+
+    void remove(Active& entry);
+};
+
+#endif //IMAP_TLS_CLIENT_EVENTLOOP_H
@@ -0,0 +1,81 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#ifndef IMAP_TLS_CLIENT_EXECUTOR_H
+#define IMAP_TLS_CLIENT_EXECUTOR_H
+
+#include <vector>
+#include <coroutine>
+#include <cstdint>
+#include "Task.h"
+
+/**
+ * @brief Runs coroutine tasks on one thread, resuming them when their sockets become ready.
+ *
+ * A coroutine suspends with `co_await executor.readable(fd)`; the executor registers the socket
+ * with epoll (one-shot) and resumes the coroutine from run() once the socket is readable. Many
+ * connections therefore interleave on a single thread, each written as straight-line code.
+ */
+class Executor {
+public:
+    Executor();
+
+    ~Executor();
+
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    /**
+     * @brief Awaitable suspending the coroutine until a socket is ready.
+     */
+    class SocketAwaiter {
+    public:
+        SocketAwaiter(Executor& executor, int fd, uint32_t events) : executor(executor), fd(fd), events(events) {}
+
+        [[nodiscard]] bool await_ready() const noexcept {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) {
+            executor.wait(fd, events, handle);
+        }
+
+        void await_resume() const noexcept {}
+
+    private:
+        Executor& executor;     ///< executor resuming the coroutine
+        int fd;                 ///< socket waited for
+        uint32_t events;        ///< epoll events waited for
+    };
+
+    /**
+     * @brief Starts a task; it runs until its first suspension and is then driven by run().
+     * @param task The task; a lambda coroutine must not capture anything, as the lambda is gone by then.
+     */
+    void spawn(Task<> task);
+
+    /**
+     * @brief Resumes waiting coroutines until every spawned task has finished.
+     * @throws The exception of a task that failed, or std::runtime_error if epoll fails or
+     *         a task waits for something other than a socket.
+     */
+    void run();
+
+    SocketAwaiter readable(int fd);
+
+    SocketAwaiter writable(int fd);
+
+private:
+    static constexpr int maxEvents = 64;    ///< events taken from epoll at once
+
+    int epollFd = -1;               ///< epoll instance
+    std::vector<Task<>> tasks;      ///< spawned tasks not finished yet
+    size_t waiting = 0;             ///< coroutines waiting for a socket
+
+    void wait(int fd, uint32_t events, std::coroutine_handle<> handle);
+
+    void finishTasks();
+};
+
+#endif //IMAP_TLS_CLIENT_EXECUTOR_H
@@ -9,18 +9,19 @@
 #include <string>
 
 /**
- * @brief Represents the IMAP FETCH command for retrieving all emails.
+ * @brief Represents the IMAP UID FETCH command for retrieving the emails of a UID set.
  */
 class FetchCommand : public IMAPCommand {
+    std::string sequenceSet;
     bool onlyHeaders;
 
 public:
-    FetchCommand(bool onlyHeaders) : onlyHeaders(onlyHeaders) {}
+    FetchCommand(const std::string& sequenceSet, bool onlyHeaders) : sequenceSet(sequenceSet), onlyHeaders(onlyHeaders) {}
 
     std::string generate() const override {
         std::string fetchPart = onlyHeaders ? "BODY[HEADER]" : "BODY[]";
 
-        return "FETCH 1:* (" + fetchPart + ")\r\n";
+        return "UID FETCH " + sequenceSet + " (UID " + fetchPart + ")\r\n";
     }
 
     int getType() const override {return FETCH;}
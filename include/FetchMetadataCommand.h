@@ -0,0 +1,34 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#ifndef IMAP_TLS_CLIENT_FETCHMETADATACOMMAND_H
+#define IMAP_TLS_CLIENT_FETCHMETADATACOMMAND_H
+
+#include "IMAPCommand.h"
+#include <string>
+
+/**
+ * @brief Represents the UID FETCH command for the size, arrival time and envelope of a UID set,
+ *        the first phase of a filtered fetch.
+ *
+ * Without the envelope only the sizes are fetched, which is all a chunked download needs.
+ */
+class FetchMetadataCommand : public IMAPCommand {
+    std::string sequenceSet;
+    bool envelope;
+
+public:
+    explicit FetchMetadataCommand(const std::string& sequenceSet, bool envelope = true)
+            : sequenceSet(sequenceSet), envelope(envelope) {}
+
+    std::string generate() const override {
+        std::string items = envelope ? "UID RFC822.SIZE INTERNALDATE ENVELOPE" : "UID RFC822.SIZE";
+
+        return "UID FETCH " + sequenceSet + " (" + items + ")\r\n";
+    }
+
+    int getType() const override {return FETCH;}
+};
+
+#endif //IMAP_TLS_CLIENT_FETCHMETADATACOMMAND_H
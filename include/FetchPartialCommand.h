@@ -0,0 +1,35 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#ifndef IMAP_TLS_CLIENT_FETCHPARTIALCOMMAND_H
+#define IMAP_TLS_CLIENT_FETCHPARTIALCOMMAND_H
+
+#include "IMAPCommand.h"
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Represents the UID FETCH command for a byte range of one message (`BODY[]<offset.length>`),
+ *        used to download large messages in chunks.
+ *
+ * The server returns fewer than `length` bytes once the range reaches the end of the message.
+ */
+class FetchPartialCommand : public IMAPCommand {
+    uint32_t uid;
+    size_t offset;
+    size_t length;
+
+public:
+    FetchPartialCommand(uint32_t uid, size_t offset, size_t length) : uid(uid), offset(offset), length(length) {}
+
+    std::string generate() const override {
+        return "UID FETCH " + std::to_string(uid) + " (UID BODY[]<" + std::to_string(offset) + "." +
+               std::to_string(length) + ">)\r\n";
+    }
+
+    int getType() const override {return FETCH;}
+};
+
+#endif //IMAP_TLS_CLIENT_FETCHPARTIALCOMMAND_H
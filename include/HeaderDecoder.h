@@ -0,0 +1,50 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#ifndef IMAP_TLS_CLIENT_HEADERDECODER_H
+#define IMAP_TLS_CLIENT_HEADERDECODER_H
+
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Finds header fields and decodes their RFC 2047 encoded words to UTF-8.
+ *
+ * A value is decoded in one pass: folded lines are unfolded, every `=?charset?B|Q?text?=` word
+ * is decoded wherever it appears, whitespace between adjacent encoded words is dropped and the
+ * words are converted from their charset to UTF-8. UTF-8, US-ASCII, ISO-8859-1/2/15,
+ * Windows-1250/1251/1252 and KOI8-R are converted with static tables; the bytes of other
+ * charsets are kept as they are.
+ */
+class HeaderDecoder {
+public:
+    /**
+     * @brief Finds a header field by its name (any case) in a header block.
+     *
+     * The search stops at the empty line ending the header block.
+     * @param headers The header block.
+     * @param name The field name without the colon, e.g. `Subject`.
+     * @param value Receives the raw value after the colon, with its continuation lines.
+     * @return True if the field was found.
+     */
+    static bool findField(std::string_view headers, std::string_view name, std::string_view& value);
+
+    /**
+     * @brief Unfolds a header value and decodes its encoded words to UTF-8.
+     * @param value The raw value as returned by findField().
+     * @return The decoded value without leading and trailing whitespace.
+     */
+    [[nodiscard]] static std::string decode(std::string_view value);
+
+    /**
+     * @brief Converts text in the given charset to UTF-8 and appends it.
+     * @param charset The charset name (any case), an RFC 2231 language suffix (`*en`) is ignored.
+     * @param text The text to convert.
+     * @param output Receives the converted text, or the text unchanged if the charset is unknown.
+     * @return False if the charset is unknown.
+     */
+    static bool toUtf8(std::string_view charset, std::string_view text, std::string& output);
+};
+
+#endif //IMAP_TLS_CLIENT_HEADERDECODER_H
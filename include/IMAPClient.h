@@ -6,13 +6,24 @@
 #define IMAP_TLS_CLIENT_IMAPCLIENT_H
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <cstdint>
 #include <openssl/ssl.h>
 #include <memory>
+#include <functional>
+#include <atomic>
+#include <chrono>
 #include "IMAPCommand.h"
 #include "IMAPResponceType.h"
 #include "ArgParser.h"
 #include "ConnectionStrategy.h"
+#include "MessageWriter.h"
+#include "WriterPool.h"
+#include "MessageSink.h"
+#include "MessageSet.h"
+#include "SyncState.h"
+#include "MessageTable.h"
 
 /**
  * @brief The IMAPClient class handles communication with an IMAP server.
@@ -35,13 +46,48 @@ public:
 
     void fetch();
 
+    void commitSync();
+
     void logout();
 
+    std::vector<std::string> list();
+
+    void setMailbox(const std::string& mailbox, const std::string& outDir);
+
+    [[nodiscard]] const std::vector<uint32_t>& getIds() const;
+
+    void setIds(std::vector<uint32_t> messageIds);
+
+    [[nodiscard]] const MessageTable& getMetadata() const;
+
+    [[nodiscard]] std::shared_ptr<SyncState> getSyncState() const;
+
+    void setSyncState(std::shared_ptr<SyncState> syncState);
+
+    [[nodiscard]] std::shared_ptr<MessageSink> getSink() const;
+
+    void setSink(std::shared_ptr<MessageSink> messageSink);
+
+    [[nodiscard]] int getSavedCount() const;
+
+    void setProgressCounter(std::atomic<int>* counter);
+
+    void setWriterPool(std::shared_ptr<WriterPool> pool);
+
+    [[nodiscard]] std::shared_ptr<WriterPool> getWriterPool() const;
+
+    static void reportSaved(int count, const std::string& mailbox);
+
+    static std::string messageFilename(const std::string& outDir, uint32_t messageId, const std::string& headers);
+
     void sendCommand(const IMAPCommand& command);
 
-    [[nodiscard]] std::string readResponse() const;
+    /**
+     * @brief Called for every literal in a response; it has to consume exactly `size` bytes via readLiteral().
+     */
+    using LiteralHandler = std::function<void(const std::string& line, size_t size)>;
 
-    std::string readWholeResponse();
+    std::string readWholeResponse(const LiteralHandler& onLiteral = nullptr);
 
     void generateNextTag();
 
@@ -50,32 +96,55 @@ private:
     int currTagNum;             ///< current number used in tag
     std::string currTag;        ///< last generated tag
     int lastCommand{};          ///< last sent command
-    int messageSaved = 0;       ///< the amount of saved message
-    std::vector<int> ids;       ///< ids of messages got by SEARCH command
+    std::atomic<int> messageSaved{0};   ///< the amount of saved message, counted by the writer threads too
+    std::atomic<int>* progress = nullptr; ///< optional counter of saved messages shared by several clients
+    std::vector<uint32_t> ids;  ///< UIDs of messages got by SEARCH command
+    MessageSet wanted;          ///< the same UIDs for fast lookups while fetching
+    MessageTable metadata;      ///< size, arrival time and envelope of the found messages, only with a filter
+    uint32_t uidValidity = 0;   ///< UIDVALIDITY of the selected mailbox
+    uint32_t uidNext = 0;       ///< UIDNEXT of the selected mailbox, 0 if not reported
+    std::shared_ptr<SyncState> state; ///< state of the previous syncs of the mailbox
+    std::shared_ptr<MessageSink> sink; ///< mbox, maildir or pack output, nullptr for one file per message
+    bool literalPlus = false;   ///< the server accepts non-synchronizing literals (LITERAL+)
+    std::chrono::steady_clock::time_point connectedAt; ///< start of the connection, for the traffic report
+
+    static constexpr int maxChunkRetries = 3; ///< reconnects without progress before a chunked download fails
 
     std::unique_ptr<ConnectionStrategy> strategy; ///< strategy for TCP or SSL connection
+    std::shared_ptr<WriterPool> writerPool; ///< threads writing the messages, nullptr if written directly
+    MessageWriter writer;       ///< streams fetched messages into the output directory
 
-    [[nodiscard]] size_t findOk(const std::string& response) const;
+    void readLiteral(size_t size, const std::function<void(const char*, size_t)>& sink);
 
-    [[nodiscard]] IMAPResponseType findResponseType(const std::string &response) const;
+    std::string readUntil(const std::function<IMAPResponseType(std::string_view)>& completion,
+                          const LiteralHandler& onLiteral);
 
-    [[nodiscard]] size_t findNo(const std::string &response) const;
+    void fetchPipelined(const std::vector<std::string>& sequenceSets);
 
-    [[nodiscard]] size_t findBad(const std::string &response) const;
+    void filterByMetadata();
 
-    static std::string decodeBase64(const std::string &encoded);
+    std::vector<uint32_t> splitBySize(std::vector<uint32_t>& large);
+
+    void fetchChunked(uint32_t uid);
+
+    bool fetchChunks(uint32_t uid, const std::string& path);
+
+    void reconnect();
 
     static std::string extractAndDecodeSubject(const std::string &headers);
 
     static std::string validateSubject(const std::string &subject);
 
-    static std::string decodeQuotedPrintable(const std::string &encoded);
+    std::string sendFetch(const std::string& sequenceSet);
+
+
+    void saveLiteral(const std::string &line, size_t size);
 
-    std::string fetchById(int messageNumber);
+    void messageStored(uint32_t messageId, const std::string &filename, bool saved);
 
-    [[nodiscard]] bool saveMessage(int messageId, const std::string &messageBody) const;
+    void compress(const std::string &capabilities);
 
-    size_t processMessage(const std::string &response, int messageId, size_t startPos);
+    void reportTraffic() const;
 };
 
 #endif //IMAP_TLS_CLIENT_IMAPCLIENT_H
@@ -6,6 +6,9 @@
 #define IMAP_TLS_CLIENT_IMAPCOMMAND_H
 
 #include <string>
+#include <vector>
+#include <cstring>
+#include <charconv>
 
 #define CONNECT 0
 #define LOGIN 1
@@ -13,6 +16,9 @@
 #define SEARCH 3
 #define FETCH 4
 #define LOGOUT 5
+#define LIST 6
+#define CAPABILITY 7
+#define COMPRESS 8
 
 /**
  * @brief Abstract base class for all IMAP commands.
@@ -22,6 +28,65 @@ public:
     virtual std::string generate() const = 0;
     virtual ~IMAPCommand() = default;
     virtual int getType() const = 0;
+
+    /**
+     * @brief Splits a command at its synchronizing literals (`{n}` before a line break, RFC 3501 section 7.5).
+     *
+     * Every part but the last ends with a literal announcement; the next part, starting with the
+     * literal bytes, may only be sent after the server's `+` continuation request.
+     * @param command The complete command text.
+     * @return The parts in order, just the command itself if it has no literal.
+     */
+    static std::vector<std::string> splitAtLiterals(const std::string& command) {
+        std::vector<std::string> parts;
+        size_t start = 0;       // start of the current part
+        size_t scan = 0;        // first byte after the last literal
+        size_t lineEnd;
+        while ((lineEnd = command.find("\r\n", scan)) != std::string::npos && lineEnd + 2 < command.size()) {
+            size_t open = command.rfind('{', lineEnd);
+            const char* last = command.data() + lineEnd - 1;
+            size_t size = 0;
+            if (open == std::string::npos || open < scan || *last != '}') {
+                break;
+            }
+            auto [end, error] = std::from_chars(command.data() + open + 1, last, size);
+            if (error != std::errc() || end != last) {
+                break;
+            }
+            parts.push_back(command.substr(start, lineEnd + 2 - start));
+            start = lineEnd + 2;
+            scan = start + size;
+        }
+        parts.push_back(command.substr(start));
+        return parts;
+    }
+
+protected:
+    /**
+     * @brief Formats a command argument as an IMAP atom, or as a quoted string if it
+     *        contains characters not allowed in an atom (e.g. a mailbox with spaces).
+     */
+    static std::string quote(const std::string& value) {
+        bool isAtom = !value.empty();
+        for (char c : value) {
+            if (static_cast<unsigned char>(c) <= 0x20 || static_cast<unsigned char>(c) >= 0x7f || std::strchr("(){%*\"\\]", c)) {
+                isAtom = false;
+                break;
+            }
+        }
+        if (isAtom) {
+            return value;
+        }
+
+        std::string quoted = "\"";
+        for (char c : value) {
+            if (c == '"' || c == '\\') {
+                quoted += '\\';
+            }
+            quoted += c;
+        }
+        return quoted + "\"";
+    }
 };
 
 #endif //IMAP_TLS_CLIENT_IMAPCOMMAND_H
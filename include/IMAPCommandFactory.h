@@ -7,17 +7,21 @@
 
 #include "LoginCommand.h"
 #include "FetchCommand.h"
+#include "FetchMetadataCommand.h"
+#include "FetchPartialCommand.h"
 #include "SelectCommand.h"
 #include "SearchCommand.h"
 #include "LogoutCommand.h"
-#include "FetchByIdCommand.h"
+#include "ListCommand.h"
+#include "CapabilityCommand.h"
+#include "CompressCommand.h"
 #include <memory>
 
 /**
  * @brief Factory class for creating various IMAPCommand objects.
  *
  * The IMAPCommandFactory class provides methods to create specific IMAP commands
- * like LOGIN, SELECT, SEARCH, FETCH, and LOGOUT. It abstracts the creation logic,
+ * like LOGIN, SELECT, SEARCH, FETCH, LIST, CAPABILITY, COMPRESS and LOGOUT. It abstracts the creation logic,
  * allowing clients to generate commands without directly instantiating them.
  */
 class IMAPCommandFactory {
@@ -30,16 +34,32 @@ public:
         return std::make_unique<SelectCommand>(mailbox);
     }
 
-    static std::unique_ptr<IMAPCommand> createSearchCommand(bool onlyNew){
-        return std::make_unique<SearchCommand>(onlyNew);
+    static std::unique_ptr<IMAPCommand> createSearchCommand(const SearchCriteria& criteria){
+        return std::make_unique<SearchCommand>(criteria);
     }
 
-    static std::unique_ptr<IMAPCommand> createFetchCommand(bool onlyHeaders) {
-        return std::make_unique<FetchCommand>(onlyHeaders);
+    static std::unique_ptr<IMAPCommand> createFetchCommand(const std::string& sequenceSet, bool onlyHeaders) {
+        return std::make_unique<FetchCommand>(sequenceSet, onlyHeaders);
     }
 
-    static std::unique_ptr<IMAPCommand> createFetchByIdCommand(int messageId, bool onlyHeaders) {
-        return std::make_unique<FetchByIdCommand>(messageId, onlyHeaders);
+    static std::unique_ptr<IMAPCommand> createFetchMetadataCommand(const std::string& sequenceSet, bool envelope = true) {
+        return std::make_unique<FetchMetadataCommand>(sequenceSet, envelope);
+    }
+
+    static std::unique_ptr<IMAPCommand> createFetchPartialCommand(uint32_t uid, size_t offset, size_t length) {
+        return std::make_unique<FetchPartialCommand>(uid, offset, length);
+    }
+
+    static std::unique_ptr<IMAPCommand> createListCommand() {
+        return std::make_unique<ListCommand>();
+    }
+
+    static std::unique_ptr<IMAPCommand> createCapabilityCommand() {
+        return std::make_unique<CapabilityCommand>();
+    }
+
+    static std::unique_ptr<IMAPCommand> createCompressCommand() {
+        return std::make_unique<CompressCommand>();
     }
 
     static std::unique_ptr<IMAPCommand> createLogoutCommand() {
@@ -0,0 +1,66 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#ifndef IMAP_TLS_CLIENT_JOBRUNNER_H
+#define IMAP_TLS_CLIENT_JOBRUNNER_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <memory>
+#include "ArgParser.h"
+#include "WriterPool.h"
+
+/**
+ * @brief Runs sync jobs: the one given on the command line, or all jobs of a jobs file.
+ *
+ * Every line of the jobs file holds the arguments of one imapcl run (server, -a, -o, -b, ...);
+ * empty lines and lines starting with '#' are skipped, and arguments with spaces are quoted with
+ * double quotes. The jobs run on `--job-workers` threads of one process, so OpenSSL, the TLS
+ * context with its certificates, the TLS session cache and the writer pool are set up once and
+ * shared by all of them instead of once per process.
+ */
+class JobRunner {
+public:
+    JobRunner(ArgParser::Config config, std::shared_ptr<WriterPool> writerPool);
+
+    /**
+     * @brief Runs all jobs of the jobs file.
+     * @return 0 if every job succeeded, 1 otherwise.
+     * @throws std::runtime_error if the jobs file cannot be read.
+     * @throws std::invalid_argument if a job line is invalid.
+     */
+    int run();
+
+    /**
+     * @brief Syncs the mailboxes of one job, as a single imapcl run does.
+     * @param config The job.
+     * @param writerPool Writer threads shared with other jobs, or nullptr.
+     * @return 0 if everything was synced, 1 otherwise.
+     * @throws std::exception if syncing a single mailbox fails.
+     */
+    static int runJob(const ArgParser::Config& config, const std::shared_ptr<WriterPool>& writerPool);
+
+    /**
+     * @brief Splits a job line into arguments at whitespace, keeping double-quoted parts together.
+     * @throws std::invalid_argument if a quote is not closed.
+     */
+    static std::vector<std::string> splitArguments(const std::string& line);
+
+private:
+    ArgParser::Config config;               ///< config with cli parameters
+    std::shared_ptr<WriterPool> writerPool; ///< writer threads shared by all jobs, or nullptr
+    std::vector<ArgParser::Config> jobs;    ///< parsed lines of the jobs file
+    std::mutex mutex;                       ///< guards nextJob and failed
+    size_t nextJob = 0;                     ///< first job not taken by any worker yet
+    int failed = 0;                         ///< the amount of jobs that failed
+
+    static void prepareTLS(const ArgParser::Config& config);
+
+    void readJobs();
+
+    void worker();
+};
+
+#endif //IMAP_TLS_CLIENT_JOBRUNNER_H
@@ -0,0 +1,26 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#ifndef IMAP_TLS_CLIENT_LISTCOMMAND_H
+#define IMAP_TLS_CLIENT_LISTCOMMAND_H
+
+#include "IMAPCommand.h"
+#include <string>
+
+/**
+ * @brief Represents the IMAP LIST command returning all mailboxes of the account.
+ */
+class ListCommand : public IMAPCommand {
+
+public:
+    ListCommand(){}
+
+    std::string generate() const override {
+        return "LIST \"\" \"*\"\r\n";
+    }
+
+    int getType() const override {return LIST;}
+};
+
+#endif //IMAP_TLS_CLIENT_LISTCOMMAND_H
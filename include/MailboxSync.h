@@ -0,0 +1,51 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#ifndef IMAP_TLS_CLIENT_MAILBOXSYNC_H
+#define IMAP_TLS_CLIENT_MAILBOXSYNC_H
+
+#include <string>
+#include <deque>
+#include <mutex>
+#include <memory>
+#include "ArgParser.h"
+#include "IMAPClient.h"
+
+/**
+ * @brief Syncs several mailboxes of one account over a pool of parallel connections.
+ *
+ * Every worker thread owns one authenticated IMAPClient and takes mailboxes from a shared
+ * queue until it is empty, so the TCP/TLS handshake and LOGIN are paid once per worker
+ * instead of once per mailbox. Each mailbox is saved into its own subdirectory of outDir.
+ *
+ * With `--event-loops N`, each mailbox gets its own non-blocking AsyncSession instead, and the
+ * sessions are spread over N epoll threads, so that many connections do not need a thread each.
+ */
+class MailboxSync {
+public:
+    explicit MailboxSync(ArgParser::Config config, std::shared_ptr<WriterPool> writerPool = nullptr);
+
+    /**
+     * @brief Syncs all mailboxes given by -b, or all mailboxes returned by LIST.
+     * @return 0 if every mailbox was synced, 1 otherwise.
+     */
+    int run();
+
+    static std::string mailboxDirectory(const std::string& outDir, const std::string& mailbox);
+
+private:
+    ArgParser::Config config;           ///< config with cli parameters
+    std::shared_ptr<WriterPool> writerPool; ///< writer threads shared by all workers, or nullptr
+    std::deque<std::string> queue;      ///< mailboxes not taken by any worker yet
+    std::mutex mutex;                   ///< guards queue and failed
+    int failed = 0;                     ///< the amount of mailboxes that failed to sync
+
+    void worker(std::unique_ptr<IMAPClient> client);
+
+    int runEventLoops(const std::vector<std::string>& mailboxes);
+
+    bool nextMailbox(std::string& mailbox);
+};
+
+#endif //IMAP_TLS_CLIENT_MAILBOXSYNC_H
@@ -0,0 +1,36 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#ifndef IMAP_TLS_CLIENT_MAILDIRSINK_H
+#define IMAP_TLS_CLIENT_MAILDIRSINK_H
+
+#include "MessageSink.h"
+#include <string>
+#include <mutex>
+#include <atomic>
+
+/**
+ * @brief Saves messages into a Maildir in the output directory.
+ *
+ * Every message is written into `tmp/` under a unique name and renamed into `new/`
+ * once it is complete, so that readers of the Maildir never see partial messages.
+ */
+class MaildirSink : public MessageSink {
+public:
+    explicit MaildirSink(std::string outDir);
+
+    Result store(uint32_t messageId, std::string_view message, std::string& name) override;
+
+    void close() override;
+
+private:
+    std::string outDir;                 ///< the Maildir
+    std::string hostname;               ///< host part of the unique names
+    std::once_flag created;             ///< creates tmp/, new/ and cur/ before the first message
+    std::atomic<unsigned> counter{0};   ///< makes the names unique within the process
+
+    std::string uniqueName();
+};
+
+#endif //IMAP_TLS_CLIENT_MAILDIRSINK_H
@@ -0,0 +1,41 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#ifndef IMAP_TLS_CLIENT_MBOXSINK_H
+#define IMAP_TLS_CLIENT_MBOXSINK_H
+
+#include "MessageSink.h"
+#include <string>
+#include <mutex>
+
+/**
+ * @brief Appends messages to a single `mbox` file in the output directory (mboxrd variant).
+ *
+ * Every message gets a `From ` separator line, line endings are converted to LF and
+ * lines starting with `>*From ` are quoted with one more `>`. The output is collected
+ * in a large buffer and appended with a few big writes.
+ */
+class MboxSink : public MessageSink {
+public:
+    explicit MboxSink(const std::string& outDir);
+
+    ~MboxSink() override;
+
+    Result store(uint32_t messageId, std::string_view message, std::string& name) override;
+
+    void close() override;
+
+private:
+    static constexpr size_t flushSize = 4 * 1024 * 1024;   ///< buffered bytes written at once
+
+    std::string path;       ///< path of the mbox file
+    std::string buffer;     ///< converted messages not written yet
+    int fd = -1;            ///< the mbox file, opened on the first flush
+    bool failed = false;    ///< a write failed, reported by close()
+    std::mutex mutex;       ///< guards all members above
+
+    void flush();
+};
+
+#endif //IMAP_TLS_CLIENT_MBOXSINK_H
@@ -0,0 +1,61 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#ifndef IMAP_TLS_CLIENT_MESSAGESET_H
+#define IMAP_TLS_CLIENT_MESSAGESET_H
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+/**
+ * @brief Set of message numbers with constant time membership checks.
+ *
+ * Message numbers returned by SEARCH are mostly dense, so the set is stored as a bitmap
+ * covering the range between the smallest and the largest number. Very sparse sets
+ * (e.g. a few UIDs far apart) fall back to a sorted vector and binary search, so the
+ * memory use never exceeds a few bits per possible number in a dense range.
+ */
+class MessageSet {
+    uint32_t first = 0;             ///< number represented by bit 0
+    std::vector<uint64_t> bits;     ///< bitmap of present numbers, used for dense sets
+    std::vector<uint32_t> sorted;   ///< sorted numbers, used for sparse sets
+
+public:
+    MessageSet() = default;
+
+    explicit MessageSet(const std::vector<uint32_t>& ids) {
+        if (ids.empty()) {
+            return;
+        }
+
+        auto [minId, maxId] = std::minmax_element(ids.begin(), ids.end());
+        uint64_t range = static_cast<uint64_t>(*maxId) - static_cast<uint64_t>(*minId) + 1;
+
+        if (range <= 64 * static_cast<uint64_t>(ids.size()) + 64) {
+            first = *minId;
+            bits.assign((range + 63) / 64, 0);
+            for (uint32_t id : ids) {
+                uint64_t bit = static_cast<uint64_t>(id - first);
+                bits[bit / 64] |= uint64_t(1) << (bit % 64);
+            }
+        } else {
+            sorted = ids;
+            std::sort(sorted.begin(), sorted.end());
+        }
+    }
+
+    [[nodiscard]] bool contains(uint32_t id) const {
+        if (!bits.empty()) {
+            if (id < first) {
+                return false;
+            }
+            uint64_t bit = static_cast<uint64_t>(id - first);
+            return bit / 64 < bits.size() && (bits[bit / 64] >> (bit % 64) & 1) != 0;
+        }
+        return std::binary_search(sorted.begin(), sorted.end(), id);
+    }
+};
+
+#endif //IMAP_TLS_CLIENT_MESSAGESET_H
@@ -0,0 +1,58 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#ifndef IMAP_TLS_CLIENT_MESSAGESINK_H
+#define IMAP_TLS_CLIENT_MESSAGESINK_H
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <cstdint>
+
+/**
+ * @brief Destination of complete messages for the output formats other than one file per message.
+ *
+ * A sink belongs to one output directory. It may be shared by several clients fetching
+ * the same mailbox and by writer pool threads, so store() has to be thread-safe.
+ */
+class MessageSink {
+public:
+    enum class Result {
+        SAVED,      ///< the message was stored now
+        FAILED      ///< the message could not be stored
+    };
+
+    virtual ~MessageSink() = default;
+
+    /**
+     * @brief Stores one complete message.
+     * @param messageId The UID of the message.
+     * @param message The whole message as received.
+     * @param name Receives the name the message is recorded under in the sync state.
+     */
+    virtual Result store(uint32_t messageId, std::string_view message, std::string& name) = 0;
+
+    /**
+     * @brief Writes out everything still buffered; called once all messages are stored.
+     * @throws std::runtime_error if the data cannot be written.
+     */
+    virtual void close() = 0;
+
+    /**
+     * @brief Creates the sink for an output format.
+     * @param format One of "mbox", "maildir" or "pack".
+     * @param outDir The output directory.
+     * @throws std::invalid_argument for an unknown format.
+     */
+    static std::shared_ptr<MessageSink> create(const std::string& format, const std::string& outDir);
+
+protected:
+    /**
+     * @brief Writes the whole data to a file descriptor.
+     * @return False if the write failed.
+     */
+    static bool writeAll(int fd, std::string_view data);
+};
+
+#endif //IMAP_TLS_CLIENT_MESSAGESINK_H
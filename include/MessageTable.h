@@ -0,0 +1,105 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#ifndef IMAP_TLS_CLIENT_MESSAGETABLE_H
+#define IMAP_TLS_CLIENT_MESSAGETABLE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <ctime>
+#include <cstddef>
+#include <cstdint>
+#include "ArgParser.h"
+
+/**
+ * @brief Metadata of one message, as returned by the first phase of a filtered fetch.
+ */
+struct MessageInfo {
+    uint32_t uid = 0;
+    size_t size = 0;                ///< RFC822.SIZE
+    std::time_t internalDate = 0;   ///< INTERNALDATE in UTC, 0 if missing or malformed
+    std::string date;               ///< Date field of the envelope
+    std::string subject;            ///< Subject of the envelope, decoded to UTF-8
+    std::string from;               ///< From addresses as `Name <mailbox@host>`, separated by ", "
+};
+
+/**
+ * @brief In-memory table of the metadata fetched by `UID FETCH (UID RFC822.SIZE INTERNALDATE ENVELOPE)`.
+ *
+ * A filtered fetch runs in two phases: the metadata of all found messages is fetched in bulk
+ * first, which costs a few hundred bytes per message, and only the bodies of the messages
+ * passing the filter are fetched afterwards.
+ */
+class MessageTable {
+public:
+    /**
+     * @brief Criteria a message has to meet to be downloaded, taken from the command line.
+     */
+    struct Filter {
+        size_t maxSize = 0;                 ///< largest RFC822.SIZE, 0 for any size
+        std::time_t receivedAfter = 0;      ///< earliest INTERNALDATE (inclusive), 0 for any
+        std::time_t receivedBefore = 0;     ///< INTERNALDATE must be earlier than this, 0 for any
+        std::string sender;                 ///< text the From addresses contain (any case), empty for any
+
+        Filter() = default;
+
+        explicit Filter(const ArgParser::Config& config);
+
+        /**
+         * @brief Checks whether any criterion is set, i.e. whether the metadata has to be fetched at all.
+         */
+        [[nodiscard]] bool active() const;
+
+        /**
+         * @brief Checks the message against all criteria; a missing INTERNALDATE fails the date criteria.
+         */
+        [[nodiscard]] bool matches(const MessageInfo& info) const;
+    };
+
+    /**
+     * @brief Adds the messages of a FETCH response with its literals kept inline.
+     *
+     * Untagged responses other than FETCH and FETCH items that were not asked for are skipped.
+     * @param response The response text as returned by IMAPClient::readWholeResponse().
+     * @return The number of messages added.
+     */
+    size_t parse(std::string_view response);
+
+    /**
+     * @brief Splits UIDs into those passing the filter and those failing it.
+     *
+     * UIDs missing from the table are kept; their FETCH simply returns nothing if the message
+     * was expunged in the meantime.
+     * @param ids The UIDs found by SEARCH.
+     * @param filter The criteria.
+     * @param rejected Receives the UIDs failing the filter.
+     * @return The UIDs passing the filter, in the order of ids.
+     */
+    [[nodiscard]] std::vector<uint32_t> select(const std::vector<uint32_t>& ids, const Filter& filter,
+                                          std::vector<uint32_t>& rejected) const;
+
+    /**
+     * @brief Returns the metadata of a message, nullptr if it is not in the table.
+     */
+    [[nodiscard]] const MessageInfo* find(uint32_t uid) const;
+
+    [[nodiscard]] size_t size() const;
+
+    void clear();
+
+    /**
+     * @brief Parses an IMAP date-time (`17-Jul-1996 02:44:25 -0700`, RFC 3501 section 9).
+     * @param text The date-time, without quotes.
+     * @param time Receives the time in UTC.
+     * @return False if the text is malformed.
+     */
+    static bool parseInternalDate(std::string_view text, std::time_t& time);
+
+private:
+    std::unordered_map<uint32_t, MessageInfo> messages;    ///< metadata by UID
+};
+
+#endif //IMAP_TLS_CLIENT_MESSAGETABLE_H
@@ -0,0 +1,159 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#ifndef IMAP_TLS_CLIENT_MESSAGEWRITER_H
+#define IMAP_TLS_CLIENT_MESSAGEWRITER_H
+
+#include <string>
+#include <functional>
+#include <memory>
+#include <cstdint>
+#include <mutex>
+#include <condition_variable>
+#include "WriterPool.h"
+#include "MessageSink.h"
+
+/**
+ * @brief Streams a single message literal into its output file.
+ *
+ * The message arrives in chunks straight from the connection. Only the header
+ * block is copied (peeked) until the file name (which depends on the Subject)
+ * is known; the rest of the body is written with write()/writev() directly from
+ * the chunks, or handed to the connection as a file descriptor (see outputFd()).
+ *
+ * If the message ID is not known when the headers are complete (the server sent
+ * the UID after the body), the message is streamed into a temporary file that is
+ * renamed once the ID is set.
+ *
+ * With a WriterPool set, the message is collected in memory instead and written
+ * by one of the pool threads after finish(); flush() waits for those writes.
+ * With a MessageSink set (output formats other than one file per message), the
+ * collected message is handed to the sink, by a pool thread if a pool is set too.
+ */
+class MessageWriter {
+public:
+    /**
+     * @brief Builds the output path for a message from its ID and header block.
+     */
+    using NameBuilder = std::function<std::string(uint32_t messageId, const std::string& headers)>;
+
+    /**
+     * @brief Called once a message is on disk, from a pool thread if a pool is set.
+     * @param filename The file name without directory.
+     * @param saved True if the file was written now, false if it already existed.
+     */
+    using StoredCallback = std::function<void(uint32_t messageId, const std::string& filename, bool saved)>;
+
+    MessageWriter(NameBuilder nameBuilder, StoredCallback onStored);
+
+    ~MessageWriter();
+
+    MessageWriter(const MessageWriter&) = delete;
+    MessageWriter& operator=(const MessageWriter&) = delete;
+
+    /**
+     * @brief Hands the writing of finished messages to a pool of writer threads.
+     * @param writerPool The pool, or nullptr to write on the calling thread.
+     */
+    void setPool(std::shared_ptr<WriterPool> writerPool);
+
+    /**
+     * @brief Stores finished messages in a sink instead of one file per message.
+     * @param messageSink The sink, or nullptr to write one file per message.
+     */
+    void setSink(std::shared_ptr<MessageSink> messageSink);
+
+    /**
+     * @brief Starts a new message.
+     * @param messageId The ID of the message that is going to be written, 0 if not known yet.
+     */
+    void begin(uint32_t messageId);
+
+    /**
+     * @brief Sets the ID of the current message if it was not known in begin().
+     */
+    void setMessageId(uint32_t messageId);
+
+    /**
+     * @brief Appends the next chunk of the message.
+     */
+    void write(const char* data, size_t length);
+
+    /**
+     * @brief Tells whether the file name is still unknown, i.e. the headers are still being collected.
+     */
+    [[nodiscard]] bool needsHeaders() const;
+
+    /**
+     * @brief Returns the descriptor of the open output file the rest of the body can be written to.
+     * @return The file descriptor, or -1 if no file is open (not named yet, skipped or collected for the pool).
+     */
+    [[nodiscard]] int outputFd() const;
+
+    /**
+     * @brief Marks the current message as failed after writing to outputFd() did not succeed.
+     */
+    void writeFailed();
+
+    /**
+     * @brief Completes the current message, or queues it for a pool thread.
+     */
+    void finish();
+
+    /**
+     * @brief Drops the current message and any temporary file written for it.
+     */
+    void discard();
+
+    /**
+     * @brief Stores a message that was downloaded into a file of its own, e.g. in chunks.
+     *
+     * Without a pool or sink the file is renamed to the output name, so the message is not
+     * copied; otherwise it is read back and stored like a received message. The file is
+     * removed in either case unless renaming it fails.
+     * @param messageId The UID of the message.
+     * @param path The file holding the whole message, in the output directory.
+     */
+    void adopt(uint32_t messageId, const std::string& path);
+
+    /**
+     * @brief Waits until all messages queued for the pool are written.
+     */
+    void flush();
+
+private:
+    static constexpr size_t maxHeaderPeek = 64 * 1024; ///< headers longer than this are cut for naming
+
+    NameBuilder nameBuilder;    ///< builds the file name from the header block
+    StoredCallback onStored;    ///< reports messages that are on disk
+    uint32_t messageId = 0;     ///< ID of the message being written
+    std::string headerBuffer;   ///< bytes received before the file was opened
+    std::string headers;        ///< header block kept for naming a temporary file
+    std::string filename;       ///< output file of the current message
+    std::string tmpFilename;    ///< temporary file used while the ID is unknown
+    int fd = -1;                ///< output file of the current message, -1 if not open
+    bool opened = false;        ///< file name was resolved for the current message
+    bool skipped = false;       ///< message is discarded (already saved or not writable)
+    bool failed = false;        ///< writing the current message failed
+    bool existed = false;       ///< message is skipped as its file already exists
+
+    std::shared_ptr<WriterPool> pool;       ///< writes finished messages, nullptr to write directly
+    std::shared_ptr<MessageSink> sink;      ///< stores finished messages, nullptr for one file per message
+    std::string message;                    ///< the whole current message when a pool or sink is set
+    size_t pending = 0;                     ///< messages queued for the pool and not written yet
+    std::mutex pendingMutex;                ///< guards pending
+    std::condition_variable pendingDone;    ///< signalled when pending drops to zero
+
+    void open(const char* rest = nullptr, size_t restLength = 0);
+
+    void closeFile();
+
+    [[nodiscard]] bool collecting() const;
+
+    void submit();
+
+    static void store(const std::string& path, const std::string& data, uint32_t messageId, const StoredCallback& onStored);
+};
+
+#endif //IMAP_TLS_CLIENT_MESSAGEWRITER_H
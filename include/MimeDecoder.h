@@ -0,0 +1,167 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#ifndef IMAP_TLS_CLIENT_MIMEDECODER_H
+#define IMAP_TLS_CLIENT_MIMEDECODER_H
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Instruction sets the MIME decoders can use.
+ */
+enum class SimdLevel {
+    SCALAR,     ///< portable table-driven code
+    SSE4,       ///< 16-byte blocks with SSSE3 shuffles and SSE4.1 tests
+    AVX2        ///< 32-byte blocks
+};
+
+/**
+ * @brief Selects the instruction set of the base64 and quoted-printable decoders.
+ *
+ * The best level supported by the CPU is detected at startup; the decoders never use more.
+ */
+class MimeDecoder {
+public:
+    /**
+     * @brief Returns the best level supported by the CPU.
+     */
+    [[nodiscard]] static SimdLevel supportedLevel();
+
+    /**
+     * @brief Returns the level used by the decoders.
+     */
+    [[nodiscard]] static SimdLevel level();
+
+    /**
+     * @brief Limits the decoders to the given level, e.g. to compare the implementations.
+     * @param level The wanted level, lowered to supportedLevel() if the CPU lacks it.
+     */
+    static void setLevel(SimdLevel level);
+
+    [[nodiscard]] static const char* levelName(SimdLevel level);
+};
+
+/**
+ * @brief Streaming base64 decoder (RFC 2045, section 6.8).
+ *
+ * The input may be split at any byte. Line breaks and other characters outside the base64
+ * alphabet are skipped, and `=` ends the current group of four characters, so concatenated
+ * encodings decode as well. Runs of valid characters are decoded in SIMD blocks.
+ */
+class Base64Decoder {
+public:
+    /**
+     * @brief Largest output of decoding `size` input bytes, for sizing the buffer of update().
+     */
+    [[nodiscard]] static constexpr size_t maxDecodedSize(size_t size) {
+        return (size + 3) / 4 * 3;
+    }
+
+    /**
+     * @brief Decodes the next chunk of input.
+     * @param input The encoded bytes.
+     * @param size The number of encoded bytes.
+     * @param output Receives the decoded bytes, at least maxDecodedSize(size) bytes large.
+     * @return The number of bytes written to output.
+     */
+    size_t update(const char* input, size_t size, char* output);
+
+    /**
+     * @brief Decodes the next chunk of input and appends it to a string.
+     */
+    void update(std::string_view input, std::string& output);
+
+    /**
+     * @brief Ends the input, writes the bytes of an unpadded last group and resets the decoder.
+     * @param output Receives at most 2 bytes.
+     * @return The number of bytes written to output.
+     */
+    size_t finish(char* output);
+
+    /**
+     * @brief Ends the input and appends the bytes of an unpadded last group to a string.
+     */
+    void finish(std::string& output);
+
+    /**
+     * @brief Decodes a complete input.
+     */
+    [[nodiscard]] static std::string decode(std::string_view encoded);
+
+private:
+    uint32_t bits = 0;      ///< sextets of the unfinished group
+    int count = 0;          ///< number of sextets in bits
+};
+
+/**
+ * @brief Streaming quoted-printable decoder (RFC 2045, section 6.7).
+ *
+ * `=XY` escapes are decoded with upper- or lowercase hex digits, soft line breaks (`=` before
+ * CRLF or LF) are removed and whitespace at the end of a line is dropped. Malformed escapes are
+ * kept as they are instead of failing. In the Q encoding of RFC 2047 headers `_` stands for a
+ * space. The input may be split at any byte; the text between escapes and line breaks is found
+ * with SIMD compares and copied as a whole.
+ */
+class QuotedPrintableDecoder {
+public:
+    /**
+     * @param headerMode Decode the Q encoding of RFC 2047 (`_` is a space).
+     */
+    explicit QuotedPrintableDecoder(bool headerMode = false);
+
+    /**
+     * @brief Largest output of decoding the next `size` input bytes, for sizing the buffer of update().
+     */
+    [[nodiscard]] size_t maxDecodedSize(size_t size) const;
+
+    /**
+     * @brief Decodes the next chunk of input.
+     * @param input The encoded bytes.
+     * @param size The number of encoded bytes.
+     * @param output Receives the decoded bytes, at least maxDecodedSize(size) bytes large.
+     * @return The number of bytes written to output.
+     */
+    size_t update(const char* input, size_t size, char* output);
+
+    /**
+     * @brief Decodes the next chunk of input and appends it to a string.
+     */
+    void update(std::string_view input, std::string& output);
+
+    /**
+     * @brief Ends the input, writes an unfinished escape as it is and resets the decoder.
+     * @param output Receives at most 2 bytes.
+     * @return The number of bytes written to output.
+     */
+    size_t finish(char* output);
+
+    /**
+     * @brief Ends the input and appends an unfinished escape to a string.
+     */
+    void finish(std::string& output);
+
+    /**
+     * @brief Decodes a complete input.
+     * @param headerMode Decode the Q encoding of RFC 2047 (`_` is a space).
+     */
+    [[nodiscard]] static std::string decode(std::string_view encoded, bool headerMode = false);
+
+private:
+    enum class State {
+        TEXT,           ///< outside an escape
+        EQUALS,         ///< after `=`
+        HEX,            ///< after `=` and one hex digit
+        SOFT_BREAK      ///< after `=` and CR
+    };
+
+    bool headerMode;
+    State state = State::TEXT;
+    char firstDigit = 0;        ///< the hex digit read in State::HEX
+    std::string whitespace;     ///< whitespace at the end of the previous chunk, dropped at a line break
+};
+
+#endif //IMAP_TLS_CLIENT_MIMEDECODER_H
@@ -0,0 +1,62 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#ifndef IMAP_TLS_CLIENT_PACKSINK_H
+#define IMAP_TLS_CLIENT_PACKSINK_H
+
+#include "MessageSink.h"
+#include <string>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+
+/**
+ * @brief Stores all messages of one run in a single indexed pack file `messages-<n>.pack`.
+ *
+ * The file starts with an offset table followed by the concatenated messages
+ * (all numbers little-endian):
+ *
+ *     "IMAPPACK"                       8 bytes magic
+ *     count                            uint32
+ *     count x (uid, offset, length)    uint32, uint64, uint64; offset from the end of the table
+ *     messages
+ *
+ * As the table size is known only at the end, the messages are first appended to a
+ * hidden data file in large writes; close() writes the table and copies the data behind it.
+ */
+class PackSink : public MessageSink {
+public:
+    explicit PackSink(std::string outDir);
+
+    ~PackSink() override;
+
+    Result store(uint32_t messageId, std::string_view message, std::string& name) override;
+
+    void close() override;
+
+private:
+    static constexpr size_t flushSize = 4 * 1024 * 1024;   ///< buffered bytes written at once
+
+    struct Entry {
+        uint32_t uid;
+        uint64_t offset;
+        uint64_t length;
+    };
+
+    std::string outDir;         ///< directory of the pack file
+    std::string path;           ///< the pack file, reserved on the first message
+    std::string dataPath;       ///< hidden file collecting the messages
+    int dataFd = -1;            ///< the data file
+    uint64_t dataSize = 0;      ///< bytes stored so far, including the buffer
+    std::string buffer;         ///< messages not written to the data file yet
+    std::vector<Entry> entries; ///< the offset table
+    bool failed = false;        ///< a write failed, reported by close()
+    std::mutex mutex;           ///< guards all members above
+
+    bool reserve();
+
+    void flush();
+};
+
+#endif //IMAP_TLS_CLIENT_PACKSINK_H
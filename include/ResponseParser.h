@@ -0,0 +1,105 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#ifndef IMAP_TLS_CLIENT_RESPONSEPARSER_H
+#define IMAP_TLS_CLIENT_RESPONSEPARSER_H
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "IMAPResponceType.h"
+
+/**
+ * @brief Collection of small single-pass scanners for IMAP response lines.
+ *
+ * The line functions work on a single response line without the trailing CRLF
+ * and never allocate, so they can be used directly on the receive path.
+ */
+class ResponseParser {
+public:
+    /**
+     * @brief Checks whether the line ends with an IMAP literal announcement, e.g. `{12345}`.
+     * @param line The response line without CRLF.
+     * @param size Receives the literal size in bytes.
+     * @return True if the line announces a literal.
+     */
+    static bool literalSize(std::string_view line, size_t& size);
+
+    /**
+     * @brief Parses the message number of an untagged `* N FETCH` response.
+     * @param line The response line.
+     * @param messageId Receives the message number.
+     * @return True if the line is an untagged FETCH response.
+     * @throws std::runtime_error if the message number does not fit into 32 bits.
+     */
+    static bool fetchId(std::string_view line, uint32_t& messageId);
+
+    /**
+     * @brief Finds the `UID n` item in (a part of) an untagged FETCH response.
+     * @param text The FETCH response line or the part of it following a literal.
+     * @param uid Receives the UID.
+     * @return True if the text contains the UID item.
+     * @throws std::runtime_error if the UID does not fit into 32 bits.
+     */
+    static bool fetchUid(std::string_view text, uint32_t& uid);
+
+    /**
+     * @brief Finds a numeric response code such as `[UIDVALIDITY 3857529045]` in a response.
+     * @param response The response text.
+     * @param code The name of the response code, e.g. "UIDNEXT".
+     * @param value Receives the number.
+     * @return True if the response contains the code.
+     * @throws std::runtime_error if the number does not fit into 32 bits.
+     */
+    static bool responseCode(std::string_view response, std::string_view code, uint32_t& value);
+
+    /**
+     * @brief Determines the status of a tagged completion line, e.g. `A5 OK Fetch completed`.
+     * @param line The response line.
+     * @param tag The tag of the command the completion is expected for.
+     * @return OK, NO or BAD for a completion of the given tag, UNKNOWN otherwise.
+     */
+    static IMAPResponseType taggedStatus(std::string_view line, std::string_view tag);
+
+    /**
+     * @brief Collects the message numbers of all untagged `* SEARCH` lines of a response.
+     * @param response The response text, one or more CRLF terminated lines.
+     * @param ids Receives the message numbers in the order sent by the server.
+     * @return True if the response contained a SEARCH line.
+     * @throws std::runtime_error if a number does not fit into 32 bits.
+     */
+    static bool searchIds(std::string_view response, std::vector<uint32_t>& ids);
+
+    /**
+     * @brief Parses an untagged `* LIST (flags) "delimiter" mailbox` line.
+     * @param line The response line.
+     * @param name Receives the unquoted mailbox name; left empty if the name is sent as a literal.
+     * @param selectable Set to false for mailboxes flagged \Noselect or \NonExistent.
+     * @return True if the line is an untagged LIST response.
+     */
+    static bool listEntry(std::string_view line, std::string& name, bool& selectable);
+
+    /**
+     * @brief Checks whether a response announces a capability, either in an untagged
+     *        `* CAPABILITY` line or in a `[CAPABILITY ...]` response code.
+     * @param response The response text.
+     * @param capability The capability name, e.g. "COMPRESS=DEFLATE"; compared case-insensitively.
+     * @return True if the capability is listed.
+     */
+    static bool hasCapability(std::string_view response, std::string_view capability);
+
+    /**
+     * @brief Tells whether a response contains any capability list at all.
+     */
+    static bool listsCapabilities(std::string_view response);
+
+    /**
+     * @brief Determines the status of the server greeting (`* OK`, `* PREAUTH` or `* BYE`).
+     */
+    static IMAPResponseType greetingStatus(std::string_view line);
+};
+
+#endif //IMAP_TLS_CLIENT_RESPONSEPARSER_H
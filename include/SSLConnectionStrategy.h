@@ -6,11 +6,13 @@
 #define IMAP_TLS_CLIENT_SSLCONNECTIONSTRATEGY_H
 
 #include "ConnectionStrategy.h"
+#include "Stats.h"
 #include "SSLWrapper.h"
 #include <string>
 #include <stdexcept>
 #include <netdb.h>
 #include <unistd.h>
+#include <poll.h>
 
 /**
  * @brief Implements a strategy for establishing an SSL/TLS connection with the IMAP server.
@@ -31,15 +33,13 @@ public:
     SSLConnectionStrategy(const std::string& server, int port, const std::string& certFile = "", const std::string& certDir = "")
             : ssl(nullptr), sockfd(-1), server(server), port(port), certFile(certFile), certDir(certDir) {}
 
-    void connect() override {
-        SSLWrapper::getInstance().initSSL();
+    ~SSLConnectionStrategy() override {
+        disconnect();
+    }
 
-        if (!certFile.empty()) {
-            SSLWrapper::getInstance().setCertificate(certFile);
-        }
-        if (!certDir.empty()) {
-            SSLWrapper::getInstance().setCertDirectory(certDir);
-        }
+    void connect() override {
+        // loaded once per process, later connections reuse the shared context
+        SSLWrapper::getInstance().prepareContext(certFile, certDir);
 
         struct addrinfo hints{};
         struct addrinfo* result;
@@ -48,11 +48,16 @@ public:
         hints.ai_family = AF_UNSPEC;
         hints.ai_socktype = SOCK_STREAM;
 
-        int status = getaddrinfo(server.c_str(), std::to_string(port).c_str(), &hints, &result);
+        int status;
+        {
+            Stats::Timer timer(Stats::Phase::DNS);
+            status = getaddrinfo(server.c_str(), std::to_string(port).c_str(), &hints, &result);
+        }
         if (status != 0) {
             throw std::runtime_error("getaddrinfo error: " + std::string(gai_strerror(status)));
         }
 
+        Stats::Timer connectTimer(Stats::Phase::TCP_CONNECT);
         struct addrinfo* p;
         for (p = result; p != nullptr; p = p->ai_next) {
             sockfd = socket(p->ai_family, p->ai_socktype, p->ai_protocol);
@@ -65,22 +70,33 @@ public:
             }
 
             close(sockfd);
+            sockfd = -1;
         }
 
         freeaddrinfo(result);
 
         if (p == nullptr) {
+            connectTimer.cancel();
             throw std::runtime_error("Failed to connect to server");
         }
+        connectTimer.stop();
 
-        ssl = SSLWrapper::getInstance().createSSLConnection(sockfd);
+        ssl = SSLWrapper::getInstance().createSSLConnection(sockfd, server, port);
         if (!ssl) {
             close(sockfd);
+            sockfd = -1;
             throw std::runtime_error("Failed to establish SSL connection");
         }
+
+        Stats::getInstance().add(Stats::Counter::CONNECTIONS);
+        resetBuffer();
     }
 
 
+    [[nodiscard]] int getSocket() const override {
+        return sockfd;
+    }
+
     void disconnect() override {
         if (ssl) {
             SSLWrapper::getInstance().closeSSLConnection(ssl);
@@ -92,14 +108,23 @@ public:
         }
     }
 
-    void sendCommand(std::string command) override {
-        SSLWrapper::getInstance().sendData(ssl, command);
+protected:
+    void transmit(const char* data, size_t size) override {
+        int result;
+        while ((result = SSLWrapper::getInstance().sendData(ssl, std::string_view(data, size))) <= 0) {
+            // a non-blocking socket has to be waited for, then the write is repeated with the same data
+            int error = SSL_get_error(ssl, result);
+            if (error != SSL_ERROR_WANT_WRITE && error != SSL_ERROR_WANT_READ) {
+                throw std::runtime_error("Failed to send command");
+            }
+            struct pollfd ready{sockfd, static_cast<short>(error == SSL_ERROR_WANT_WRITE ? POLLOUT : POLLIN), 0};
+            poll(&ready, 1, -1);
+        }
     }
 
-    std::string readResponse() const override {
-        std::string response;
-        SSLWrapper::getInstance().receiveData(ssl, response);
-        return response;
+    size_t receive(char* data, size_t size) override {
+        size_t received = SSLWrapper::getInstance().receiveData(ssl, data, size);
+        return received == SSLWrapper::noData ? wouldBlock : received;
     }
 };
 
@@ -8,6 +8,11 @@
 #include <openssl/ssl.h>
 #include <openssl/err.h>
 #include <string>
+#include <string_view>
+#include <mutex>
+#include <map>
+#include <set>
+#include <cstdint>
 
 class SSLWrapper {
 public:
@@ -19,18 +24,58 @@ public:
 
     /**
      * @brief Initializes the SSL library and loads necessary algorithms and error strings.
+     *
+     * Only the first call creates the context, so concurrent connections share it.
      */
     void initSSL();
 
+    /**
+     * @brief Initializes SSL and loads the certificate file and directory into the shared context.
+     *
+     * Every file and directory is loaded only once per process, so connections and batch jobs
+     * can call this before each connection at no cost; call it at startup to build the context
+     * and the trust store before the first connection.
+     * @param certFile Path to the certificate file, empty if none.
+     * @param certDir Directory with the trusted certificates, empty if none.
+     * @throws std::runtime_error if the context cannot be created or a certificate cannot be loaded.
+     */
+    void prepareContext(const std::string& certFile, const std::string& certDir);
+
     /**
      * @brief Creates an SSL connection over an existing TCP socket.
+     *
+     * A session cached for the same server and port is offered for resumption,
+     * and new sessions sent by the server are stored in the cache.
+     *
      * @param socket The file descriptor of the TCP socket.
+     * @param server The server name, also sent as SNI unless it is an IP address.
+     * @param port The server port.
      * @return Pointer to the SSL structure, or nullptr if the connection fails.
      */
-    SSL* createSSLConnection(int socket);
+    SSL* createSSLConnection(int socket, const std::string& server, int port);
+
+    /**
+     * @brief Prepares an SSL connection over a socket without doing the handshake.
+     *
+     * Sets SNI and the cached session like createSSLConnection(); the caller runs
+     * SSL_connect() itself, e.g. on a non-blocking socket.
+     * @return Pointer to the SSL structure, or nullptr if it cannot be created.
+     */
+    SSL* prepareSSLConnection(int socket, const std::string& server, int port);
+
+    /**
+     * @brief Loads the TLS session cache from a file and saves it there again on cleanup.
+     * @param path Path to the session cache file; a missing file is treated as an empty cache.
+     */
+    void setSessionCacheFile(const std::string& path);
 
     /**
-     * @brief Cleans up the SSL context.
+     * @brief Enables reporting of the handshake time and session resumption on stderr.
+     */
+    void setVerbose(bool verbose);
+
+    /**
+     * @brief Saves the session cache if a cache file is set and cleans up the SSL context.
      */
     void cleanupSSL();
 
@@ -46,32 +91,44 @@ public:
      * @param data The data to be sent.
      * @return The number of bytes sent.
      */
-    int sendData(SSL* ssl, const std::string& data);
+    int sendData(SSL* ssl, std::string_view data);
+
+    static constexpr size_t noData = SIZE_MAX;  ///< returned by receiveData() when a non-blocking socket has no data
 
     /**
      * @brief Receives data from an SSL connection.
      * @param ssl The SSL structure representing the connection.
-     * @param buffer The string to store received data.
-     * @return The number of bytes received.
+     * @param buffer The buffer to store received data.
+     * @param size The capacity of the buffer.
+     * @return The number of bytes received, 0 if the peer closed the connection, noData if the
+     *         socket is non-blocking and no data is available.
+     * @throws std::runtime_error if reading fails.
      */
-    int receiveData(SSL* ssl, std::string& buffer);
+    size_t receiveData(SSL* ssl, char* buffer, size_t size);
 
     /**
      * @brief Loads a certificate file for SSL verification.
      * @param certFile Path to the certificate file.
-     * @throws Terminates the program if the certificate cannot be loaded.
+     * @throws std::runtime_error if the certificate cannot be loaded.
      */
     void setCertificate(const std::string& certFile);
 
     /**
      * @brief Sets the directory containing certificates for SSL verification.
      * @param certDir Path to the certificate directory.
-     * @throws Terminates the program if the directory cannot be loaded.
+     * @throws std::runtime_error if the directory cannot be loaded.
      */
     void setCertDirectory(const std::string& certDir);
 
 private:
     SSL_CTX* ctx;
+    std::mutex mutex;   ///< guards the context setup shared by concurrent connections
+    std::set<std::string> loadedCertificates;       ///< certificate files already in the context
+    std::set<std::string> loadedCertDirectories;    ///< certificate directories already in the trust store
+    std::mutex sessionMutex;                        ///< guards the session cache
+    std::map<std::string, SSL_SESSION*> sessions;   ///< resumable sessions keyed by "server:port"
+    std::string sessionCacheFile;                   ///< file the cache is persisted in, empty if none
+    bool verbose = false;                           ///< report handshakes on stderr
 
     SSLWrapper();
     ~SSLWrapper();
@@ -81,9 +138,46 @@ private:
 
     /**
      * @brief Initializes the SSL context using TLS client method.
-     * @throws Terminates the program if context creation fails.
+     * @throws std::runtime_error if context creation fails.
      */
     void initContext();
+
+    void initLocked();
+
+    void loadCertificate(const std::string& certFile);
+
+    void loadCertDirectory(const std::string& certDir);
+
+    /**
+     * @brief Called by OpenSSL when the server issues a new session; stores it in the cache.
+     * @return 1 as the cache keeps the reference to the session.
+     */
+    static int newSessionCallback(SSL* ssl, SSL_SESSION* session);
+
+    /**
+     * @brief Stores a session under the given key, replacing the previous one.
+     */
+    void storeSession(const std::string& key, SSL_SESSION* session);
+
+    /**
+     * @brief Returns a new reference to the cached session for the key, or nullptr.
+     */
+    SSL_SESSION* findSession(const std::string& key);
+
+    /**
+     * @brief Reads the session cache file, skipping expired sessions.
+     */
+    void loadSessions();
+
+    /**
+     * @brief Writes all resumable sessions to the session cache file.
+     */
+    void saveSessions();
+
+    /**
+     * @brief Releases all cached sessions.
+     */
+    void clearSessions();
 };
 
 #endif //IMAP_TLS_CLIENT_SSLWRAPPER_H
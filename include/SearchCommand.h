@@ -6,21 +6,20 @@
 #define IMAP_TLS_CLIENT_SEARCHCOMMAND_H
 
 #include "IMAPCommand.h"
+#include "SearchCriteria.h"
 #include <string>
 
 /**
- * @brief Represents the IMAP SEARCH command.
+ * @brief Represents the IMAP UID SEARCH command.
  */
 class SearchCommand : public IMAPCommand {
-    bool onlyNew;
+    SearchCriteria criteria;
 
 public:
-    SearchCommand(bool onlyNew) : onlyNew(onlyNew) {}
+    explicit SearchCommand(SearchCriteria criteria) : criteria(std::move(criteria)) {}
 
     std::string generate() const override {
-        std::string searchPart = onlyNew ? "UNSEEN" : "ALL";
-
-        return "SEARCH " + searchPart + "\r\n";
+        return "UID SEARCH " + criteria.toString() + "\r\n";
     }
 
     int getType() const override {return SEARCH;}
@@ -0,0 +1,123 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#ifndef IMAP_TLS_CLIENT_SEARCHCRITERIA_H
+#define IMAP_TLS_CLIENT_SEARCHCRITERIA_H
+
+#include <string>
+#include <vector>
+#include <ctime>
+#include <cstddef>
+#include <cstdint>
+#include "ArgParser.h"
+
+/**
+ * @brief Builds the search keys of a UID SEARCH command (RFC 3501, section 6.4.4).
+ *
+ * Every added key narrows the result (the keys are ANDed); either() and negate() combine whole
+ * criteria with OR and NOT. Strings are sent as quoted strings, or as literals (`{n}` followed by
+ * the raw bytes) if they contain 8-bit characters or line breaks; 8-bit text also adds
+ * `CHARSET UTF-8`. A literal has to be sent separately after the server's continuation request
+ * unless the server supports LITERAL+ (see IMAPCommand::splitAtLiterals()).
+ */
+class SearchCriteria {
+public:
+    /**
+     * @brief Matches the UIDs of a sequence set, e.g. `100:200,300` or `500:*`.
+     * @throws std::invalid_argument if the set is malformed.
+     */
+    SearchCriteria& uid(const std::string& set);
+
+    SearchCriteria& unseen();
+
+    /**
+     * @brief Matches messages whose internal date is on or after the day of the time (UTC).
+     */
+    SearchCriteria& since(std::time_t time);
+
+    /**
+     * @brief Matches messages whose internal date is before the day of the time (UTC).
+     */
+    SearchCriteria& before(std::time_t time);
+
+    /**
+     * @brief Matches messages larger than the given number of bytes.
+     */
+    SearchCriteria& larger(size_t size);
+
+    /**
+     * @brief Matches messages smaller than the given number of bytes.
+     */
+    SearchCriteria& smaller(size_t size);
+
+    /**
+     * @brief Matches messages whose From field contains the text (any case).
+     */
+    SearchCriteria& from(const std::string& text);
+
+    /**
+     * @brief Matches messages with the header field containing the text; an empty text matches any message with the field.
+     * @throws std::invalid_argument if the field name is not a valid header field name.
+     */
+    SearchCriteria& header(const std::string& field, const std::string& text);
+
+    /**
+     * @brief Adds all keys of other criteria.
+     */
+    SearchCriteria& add(const SearchCriteria& other);
+
+    /**
+     * @brief Matches messages not matching the other criteria.
+     */
+    SearchCriteria& negate(const SearchCriteria& other);
+
+    /**
+     * @brief Returns criteria matching messages that match at least one of the two.
+     */
+    [[nodiscard]] static SearchCriteria either(const SearchCriteria& first, const SearchCriteria& second);
+
+    /**
+     * @brief Builds the criteria given on the command line: `--uid`, `--since`, `--before`, `--larger`,
+     *        `--smaller`, `--from` (several are ORed) and `--header`.
+     *
+     * `--max-size` and the `--received-*` filters are added as coarser server-side keys too, so
+     * that most messages failing them are not even listed; the exact check stays with MessageTable.
+     */
+    [[nodiscard]] static SearchCriteria fromConfig(const ArgParser::Config& config);
+
+    /**
+     * @brief Builds the criteria of a sync: the UIDs from firstUid on, UNSEEN with `-n` and fromConfig().
+     */
+    [[nodiscard]] static SearchCriteria forSync(const ArgParser::Config& config, uint32_t firstUid);
+
+    [[nodiscard]] bool empty() const;
+
+    /**
+     * @brief Tells whether a string is sent as a literal, which needs LITERAL+ to be sent without waiting.
+     */
+    [[nodiscard]] bool hasLiterals() const;
+
+    /**
+     * @brief Returns the search keys, `ALL` if there are none, preceded by `CHARSET UTF-8` for 8-bit text.
+     */
+    [[nodiscard]] std::string toString() const;
+
+    /**
+     * @brief Formats the day of a time (UTC) as an IMAP date, e.g. `1-Feb-2024`.
+     */
+    [[nodiscard]] static std::string formatDate(std::time_t time);
+
+private:
+    std::vector<std::string> keys;  ///< search keys, combined with AND
+    bool utf8 = false;              ///< a string contains 8-bit characters
+    bool literals = false;          ///< a string is sent as a literal
+
+    SearchCriteria& key(std::string text);
+
+    void addString(std::string& key, const std::string& value);
+
+    [[nodiscard]] std::string group() const;
+};
+
+#endif //IMAP_TLS_CLIENT_SEARCHCRITERIA_H
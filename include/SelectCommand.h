@@ -16,7 +16,7 @@ public:
     explicit SelectCommand(const std::string& mailbox) : mailbox(mailbox) {}
 
     std::string generate() const override {
-        return "SELECT " + mailbox + "\r\n";
+        return "SELECT " + quote(mailbox) + "\r\n";
     }
 
     int getType() const override {return SELECT;}
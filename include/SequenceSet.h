@@ -0,0 +1,32 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#ifndef IMAP_TLS_CLIENT_SEQUENCESET_H
+#define IMAP_TLS_CLIENT_SEQUENCESET_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief Builds IMAP sequence sets (e.g. `3:17,20,45:900`) from lists of message numbers.
+ */
+class SequenceSet {
+public:
+    /**
+     * @brief Longest sequence set put into a single command. Keeps the whole command line
+     *        below the ~8 KB limit servers are expected to accept (RFC 7162, section 4).
+     */
+    static constexpr size_t maxLength = 8000;
+
+    /**
+     * @brief Compresses message numbers into ranges and splits them into sets of limited length.
+     * @param ids Message numbers in any order, duplicates are allowed.
+     * @param maxSetLength The maximal length of a single returned set.
+     * @return Sequence sets covering exactly the given numbers, in ascending order.
+     */
+    static std::vector<std::string> build(std::vector<uint32_t> ids, size_t maxSetLength = maxLength);
+};
+
+#endif //IMAP_TLS_CLIENT_SEQUENCESET_H
@@ -0,0 +1,44 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#ifndef IMAP_TLS_CLIENT_SHARDEDFETCH_H
+#define IMAP_TLS_CLIENT_SHARDEDFETCH_H
+
+#include <vector>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include "ArgParser.h"
+#include "IMAPClient.h"
+
+/**
+ * @brief Downloads one mailbox over several parallel connections.
+ *
+ * The SEARCH result of an already selected client is split into `connections` shards of
+ * consecutive messages (so every shard still compresses into a few sequence sets). The
+ * first shard is fetched by the given client, every other shard by its own connection that
+ * is authenticated and SELECTs the same mailbox. The saved counts of all shards are merged.
+ */
+class ShardedFetch {
+public:
+    explicit ShardedFetch(ArgParser::Config config);
+
+    /**
+     * @brief Fetches all messages found by the client's SEARCH.
+     * @param client Connected client with the mailbox selected and SEARCH done.
+     * @return The amount of saved messages across all shards.
+     * @throws The first exception thrown by any of the shards, after all shards have finished.
+     */
+    int run(IMAPClient& client);
+
+    static std::vector<std::vector<uint32_t>> split(std::vector<uint32_t> ids, size_t shards);
+
+private:
+    ArgParser::Config config;       ///< config with cli parameters
+    std::atomic<int> progress{0};   ///< messages saved by all shards so far
+
+    void fetchShard(std::vector<uint32_t> ids, const IMAPClient& searched);
+};
+
+#endif //IMAP_TLS_CLIENT_SHARDEDFETCH_H
@@ -0,0 +1,162 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#ifndef IMAP_TLS_CLIENT_STATS_H
+#define IMAP_TLS_CLIENT_STATS_H
+
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+/**
+ * @brief Process-wide instrumentation: per-phase latencies, byte counters and syscall counts.
+ *
+ * The connection strategies, the clients and the message writers report into the single
+ * instance; all counters are relaxed atomics, so parallel connections, event loops and writer
+ * threads share them without locks. Nothing is measured until enable() is called, a disabled
+ * Timer does not even read the clock.
+ *
+ * Every phase keeps the number of samples, their total and maximum, and a histogram of
+ * power-of-two buckets from which the percentiles of the report are estimated.
+ */
+class Stats {
+public:
+    /**
+     * @brief Steps of a sync whose latency is measured.
+     */
+    enum class Phase {
+        DNS,            ///< name lookup
+        TCP_CONNECT,    ///< TCP three-way handshake
+        TLS_HANDSHAKE,  ///< TLS handshake
+        GREETING,       ///< server greeting after the connection is established
+        AUTH,           ///< LOGIN, including CAPABILITY and COMPRESS
+        MAILBOX_SELECT, ///< SELECT
+        MAILBOX_SEARCH, ///< UID SEARCH
+        METADATA_FETCH, ///< UID FETCH of sizes, dates and envelopes for a filter
+        MESSAGE_FETCH,  ///< all UID FETCH commands of a mailbox, including the disk writes
+        DISK_WRITE,     ///< one write of message data to disk
+        QUIT,           ///< LOGOUT
+        COUNT
+    };
+
+    /**
+     * @brief Counted events, mostly bytes and system calls.
+     */
+    enum class Counter {
+        BYTES_RECEIVED,     ///< bytes received from the socket
+        RESPONSE_BYTES,     ///< bytes of responses, after decompression with COMPRESS=DEFLATE
+        BYTES_SENT,         ///< bytes sent to the socket
+        RECEIVE_CALLS,      ///< recv() or SSL_read() calls returning data
+        SEND_CALLS,         ///< send() or SSL_write() calls
+        SPLICE_CALLS,       ///< splice() calls moving literals into files
+        DISK_BYTES,         ///< bytes written to disk
+        DISK_WRITE_CALLS,   ///< write(), writev(), splice() or copy_file_range() calls writing to disk
+        MESSAGES_SAVED,     ///< messages written to disk
+        CONNECTIONS,        ///< connections established
+        COUNT
+    };
+
+    /**
+     * @brief Measures the time until destruction and adds it to a phase, if stats are enabled.
+     */
+    class Timer {
+    public:
+        explicit Timer(Phase phase);
+
+        ~Timer();
+
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+
+        /**
+         * @brief Records the measurement now instead of at destruction.
+         */
+        void stop();
+
+        /**
+         * @brief Drops the measurement, e.g. when the phase failed.
+         */
+        void cancel();
+
+    private:
+        Phase phase;
+        bool running;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    static Stats& getInstance();
+
+    /**
+     * @brief Starts collecting; also sets the start of the wall time used for the rates.
+     */
+    void enable();
+
+    [[nodiscard]] bool isEnabled() const {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Adds one latency sample to a phase.
+     */
+    void record(Phase phase, std::chrono::nanoseconds elapsed);
+
+    void add(Counter counter, uint64_t value = 1) {
+        if (isEnabled()) {
+            counters[static_cast<size_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Counts one disk write of the given size taking the time since start.
+     */
+    void diskWrite(uint64_t bytes, std::chrono::steady_clock::time_point start);
+
+    /**
+     * @brief Returns the current time if stats are enabled, for diskWrite(); otherwise a zero time point.
+     */
+    [[nodiscard]] std::chrono::steady_clock::time_point now() const;
+
+    [[nodiscard]] uint64_t get(Counter counter) const;
+
+    /**
+     * @brief Prints the human readable summary.
+     */
+    void printSummary(std::ostream& out) const;
+
+    /**
+     * @brief Writes all values as one JSON object.
+     */
+    void writeJson(std::ostream& out) const;
+
+private:
+    static constexpr size_t buckets = 48;   ///< histogram buckets, bucket i holds samples below 2^i ns
+
+    struct PhaseStats {
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> totalNs{0};
+        std::atomic<uint64_t> maxNs{0};
+        std::array<std::atomic<uint64_t>, buckets> histogram{};
+    };
+
+    std::atomic<bool> enabled{false};
+    std::chrono::steady_clock::time_point startedAt;
+    std::array<PhaseStats, static_cast<size_t>(Phase::COUNT)> phases;
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(Counter::COUNT)> counters{};
+
+    Stats() = default;
+
+    [[nodiscard]] double percentileMs(const PhaseStats& phase, double fraction) const;
+
+    [[nodiscard]] double elapsedSeconds() const;
+
+    static const char* phaseName(Phase phase);
+
+    static const char* counterName(Counter counter);
+
+    static long peakRssKb();
+};
+
+#endif //IMAP_TLS_CLIENT_STATS_H
@@ -0,0 +1,127 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#ifndef IMAP_TLS_CLIENT_SYNCSTATE_H
+#define IMAP_TLS_CLIENT_SYNCSTATE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <mutex>
+
+/**
+ * @brief Persisted state of the previous syncs of one mailbox into one output directory.
+ *
+ * Holds the UIDVALIDITY the UIDs belong to, the highest UID up to which the mailbox was
+ * completely synced and an index of the UIDs saved so far with their file names.
+ * The state is stored as a small text file in the output directory:
+ *
+ *     UIDVALIDITY <n>
+ *     HIGHESTUID <n>
+ *     <uid> <file name>
+ *     ...
+ *
+ * Messages may be added from several connections at once (see ShardedFetch).
+ *
+ * A sync of the mailbox goes through beginSync() after SELECT, takeFound() with the SEARCH
+ * result and commit() at the end; this is shared by IMAPClient, AsyncSession and AsyncIMAPClient.
+ */
+class SyncState {
+public:
+    explicit SyncState(std::string path);
+
+    /**
+     * @brief Returns the path of the state file of an output directory.
+     *
+     * Header-only syncs and each output format keep their own state,
+     * e.g. `.imapcl-state-headers` or `.imapcl-state-mbox`.
+     */
+    static std::string pathFor(const std::string& outDir, bool onlyHeaders, const std::string& format);
+
+    /**
+     * @brief Loads the state of an output directory (see pathFor()) and validates it against the selected mailbox.
+     * @throws std::runtime_error if the state file is malformed.
+     */
+    static std::shared_ptr<SyncState> open(const std::string& outDir, bool onlyHeaders, const std::string& format,
+                                           uint32_t uidValidity);
+
+    /**
+     * @brief Loads the state file; a missing file means an empty state.
+     * @throws std::runtime_error if the file exists but is malformed.
+     */
+    void load();
+
+    /**
+     * @brief Writes the state into a temporary file and renames it over the state file.
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    void save();
+
+    /**
+     * @brief Drops all known UIDs if they belong to a different UIDVALIDITY.
+     * @param uidValidity The UIDVALIDITY reported by SELECT.
+     */
+    void validate(uint32_t uidValidity);
+
+    [[nodiscard]] uint32_t getHighestUid() const;
+
+    void setHighestUid(uint32_t uid);
+
+    /**
+     * @brief Starts a sync after SELECT.
+     * @param uidNext The UIDNEXT reported by SELECT, 0 if not reported.
+     * @return False if no message arrived since the last sync, so SEARCH can be skipped.
+     */
+    bool beginSync(uint32_t uidNext);
+
+    /**
+     * @brief Returns the first UID not covered by the previous syncs, the start of the SEARCH range.
+     */
+    [[nodiscard]] uint32_t getFirstUid() const;
+
+    /**
+     * @brief Takes the UIDs found by SEARCH and returns those still to be fetched.
+     *
+     * The sync covers all found UIDs, as `n:*` always matches the newest message even if its UID
+     * is lower than n. With other search criteria the messages they skip are never listed, so
+     * the sync does not advance at all.
+     * @param found The UIDs of the SEARCH response.
+     * @param narrowed True if the search had criteria besides the UID range.
+     * @return The UIDs from getFirstUid() on that were not saved before, in the order of found.
+     */
+    std::vector<uint32_t> takeFound(const std::vector<uint32_t>& found, bool narrowed);
+
+    /**
+     * @brief Keeps the sync from advancing to a UID, e.g. one rejected by a filter.
+     */
+    void holdBack(uint32_t uid);
+
+    /**
+     * @brief Ends the sync and saves the state.
+     *
+     * The highest synced UID does not advance to the first UID returned by takeFound() that was not
+     * stored (add() was not called for it, e.g. as writing it failed), so the next sync retries it.
+     * @param advance True to raise the highest synced UID over what the sync covered, false to keep it (e.g. with `-n`).
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    void commit(bool advance);
+
+    [[nodiscard]] bool contains(uint32_t uid) const;
+
+    void add(uint32_t uid, const std::string& filename);
+
+private:
+    std::string path;                                   ///< path of the state file
+    uint32_t uidValidity = 0;                           ///< UIDVALIDITY the UIDs belong to
+    uint32_t highestUid = 0;                            ///< all messages up to this UID were synced
+    std::unordered_map<uint32_t, std::string> index;    ///< saved UIDs and their file names
+    uint32_t firstUid = 1;                              ///< first UID searched by the running sync
+    uint32_t coveredUpTo = 0;                           ///< highest UID covered by the running sync
+    std::vector<uint32_t> pending;                      ///< UIDs the running sync is to store
+    mutable std::mutex mutex;                           ///< guards index when fetching in parallel
+};
+
+#endif //IMAP_TLS_CLIENT_SYNCSTATE_H
@@ -6,72 +6,245 @@
 #define IMAP_TLS_CLIENT_TCPCONNECTIONSTRATEGY_H
 
 #include "ConnectionStrategy.h"
+#include "Stats.h"
 #include <sys/socket.h>
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <cerrno>
 #include <string>
 #include <stdexcept>
+#include <algorithm>
 
 /**
  * @brief Implements a strategy for establishing a plain TCP connection with the IMAP server.
  *
  * The TCPConnectionStrategy class handles establishing an unencrypted connection
  * to the IMAP server, sending commands, and reading responses over a plain TCP socket.
+ * On Linux, message literals are moved from the socket to their files with splice().
  */
 class TCPConnectionStrategy : public ConnectionStrategy {
 private:
     int sockfd;         ///< socket file descriptor.
     std::string server; ///< The IMAP server address.
     int port;           ///< The server port.
+    int pipefd[2];      ///< pipe used to splice literals into files, -1 until first used.
+    size_t pipeSize;    ///< capacity of the pipe.
 
 public:
     TCPConnectionStrategy(const std::string& server, int port)
-            : sockfd(-1), server(server), port(port) {}
+            : sockfd(-1), server(server), port(port), pipefd{-1, -1}, pipeSize(0) {}
+
+    ~TCPConnectionStrategy() override {
+        disconnect();
+    }
 
     void connect() override {
-        struct sockaddr_in server_addr{};
-        struct hostent* host = gethostbyname(server.c_str());
-        if (host == nullptr) {
+        struct addrinfo hints{};
+        struct addrinfo* result;
+
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+
+        // getaddrinfo is used instead of gethostbyname as it is safe to call from parallel connections
+        int status;
+        {
+            Stats::Timer timer(Stats::Phase::DNS);
+            status = getaddrinfo(server.c_str(), std::to_string(port).c_str(), &hints, &result);
+        }
+        if (status != 0) {
             throw std::runtime_error("Invalid server address");
         }
 
-        sockfd = socket(AF_INET, SOCK_STREAM, 0);
-        if (sockfd < 0) {
-            throw std::runtime_error("Error creating socket");
-        }
+        Stats::Timer connectTimer(Stats::Phase::TCP_CONNECT);
+        struct addrinfo* p;
+        for (p = result; p != nullptr; p = p->ai_next) {
+            sockfd = socket(p->ai_family, p->ai_socktype, p->ai_protocol);
+            if (sockfd < 0) {
+                continue;
+            }
 
-        server_addr.sin_family = AF_INET;
-        server_addr.sin_port = htons(port);
-        server_addr.sin_addr = *((struct in_addr*) host->h_addr);
+            if (::connect(sockfd, p->ai_addr, p->ai_addrlen) == 0) {
+                break;
+            }
 
-        if (::connect(sockfd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
             close(sockfd);
+            sockfd = -1;
+        }
+
+        freeaddrinfo(result);
+
+        if (p == nullptr) {
+            connectTimer.cancel();
             throw std::runtime_error("Failed to connect to server");
         }
+
+        Stats::getInstance().add(Stats::Counter::CONNECTIONS);
+        resetBuffer();
+    }
+
+    [[nodiscard]] int getSocket() const override {
+        return sockfd;
     }
 
     void disconnect() override {
         if (sockfd != -1) {
             close(sockfd);
+            sockfd = -1;
+        }
+        for (int& end : pipefd) {
+            if (end != -1) {
+                close(end);
+                end = -1;
+            }
         }
     }
 
-    void sendCommand(std::string command) override {
-        if (send(sockfd, command.c_str(), command.size(), 0) < 0) {
-            throw std::runtime_error("Failed to send command");
+
+#ifdef __linux__
+    /**
+     * @brief Writes the buffered part of the literal, then splices the rest from the socket
+     *        through a pipe into the file, so it is never copied into user space.
+     *
+     * Falls back to the buffered path if the socket cannot be spliced or the connection is
+     * compressed. If the file cannot be written, the rest of the literal is read and dropped.
+     */
+    bool readToFile(int fd, size_t size) override {
+        if (isCompressed()) {
+            return ConnectionStrategy::readToFile(fd, size);
+        }
+
+        Stats& stats = Stats::getInstance();
+        std::string_view buffered = takeBuffered(size);
+        bool ok = writeAll(fd, buffered);
+        size -= buffered.size();
+
+        while (ok && size > 0 && openPipe()) {
+            ssize_t moved = splice(sockfd, nullptr, pipefd[1], nullptr, std::min(size, pipeSize), SPLICE_F_MOVE | SPLICE_F_MORE);
+            stats.add(Stats::Counter::SPLICE_CALLS);
+            if (moved < 0 && errno == EINTR) {
+                continue;
+            }
+            if (moved < 0 && (errno == EINVAL || errno == ENOSYS)) {
+                break;  // splice not supported here
+            }
+            if (moved < 0) {
+                throw std::runtime_error("Failed to read response");
+            }
+            if (moved == 0) {
+                throw std::runtime_error("Connection closed by server");
+            }
+            size -= static_cast<size_t>(moved);
+            countReceived(static_cast<size_t>(moved));
+
+            auto inPipe = static_cast<size_t>(moved);
+            while (inPipe > 0) {
+                auto start = stats.now();
+                ssize_t written = splice(pipefd[0], nullptr, fd, nullptr, inPipe, SPLICE_F_MOVE | SPLICE_F_MORE);
+                stats.add(Stats::Counter::SPLICE_CALLS);
+                if (written < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (written <= 0) {
+                    ok = false;
+                    drainPipe(inPipe);
+                    break;
+                }
+                stats.diskWrite(static_cast<uint64_t>(written), start);
+                inPipe -= static_cast<size_t>(written);
+            }
+        }
+
+        if (ok) {
+            return ConnectionStrategy::readToFile(fd, size);
+        }
+        while (size > 0) {
+            size -= readSome(size).size();
+        }
+        return false;
+    }
+#endif
+
+protected:
+    void transmit(const char* data, size_t size) override {
+        while (size > 0) {
+            ssize_t sent = send(sockfd, data, size, MSG_NOSIGNAL);
+            if (sent < 0 && errno == EINTR) {
+                continue;
+            }
+            if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                // non-blocking socket with a full send buffer
+                struct pollfd writable{sockfd, POLLOUT, 0};
+                poll(&writable, 1, -1);
+                continue;
+            }
+            if (sent < 0) {
+                throw std::runtime_error("Failed to send command");
+            }
+            data += sent;
+            size -= static_cast<size_t>(sent);
         }
     }
 
-    std::string readResponse() const override {
-        char buffer[1024];
-        ssize_t bytesRead = recv(sockfd, buffer, sizeof(buffer) - 1, 0);
+    size_t receive(char* data, size_t size) override {
+        ssize_t bytesRead;
+        do {
+            bytesRead = recv(sockfd, data, size, 0);
+        } while (bytesRead < 0 && errno == EINTR);
+
+        if (bytesRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return wouldBlock;
+        }
         if (bytesRead < 0) {
             throw std::runtime_error("Failed to read response");
         }
-        buffer[bytesRead] = '\0';
-        return std::string(buffer);
+        return static_cast<size_t>(bytesRead);
+    }
+
+private:
+#ifdef __linux__
+    bool openPipe() {
+        if (pipefd[0] != -1) {
+            return true;
+        }
+        if (pipe2(pipefd, O_CLOEXEC) != 0) {
+            pipefd[0] = pipefd[1] = -1;
+            return false;
+        }
+
+        // a larger pipe moves more of the literal per splice() call
+        fcntl(pipefd[1], F_SETPIPE_SZ, 1024 * 1024);
+        int size = fcntl(pipefd[1], F_GETPIPE_SZ);
+        pipeSize = size > 0 ? static_cast<size_t>(size) : 64 * 1024;
+        return true;
+    }
+
+    /**
+     * @brief Drops bytes left in the pipe after the file could not be written.
+     */
+    void drainPipe(size_t size) {
+        char scratch[4096];
+        while (size > 0) {
+            ssize_t bytesRead = read(pipefd[0], scratch, std::min(size, sizeof(scratch)));
+            if (bytesRead < 0 && errno == EINTR) {
+                continue;
+            }
+            if (bytesRead <= 0) {
+                break;
+            }
+            size -= static_cast<size_t>(bytesRead);
+        }
+
+        if (size > 0) {
+            // the pipe still holds data of this literal, never reuse it
+            close(pipefd[0]);
+            close(pipefd[1]);
+            pipefd[0] = pipefd[1] = -1;
+        }
     }
+#endif
 };
 
 #endif //IMAP_TLS_CLIENT_TCPCONNECTIONSTRATEGY_H
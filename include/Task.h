@@ -0,0 +1,173 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#ifndef IMAP_TLS_CLIENT_TASK_H
+#define IMAP_TLS_CLIENT_TASK_H
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+template<typename T>
+class Task;
+
+namespace detail {
+    /**
+     * @brief Promise parts shared by all Task types: the awaiting coroutine and the exception.
+     */
+    class TaskPromiseBase {
+    public:
+        /**
+         * @brief Resumes the awaiting coroutine once the task is done, without growing the stack.
+         */
+        struct FinalAwaiter {
+            [[nodiscard]] bool await_ready() const noexcept {
+                return false;
+            }
+
+            template<typename Promise>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+                std::coroutine_handle<> continuation = handle.promise().continuation;
+                return continuation ? continuation : std::noop_coroutine();
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        std::suspend_always initial_suspend() const noexcept {
+            return {};
+        }
+
+        FinalAwaiter final_suspend() const noexcept {
+            return {};
+        }
+
+        void unhandled_exception() noexcept {
+            error = std::current_exception();
+        }
+
+        std::coroutine_handle<> continuation;   ///< coroutine awaiting the task, resumed when it is done
+        std::exception_ptr error;               ///< exception thrown by the task
+
+    protected:
+        void rethrow() const {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    };
+
+    template<typename T>
+    class TaskPromise : public TaskPromiseBase {
+    public:
+        Task<T> get_return_object() noexcept;
+
+        template<typename Value>
+        void return_value(Value&& result) {
+            value.emplace(std::forward<Value>(result));
+        }
+
+        T result() {
+            rethrow();
+            return std::move(*value);
+        }
+
+    private:
+        std::optional<T> value;     ///< value given by co_return
+    };
+
+    template<>
+    class TaskPromise<void> : public TaskPromiseBase {
+    public:
+        Task<void> get_return_object() noexcept;
+
+        void return_void() const noexcept {}
+
+        void result() const {
+            rethrow();
+        }
+    };
+}
+
+/**
+ * @brief Lazily started coroutine returning a T, awaited with `co_await`.
+ *
+ * The coroutine starts running when it is awaited and the awaiting coroutine is resumed
+ * as soon as it finishes; an exception thrown inside is rethrown from the `co_await`.
+ * Top-level tasks are started by Executor::spawn().
+ */
+template<typename T = void>
+class Task {
+public:
+    using promise_type = detail::TaskPromise<T>;
+
+    explicit Task(std::coroutine_handle<promise_type> handle) noexcept : handle(handle) {}
+
+    Task(Task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle) {
+                handle.destroy();
+            }
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() {
+        if (handle) {
+            handle.destroy();
+        }
+    }
+
+    [[nodiscard]] bool await_ready() const noexcept {
+        return !handle || handle.done();
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle.promise().continuation = awaiting;
+        return handle;
+    }
+
+    T await_resume() {
+        return handle.promise().result();
+    }
+
+    /**
+     * @brief Runs the task until it first suspends; used for tasks nobody awaits.
+     */
+    void start() {
+        handle.resume();
+    }
+
+    [[nodiscard]] bool isDone() const noexcept {
+        return handle.done();
+    }
+
+    /**
+     * @brief Returns the result of a finished task, rethrowing its exception.
+     */
+    T result() {
+        return handle.promise().result();
+    }
+
+private:
+    std::coroutine_handle<promise_type> handle;  ///< the coroutine, owned by the task
+};
+
+template<typename T>
+Task<T> detail::TaskPromise<T>::get_return_object() noexcept {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> detail::TaskPromise<void>::get_return_object() noexcept {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+#endif //IMAP_TLS_CLIENT_TASK_H
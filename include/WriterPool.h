@@ -0,0 +1,68 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#ifndef IMAP_TLS_CLIENT_WRITERPOOL_H
+#define IMAP_TLS_CLIENT_WRITERPOOL_H
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+/**
+ * @brief Pool of threads writing completed messages to disk, so that receiving from the
+ *        network never waits for open/write/close on a slow filesystem.
+ *
+ * Every task is submitted together with the amount of memory it holds (the message size).
+ * The memory of queued and running tasks is limited; submit() blocks once the limit is
+ * reached, which slows the receiving connections down to the speed of the disk.
+ * One pool can be shared by any number of clients.
+ */
+class WriterPool {
+public:
+    /**
+     * @param threads The number of writer threads.
+     * @param memoryLimit The maximal amount of bytes held by queued and running tasks.
+     */
+    WriterPool(size_t threads, size_t memoryLimit);
+
+    /**
+     * @brief Runs all queued tasks and joins the threads.
+     */
+    ~WriterPool();
+
+    WriterPool(const WriterPool&) = delete;
+    WriterPool& operator=(const WriterPool&) = delete;
+
+    /**
+     * @brief Queues a task, waiting while the memory limit would be exceeded.
+     *
+     * A task larger than the limit is accepted once nothing else is queued.
+     * @param bytes The memory held by the task until it has finished.
+     * @param task The task; it must not throw.
+     */
+    void submit(size_t bytes, std::function<void()> task);
+
+private:
+    struct Task {
+        size_t bytes;
+        std::function<void()> run;
+    };
+
+    size_t memoryLimit;                 ///< limit of queuedBytes
+    size_t queuedBytes = 0;             ///< memory held by queued and running tasks
+    bool stopping = false;              ///< set by the destructor
+    std::deque<Task> tasks;             ///< tasks not taken by any thread yet
+    std::mutex mutex;                   ///< guards all members above
+    std::condition_variable available;  ///< signalled when a task is queued or stopping is set
+    std::condition_variable released;   ///< signalled when a task has finished
+    std::vector<std::thread> threads;   ///< the writer threads
+
+    void worker();
+};
+
+#endif //IMAP_TLS_CLIENT_WRITERPOOL_H
@@ -3,12 +3,50 @@
 //
 
 #include "../include/ArgParser.h"
+#include "SearchCriteria.h"
 #include <getopt.h>
 #include <iostream>
 #include <stdexcept>
 #include <fstream>
 #include <sstream>
 #include <tuple>
+#include <cstring>
+#include <cstdio>
+#include <ctime>
+
+/**
+ * @brief Long options, all of them are available only in the `--name value` or `--name=value` form.
+ */
+static const struct option longOptions[] = {
+        {"pipeline", required_argument, nullptr, 'P'},
+        {"all-mailboxes", no_argument, nullptr, 'A'},
+        {"workers", required_argument, nullptr, 'W'},
+        {"connections", required_argument, nullptr, 'N'},
+        {"event-loops", required_argument, nullptr, 'E'},
+        {"format", required_argument, nullptr, 'F'},
+        {"writers", required_argument, nullptr, 'w'},
+        {"write-buffer", required_argument, nullptr, 'B'},
+        {"tls-session-cache", required_argument, nullptr, 'S'},
+        {"no-compress", no_argument, nullptr, 'Z'},
+        {"verbose", no_argument, nullptr, 'V'},
+        {"jobs", required_argument, nullptr, 'J'},
+        {"job-workers", required_argument, nullptr, 'j'},
+        {"stats", no_argument, nullptr, 'R'},
+        {"stats-json", required_argument, nullptr, 'K'},
+        {"max-size", required_argument, nullptr, 'X'},
+        {"received-after", required_argument, nullptr, 'Y'},
+        {"received-before", required_argument, nullptr, 'Q'},
+        {"sender", required_argument, nullptr, 'D'},
+        {"uid", required_argument, nullptr, 'U'},
+        {"since", required_argument, nullptr, 'i'},
+        {"before", required_argument, nullptr, 'e'},
+        {"larger", required_argument, nullptr, 'L'},
+        {"smaller", required_argument, nullptr, 's'},
+        {"from", required_argument, nullptr, 'f'},
+        {"header", required_argument, nullptr, 'H'},
+        {"chunk-size", required_argument, nullptr, 'G'},
+        {nullptr, 0, nullptr, 0}
+};
 
 /**
  * @brief Parses command-line arguments and stores them in the Config structure.
@@ -27,8 +65,7 @@ ArgParser::Config ArgParser::parse(int argc, char* argv[]){
         }
     } else {                                    //if first argument is '-' flag
         for(int i = 2; i < argc ; i++){
-            if(argv[i][0] != '-' && (argv[i-1][0] != '-' ||      // if current param AND prev param are not '-' params
-            argv[i-1][1] == 'T' || argv[i-1][1] == 'n' || argv[i-1][1] == 'h')){ // or if prev param is not '-': param
+            if(argv[i][0] != '-' && !expectsValue(argv[i-1])){ // if current param is not '-' param and not a value of prev param
                 config.server = argv[i];
 
                 // move all args left
@@ -41,15 +78,15 @@ ArgParser::Config ArgParser::parse(int argc, char* argv[]){
         }
     }
 
-    if (config.server.empty()) {
-        throw std::invalid_argument("server name is empty");
-    }
-
+    // parse() runs once per line of a jobs file, 0 makes getopt start over
+    optind = 0;
     int opt;
-    while((opt = getopt(argc, argv, "p:Tc:C:nha:b:o:")) != -1){
+    bool portGiven = false;
+    while((opt = getopt_long(argc, argv, "p:Tc:C:nha:b:o:", longOptions, nullptr)) != -1){
         switch (opt) {
             case 'p':
                 config.port = std::stoi(optarg);
+                portGiven = true;
                 break;
             case 'T':
                 config.useSSL = true;
@@ -71,15 +108,155 @@ ArgParser::Config ArgParser::parse(int argc, char* argv[]){
                 break;
             case 'b':
                 config.mailbox = optarg;
+                config.mailboxes.emplace_back(optarg);
                 break;
             case 'o':
                 config.outDir = optarg;
                 break;
+            case 'P':
+                config.pipelineWindow = std::stoi(optarg);
+                if (config.pipelineWindow < 1) {
+                    throw std::invalid_argument("pipeline window must be at least 1");
+                }
+                break;
+            case 'A':
+                config.allMailboxes = true;
+                break;
+            case 'W':
+                config.workers = std::stoi(optarg);
+                if (config.workers < 1) {
+                    throw std::invalid_argument("number of workers must be at least 1");
+                }
+                break;
+            case 'N':
+                config.connections = std::stoi(optarg);
+                if (config.connections < 1) {
+                    throw std::invalid_argument("number of connections must be at least 1");
+                }
+                break;
+            case 'E':
+                config.eventLoops = std::stoi(optarg);
+                if (config.eventLoops < 0) {
+                    throw std::invalid_argument("number of event loops must not be negative");
+                }
+                break;
+            case 'F':
+                config.format = optarg;
+                if (config.format != "files" && config.format != "mbox" && config.format != "maildir" && config.format != "pack") {
+                    throw std::invalid_argument("output format must be files, mbox, maildir or pack");
+                }
+                break;
+            case 'w':
+                config.processOptions.push_back("--writers");
+                config.writers = std::stoi(optarg);
+                if (config.writers < 0) {
+                    throw std::invalid_argument("number of writers must not be negative");
+                }
+                break;
+            case 'B':
+                config.processOptions.push_back("--write-buffer");
+                if (std::stoi(optarg) < 1) {
+                    throw std::invalid_argument("write buffer must be at least 1 MB");
+                }
+                config.writeBuffer = std::stoul(optarg);
+                break;
+            case 'S':
+                config.processOptions.push_back("--tls-session-cache");
+                config.tlsSessionCache = optarg;
+                break;
+            case 'Z':
+                config.compress = false;
+                break;
+            case 'V':
+                config.processOptions.push_back("--verbose");
+                config.verbose = true;
+                break;
+            case 'J':
+                config.jobsFile = optarg;
+                break;
+            case 'j':
+                config.processOptions.push_back("--job-workers");
+                config.jobWorkers = std::stoi(optarg);
+                if (config.jobWorkers < 1) {
+                    throw std::invalid_argument("number of job workers must be at least 1");
+                }
+                break;
+            case 'R':
+                config.processOptions.push_back("--stats");
+                config.stats = true;
+                break;
+            case 'K':
+                config.processOptions.push_back("--stats-json");
+                config.statsJson = optarg;
+                break;
+            case 'X':
+                config.maxSize = parseSize(optarg);
+                break;
+            case 'Y':
+                config.receivedAfter = parseDate(optarg);
+                break;
+            case 'Q':
+                config.receivedBefore = parseDate(optarg);
+                break;
+            case 'D':
+                config.sender = optarg;
+                break;
+            case 'U':
+                config.uidSet = optarg;
+                SearchCriteria().uid(config.uidSet);    // throws if the set is malformed
+                break;
+            case 'i':
+                config.since = parseDay(optarg);
+                break;
+            case 'e':
+                config.before = parseDay(optarg);
+                break;
+            case 'L':
+                config.larger = parseSize(optarg);
+                break;
+            case 's':
+                config.smaller = parseSize(optarg);
+                break;
+            case 'f':
+                config.fromAddresses.emplace_back(optarg);
+                break;
+            case 'H': {
+                // "Field: text", the text may be empty
+                std::string header = optarg;
+                size_t colon = header.find(':');
+                if (colon == std::string::npos) {
+                    throw std::invalid_argument("header criterion must be \"Field: text\"");
+                }
+                size_t text = header.find_first_not_of(' ', colon + 1);
+                config.headers.emplace_back(header.substr(0, colon), text == std::string::npos ? "" : header.substr(text));
+                SearchCriteria().header(config.headers.back().first, "");   // throws if the name is invalid
+                break;
+            }
+            case 'G':
+                config.chunkSize = parseSize(optarg);
+                break;
             default:
                 throw std::invalid_argument("invalid argument");
         }
     }
 
+    if (config.receivedAfter > 0 && config.receivedBefore > 0 && config.receivedAfter >= config.receivedBefore) {
+        throw std::invalid_argument("--received-after must be earlier than --received-before");
+    }
+
+    if (!portGiven) {
+        config.port = config.useSSL ? 993 : 143;
+    }
+
+    // the jobs of a jobs file give their own server, auth file and output directory
+    if (!config.jobsFile.empty()) {
+        return config;
+    }
+
+    if (config.server.empty()) {
+        throw std::invalid_argument("server name is empty");
+    }
+
     if (config.authFile.empty() || config.outDir.empty()) {
         throw std::invalid_argument("Required params: -a (auth_file) -o (output_dir)");
     }
@@ -90,6 +267,111 @@ ArgParser::Config ArgParser::parse(int argc, char* argv[]){
 }
 
 
+/**
+ * @brief Checks whether the argument is an option followed by a separate value (e.g. `-a file`).
+ * @param arg The command-line argument.
+ * @return True if the next argument is the value of this option.
+ */
+bool ArgParser::expectsValue(const char* arg) {
+    if (arg[0] != '-') {
+        return false;
+    }
+
+    if (arg[1] == '-') {
+        for (const struct option* opt = longOptions; opt->name; ++opt) {
+            if (opt->has_arg == required_argument && std::strcmp(arg + 2, opt->name) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // short option with value given separately, e.g. "-p 993" but not "-p993"
+    return arg[1] != '\0' && arg[2] == '\0' && std::strchr("pcCabo", arg[1]) != nullptr;
+}
+
+/**
+ * @brief Parses a message size given in bytes or with a K, M or G suffix (powers of 1024).
+ * @param text The size, e.g. `512K`.
+ * @return The size in bytes.
+ * @throws std::invalid_argument if the size is malformed or zero.
+ */
+size_t ArgParser::parseSize(const std::string& text) {
+    size_t length = 0;
+    unsigned long long size = 0;
+    try {
+        size = std::stoull(text, &length);
+    } catch (const std::exception&) {
+        throw std::invalid_argument("invalid message size: " + text);
+    }
+
+    std::string suffix = text.substr(length);
+    if (suffix == "K" || suffix == "k") {
+        size <<= 10;
+    } else if (suffix == "M" || suffix == "m") {
+        size <<= 20;
+    } else if (suffix == "G" || suffix == "g") {
+        size <<= 30;
+    } else if (!suffix.empty()) {
+        throw std::invalid_argument("invalid message size: " + text);
+    }
+
+    if (size == 0 || text[0] == '-') {
+        throw std::invalid_argument("message size must be at least 1 byte");
+    }
+    return size;
+}
+
+/**
+ * @brief Parses a date given as `YYYY-MM-DD` or `YYYY-MM-DDTHH:MM[:SS]`, in UTC.
+ * @param text The date.
+ * @return The date as a time in UTC.
+ * @throws std::invalid_argument if the date is malformed.
+ */
+std::time_t ArgParser::parseDate(const std::string& text) {
+    int year, month, day, hour = 0, minute = 0, second = 0;
+    int length = 0;
+    int fields = std::sscanf(text.c_str(), "%4d-%2d-%2d%n", &year, &month, &day, &length);
+    if (fields == 3 && text[length] == 'T') {
+        int timeLength = 0;
+        fields += std::sscanf(text.c_str() + length, "T%2d:%2d%n", &hour, &minute, &timeLength);
+        length += timeLength;
+        if (fields == 5 && text[length] == ':') {
+            timeLength = 0;
+            std::sscanf(text.c_str() + length, ":%2d%n", &second, &timeLength);
+            length += timeLength;
+        }
+    }
+
+    if (fields < 3 || static_cast<size_t>(length) != text.size() || month < 1 || month > 12 ||
+        day < 1 || day > 31 || hour > 23 || minute > 59 || second > 59) {
+        throw std::invalid_argument("invalid date (expected YYYY-MM-DD or YYYY-MM-DDTHH:MM[:SS]): " + text);
+    }
+
+    std::tm tm{};
+    tm.tm_year = year - 1900;
+    tm.tm_mon = month - 1;
+    tm.tm_mday = day;
+    tm.tm_hour = hour;
+    tm.tm_min = minute;
+    tm.tm_sec = second;
+    return timegm(&tm);
+}
+
+/**
+ * @brief Parses the day of a server-side date criterion, an absolute date or `Nd` for N days ago.
+ * @param text The date as accepted by parseDate() (the time of day is ignored by the server), or e.g. `1d`.
+ * @return A time within the day, in UTC.
+ * @throws std::invalid_argument if the date is malformed.
+ */
+std::time_t ArgParser::parseDay(const std::string& text) {
+    if (text.size() > 1 && text.back() == 'd' &&
+        text.find_first_not_of("0123456789") == text.size() - 1 && text.size() < 7) {
+        return std::time(nullptr) - std::stol(text.substr(0, text.size() - 1)) * 24 * 3600;
+    }
+    return parseDate(text);
+}
+
 /**
  * @brief Reads the authentication file and extracts the username and password.
  * @param authFilePath Path to the authentication file.
@@ -0,0 +1,410 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#include "../include/AsyncIMAPClient.h"
+#include "IMAPClient.h"
+#include "IMAPExceptions.h"
+#include "IMAPCommandFactory.h"
+#include "ResponseParser.h"
+#include "SequenceSet.h"
+#include "SearchCriteria.h"
+#include "SSLConnectionStrategy.h"
+#include "TCPConnectionStrategy.h"
+#include "Stats.h"
+
+#include <deque>
+#include <utility>
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+
+AsyncIMAPClient::AsyncIMAPClient(ArgParser::Config config, Executor& executor)
+        : config(std::move(config)), executor(executor),
+          writer([this](uint32_t messageId, const std::string& headers) { return IMAPClient::messageFilename(this->config.outDir, messageId, headers); },
+                 [this](uint32_t messageId, const std::string& filename, bool saved) {
+                     if (state) {
+                         state->add(messageId, filename);
+                     }
+                     if (saved) {
+                         Stats::getInstance().add(Stats::Counter::MESSAGES_SAVED);
+                         messageSaved++;
+                     }
+                 }) {
+
+    if (this->config.useSSL) {
+        strategy = std::make_unique<SSLConnectionStrategy>(
+                this->config.server, this->config.port,
+                this->config.cert.empty() ? "" : this->config.certDir + "/" + this->config.cert,
+                this->config.certDir
+        );
+    } else {
+        strategy = std::make_unique<TCPConnectionStrategy>(this->config.server, this->config.port);
+    }
+}
+
+Task<> AsyncIMAPClient::connect() {
+    strategy->connect();
+    strategy->setNonBlocking();
+    Stats::Timer timer(Stats::Phase::GREETING);
+    co_await readWholeResponse(true);
+}
+
+Task<> AsyncIMAPClient::login() {
+    Stats::Timer timer(Stats::Phase::AUTH);
+    auto loginCommand = IMAPCommandFactory::createLoginCommand(config.username, config.server, config.password);
+    sendCommand(*loginCommand);
+    std::string capabilities = co_await readWholeResponse();
+
+    // the same capability lookup as IMAPClient::login()
+    bool needed = config.compress || SearchCriteria::fromConfig(config).hasLiterals();
+    if (needed && !ResponseParser::listsCapabilities(capabilities)) {
+        auto capabilityCommand = IMAPCommandFactory::createCapabilityCommand();
+        sendCommand(*capabilityCommand);
+        capabilities = co_await readWholeResponse();
+    }
+    literalPlus = ResponseParser::hasCapability(capabilities, "LITERAL+");
+
+    if (config.compress) {
+        co_await compress(std::move(capabilities));
+    }
+}
+
+/**
+ * @brief Enables COMPRESS=DEFLATE if the server announces it, like IMAPClient::compress().
+ * @param capabilities The response to LOGIN or CAPABILITY listing the capabilities.
+ */
+Task<> AsyncIMAPClient::compress(std::string capabilities) {
+    if (!ResponseParser::hasCapability(capabilities, "COMPRESS=DEFLATE")) {
+        co_return;
+    }
+
+    auto compressCommand = IMAPCommandFactory::createCompressCommand();
+    sendCommand(*compressCommand);
+    try {
+        co_await readWholeResponse();
+    } catch (const IMAPNoResponseException&) {
+        co_return;
+    }
+    strategy->startCompression();
+}
+
+Task<> AsyncIMAPClient::select() {
+    Stats::Timer timer(Stats::Phase::MAILBOX_SELECT);
+    auto selectCommand = IMAPCommandFactory::createSelectCommand(config.mailbox);
+    sendCommand(*selectCommand);
+    std::string selectResponse = co_await readWholeResponse();
+
+    uidValidity = 0;
+    uidNext = 0;
+    ResponseParser::responseCode(selectResponse, "UIDVALIDITY", uidValidity);
+    ResponseParser::responseCode(selectResponse, "UIDNEXT", uidNext);
+}
+
+Task<bool> AsyncIMAPClient::search() {
+    state = SyncState::open(config.outDir, config.onlyHeaders, config.format, uidValidity);
+
+    if (config.format != "files") {
+        sink = MessageSink::create(config.format, config.outDir);
+        writer.setSink(sink);
+    }
+
+    searched = true;
+    ids.clear();
+    if (!state->beginSync(uidNext)) {
+        wanted = MessageSet();
+        co_return false;
+    }
+
+    Stats::Timer timer(Stats::Phase::MAILBOX_SEARCH);
+    auto searchCommand = IMAPCommandFactory::createSearchCommand(SearchCriteria::forSync(config, state->getFirstUid()));
+    co_await sendLiterals(*searchCommand);
+    std::string searchResponse = co_await readWholeResponse();
+    timer.stop();
+
+    std::vector<uint32_t> found;
+    ResponseParser::searchIds(searchResponse, found);
+    ids = state->takeFound(found, !SearchCriteria::fromConfig(config).empty());
+    if (!ids.empty() && MessageTable::Filter(config).active()) {
+        co_await filterByMetadata();
+    }
+    wanted = MessageSet(ids);
+    co_return !ids.empty();
+}
+
+/**
+ * @brief Fetches the metadata of the found messages and keeps only those passing the filter,
+ *        like IMAPClient::filterByMetadata().
+ */
+Task<> AsyncIMAPClient::filterByMetadata() {
+    Stats::Timer timer(Stats::Phase::METADATA_FETCH);
+    metadata.clear();
+    for (const std::string& sequenceSet : SequenceSet::build(ids)) {
+        auto metadataCommand = IMAPCommandFactory::createFetchMetadataCommand(sequenceSet);
+        sendCommand(*metadataCommand);
+        std::string metadataResponse = co_await readWholeResponse();
+        metadata.parse(metadataResponse);
+    }
+    timer.stop();
+
+    std::vector<uint32_t> rejected;
+    size_t found = ids.size();
+    ids = metadata.select(ids, MessageTable::Filter(config), rejected);
+    if (!rejected.empty()) {
+        state->holdBack(*std::min_element(rejected.begin(), rejected.end()));
+    }
+
+    if (config.verbose) {
+        std::cerr << "Filter (" + config.mailbox + "): " + std::to_string(ids.size()) + " of " +
+                     std::to_string(found) + " messages pass, " + std::to_string(rejected.size()) + " skipped\n";
+    }
+}
+
+Task<> AsyncIMAPClient::fetch() {
+    std::filesystem::create_directories(config.outDir);
+
+    Stats::Timer timer(Stats::Phase::MESSAGE_FETCH);
+    co_await fetchPipelined(SequenceSet::build(ids));
+    writer.flush();
+}
+
+Task<> AsyncIMAPClient::fetch(std::string sequenceSet) {
+    std::filesystem::create_directories(config.outDir);
+
+    Stats::Timer timer(Stats::Phase::MESSAGE_FETCH);
+    std::vector<std::string> sequenceSets(1, std::move(sequenceSet));
+    co_await fetchPipelined(sequenceSets);
+    writer.flush();
+}
+
+void AsyncIMAPClient::commitSync() {
+    if (sink) {
+        sink->close();
+    }
+    if (!state) {
+        return;
+    }
+
+    std::filesystem::create_directories(config.outDir);
+    state->commit(!config.onlyNew);
+}
+
+Task<> AsyncIMAPClient::logout() {
+    Stats::Timer timer(Stats::Phase::QUIT);
+    auto logoutCommand = IMAPCommandFactory::createLogoutCommand();
+    sendCommand(*logoutCommand);
+    co_await readWholeResponse();
+    timer.stop();
+
+    strategy->disconnect();
+}
+
+void AsyncIMAPClient::setWriterPool(std::shared_ptr<WriterPool> pool) {
+    writer.setPool(std::move(pool));
+}
+
+const std::vector<uint32_t>& AsyncIMAPClient::getIds() const {
+    return ids;
+}
+
+const MessageTable& AsyncIMAPClient::getMetadata() const {
+    return metadata;
+}
+
+int AsyncIMAPClient::getSavedCount() const {
+    return messageSaved.load();
+}
+
+/**
+ * @brief Sends the command with a new tag; commands are short, so sending does not suspend.
+ * @return The tag of the command.
+ */
+std::string AsyncIMAPClient::sendCommand(const IMAPCommand& command) {
+    currTag = "A" + std::to_string(currTagNum++);
+    strategy->sendCommand(currTag + " " + command.generate());
+    return currTag;
+}
+
+/**
+ * @brief Sends a command that may contain literals, like IMAPClient::sendCommand().
+ *
+ * With LITERAL+ the whole command is sent at once, otherwise every literal waits for the
+ * server's continuation request.
+ */
+Task<> AsyncIMAPClient::sendLiterals(const IMAPCommand& command) {
+    currTag = "A" + std::to_string(currTagNum++);
+    std::vector<std::string> parts = IMAPCommand::splitAtLiterals(currTag + " " + command.generate());
+
+    std::string text;
+    for (size_t i = 0; i < parts.size(); ++i) {
+        bool last = i + 1 == parts.size();
+        if (!last && literalPlus) {
+            parts[i].insert(parts[i].size() - 3, "+");
+        }
+        text += parts[i];
+        if (last || literalPlus) {
+            continue;
+        }
+
+        strategy->sendCommand(text);
+        text.clear();
+        std::string tag = currTag;
+        co_await readUntil([&tag](std::string_view line) {
+            return line.substr(0, 1) == "+" ? IMAPResponseType::OK : ResponseParser::taggedStatus(line, tag);
+        }, false);
+    }
+    strategy->sendCommand(text);
+}
+
+/**
+ * @brief Reads one response line, waiting for the socket while it is incomplete.
+ * @return The line without CRLF, valid until the next read.
+ */
+Task<std::string_view> AsyncIMAPClient::readLine() {
+    std::string_view line;
+    while (!strategy->tryReadLine(line)) {
+        co_await executor.readable(strategy->getSocket());
+    }
+    co_return line;
+}
+
+/**
+ * @brief Reads a literal and passes it to the sink chunk by chunk, straight from the receive buffer.
+ * @param size The size of the literal in bytes.
+ * @param sink Receives the literal data; the data is dropped if the sink is empty.
+ */
+Task<> AsyncIMAPClient::readLiteral(size_t size, const std::function<void(const char*, size_t)>& sink) {
+    std::string_view data;
+    while (size > 0) {
+        if (!strategy->tryReadSome(size, data)) {
+            co_await executor.readable(strategy->getSocket());
+            continue;
+        }
+        if (sink) {
+            sink(data.data(), data.size());
+        }
+        size -= data.size();
+    }
+}
+
+/**
+ * @brief Reads response lines until the completion callback recognizes a status line, like IMAPClient::readUntil().
+ *
+ * @param completion Returns the status of a completion line or UNKNOWN for any other line.
+ * @param saveMessages Save the literals as messages instead of keeping them in the returned text.
+ * @return The response text without the saved literals.
+ * @throws IMAPNoResponseException if a NO response is received.
+ * @throws IMAPBadResponseException if a BAD response is received.
+ */
+Task<std::string> AsyncIMAPClient::readUntil(const std::function<IMAPResponseType(std::string_view)>& completion,
+                                             bool saveMessages) {
+    std::string finalMessage;
+    std::string line;
+    IMAPResponseType responseType = IMAPResponseType::UNKNOWN;
+
+    while (responseType == IMAPResponseType::UNKNOWN) {
+        line.assign(co_await readLine());
+        size_t literalSize;
+
+        while (ResponseParser::literalSize(line, literalSize)) {
+            if (saveMessages) {
+                std::string rest;
+                co_await saveLiteral(line, literalSize, rest);
+                line = std::move(rest);
+                continue;
+            }
+            finalMessage.append(line).append("\r\n");
+            co_await readLiteral(literalSize, [&finalMessage](const char* data, size_t length) {
+                finalMessage.append(data, length);
+            });
+            // the response line continues after the literal
+            line.assign(co_await readLine());
+        }
+
+        responseType = completion(line);
+        finalMessage.append(line).append("\r\n");
+    }
+
+    if (responseType == IMAPResponseType::NO) {
+        throw IMAPNoResponseException(finalMessage);
+    } else if (responseType == IMAPResponseType::BAD) {
+        throw IMAPBadResponseException(finalMessage);
+    }
+    co_return finalMessage;
+}
+
+/**
+ * @brief Reads the response to the last command, or the greeting.
+ */
+Task<std::string> AsyncIMAPClient::readWholeResponse(bool greeting) {
+    std::string tag = currTag;
+    co_return co_await readUntil([greeting, &tag](std::string_view line) {
+        return greeting ? ResponseParser::greetingStatus(line) : ResponseParser::taggedStatus(line, tag);
+    }, false);
+}
+
+/**
+ * @brief Sends the FETCH commands with up to `pipelineWindow` of them in flight, like IMAPClient::fetchPipelined().
+ */
+Task<> AsyncIMAPClient::fetchPipelined(const std::vector<std::string>& sequenceSets) {
+    std::deque<std::string> inFlight;
+    size_t next = 0;
+
+    auto completion = [&inFlight](std::string_view line) {
+        for (auto tag = inFlight.begin(); tag != inFlight.end(); ++tag) {
+            IMAPResponseType responseType = ResponseParser::taggedStatus(line, *tag);
+            if (responseType != IMAPResponseType::UNKNOWN) {
+                inFlight.erase(tag);
+                return responseType;
+            }
+        }
+        return IMAPResponseType::UNKNOWN;
+    };
+
+    while (next < sequenceSets.size() || !inFlight.empty()) {
+        while (next < sequenceSets.size() && inFlight.size() < static_cast<size_t>(config.pipelineWindow)) {
+            auto fetchCommand = IMAPCommandFactory::createFetchCommand(sequenceSets[next++], config.onlyHeaders);
+            inFlight.push_back(sendCommand(*fetchCommand));
+        }
+
+        co_await readUntil(completion, true);
+    }
+}
+
+/**
+ * @brief Saves a message literal, like IMAPClient::saveLiteral(), and reads the rest of its response line.
+ *
+ * @param line The response line announcing the literal.
+ * @param size The size of the literal in bytes.
+ * @param rest Set to the line following the literal, which may carry the UID.
+ */
+Task<> AsyncIMAPClient::saveLiteral(const std::string& line, size_t size, std::string& rest) {
+    uint32_t sequenceNumber, messageId = 0;
+    bool uidKnown = false;
+    bool save = false;
+
+    if (ResponseParser::fetchId(line, sequenceNumber)) {
+        uidKnown = ResponseParser::fetchUid(line, messageId);
+        save = !uidKnown || !searched || wanted.contains(messageId);
+    }
+
+    if (save) {
+        writer.begin(messageId);
+        co_await readLiteral(size, [this](const char* data, size_t length) { writer.write(data, length); });
+    } else {
+        co_await readLiteral(size, nullptr);
+    }
+    rest.assign(co_await readLine());
+
+    if (!save) {
+        co_return;
+    }
+    if (!uidKnown) {
+        if (!ResponseParser::fetchUid(rest, messageId) || (searched && !wanted.contains(messageId))) {
+            writer.discard();
+            co_return;
+        }
+        writer.setMessageId(messageId);
+    }
+    writer.finish();
+}
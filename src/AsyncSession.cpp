@@ -0,0 +1,663 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#include "../include/AsyncSession.h"
+#include "IMAPClient.h"
+#include "IMAPCommandFactory.h"
+#include "IMAPExceptions.h"
+#include "ResponseParser.h"
+#include "SequenceSet.h"
+#include "SearchCriteria.h"
+#include "SSLWrapper.h"
+#include "Stats.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <filesystem>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <utility>
+#include <iterator>
+#include <netdb.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+AsyncSession::AsyncSession(ArgParser::Config config, std::shared_ptr<WriterPool> writerPool)
+        : config(std::move(config)),
+          writer([this](uint32_t id, const std::string& headers) { return IMAPClient::messageFilename(this->config.outDir, id, headers); },
+                 [this](uint32_t id, const std::string& filename, bool isNew) {
+                     state->add(id, filename);
+                     if (isNew) {
+                         Stats::getInstance().add(Stats::Counter::MESSAGES_SAVED);
+                         saved++;
+                     }
+                 }) {
+    writer.setPool(std::move(writerPool));
+}
+
+AsyncSession::~AsyncSession() {
+    closeConnection();
+}
+
+void AsyncSession::start() {
+    try {
+        if (config.useSSL) {
+            SSLWrapper::getInstance().prepareContext(config.cert.empty() ? "" : config.certDir + "/" + config.cert,
+                                                     config.certDir);
+        }
+
+        struct addrinfo hints{};
+        struct addrinfo* result;
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+
+        int status;
+        {
+            Stats::Timer timer(Stats::Phase::DNS);
+            status = getaddrinfo(config.server.c_str(), std::to_string(config.port).c_str(), &hints, &result);
+        }
+        if (status != 0) {
+            throw std::runtime_error("Invalid server address");
+        }
+        for (struct addrinfo* p = result; p != nullptr; p = p->ai_next) {
+            sockaddr_storage address{};
+            std::memcpy(&address, p->ai_addr, p->ai_addrlen);
+            addresses.push_back(address);
+            addressLengths.push_back(p->ai_addrlen);
+        }
+        freeaddrinfo(result);
+
+        phaseStarted = Stats::getInstance().now();
+        connectNext();
+    } catch (const std::exception& e) {
+        fail(e.what());
+    }
+}
+
+void AsyncSession::handle(uint32_t events) {
+    if (phase == Phase::DONE) {
+        return;
+    }
+
+    try {
+        if (phase == Phase::CONNECTING) {
+            if (!(events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) {
+                return;
+            }
+            finishConnect();
+            if (phase == Phase::CONNECTING) {
+                return;     // trying the next address
+            }
+        }
+
+        if (phase == Phase::HANDSHAKING && !handshake()) {
+            return;
+        }
+
+        flush();
+        // TLS may hold decrypted data that epoll does not know about
+        do {
+            receive();
+            parse();
+            flush();
+        } while (phase != Phase::DONE && ssl && SSL_pending(ssl) > 0);
+
+        if (serverClosed && phase != Phase::DONE) {
+            if (phase != Phase::LOGGING_OUT) {
+                throw std::runtime_error("Connection closed by server");
+            }
+            // servers may close right after BYE, without or before the tagged OK of LOGOUT
+            closeConnection();
+            enter(Phase::DONE);
+        }
+    } catch (const std::exception& e) {
+        fail(e.what());
+    }
+}
+
+int AsyncSession::getFd() const {
+    return sockfd;
+}
+
+uint32_t AsyncSession::getInterest() const {
+    if (phase == Phase::DONE) {
+        return 0;
+    } else if (phase == Phase::CONNECTING) {
+        return EPOLLOUT;
+    }
+    return EPOLLIN | (!output.empty() || sslWantsWrite ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+}
+
+bool AsyncSession::isFinished() const {
+    return phase == Phase::DONE;
+}
+
+bool AsyncSession::hasFailed() const {
+    return failed;
+}
+
+/**
+ * @brief Starts a non-blocking connect to the next resolved address.
+ * @throws std::runtime_error if no address is left.
+ */
+void AsyncSession::connectNext() {
+    while (nextAddress < addresses.size()) {
+        const sockaddr_storage& address = addresses[nextAddress];
+        socklen_t length = addressLengths[nextAddress++];
+
+        sockfd = socket(address.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (sockfd < 0) {
+            continue;
+        }
+        if (::connect(sockfd, reinterpret_cast<const sockaddr*>(&address), length) == 0 || errno == EINPROGRESS) {
+            return;
+        }
+        close(sockfd);
+        sockfd = -1;
+    }
+    throw std::runtime_error("Failed to connect to server");
+}
+
+/**
+ * @brief Checks the result of the connect once the socket is writable.
+ */
+void AsyncSession::finishConnect() {
+    int error = 0;
+    socklen_t length = sizeof(error);
+    if (getsockopt(sockfd, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0) {
+        // the failed socket is closed only afterwards, so the next one never reuses its number
+        int failedFd = sockfd;
+        sockfd = -1;
+        try {
+            connectNext();
+        } catch (...) {
+            close(failedFd);
+            throw;
+        }
+        close(failedFd);
+        return;
+    }
+
+    if (!config.useSSL) {
+        enter(Phase::GREETING);
+        return;
+    }
+
+    ssl = SSLWrapper::getInstance().prepareSSLConnection(sockfd, config.server, config.port);
+    if (!ssl) {
+        throw std::runtime_error("Failed to establish SSL connection");
+    }
+    // commands may be appended to the output while a write is waiting for the socket
+    SSL_set_mode(ssl, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+    enter(Phase::HANDSHAKING);
+}
+
+/**
+ * @brief Continues the TLS handshake.
+ * @return True once the handshake is complete.
+ */
+bool AsyncSession::handshake() {
+    int result = SSL_connect(ssl);
+    sslWantsWrite = false;
+    if (result == 1) {
+        enter(Phase::GREETING);
+        return true;
+    }
+
+    int error = SSL_get_error(ssl, result);
+    if (error == SSL_ERROR_WANT_READ) {
+        return false;
+    } else if (error == SSL_ERROR_WANT_WRITE) {
+        sslWantsWrite = true;
+        return false;
+    }
+    ERR_clear_error();
+    throw std::runtime_error("Failed to establish SSL connection");
+}
+
+/**
+ * @brief Moves to the next phase, recording the duration of the completed one in the process stats.
+ */
+void AsyncSession::enter(Phase next) {
+    static constexpr Stats::Phase measured[] = {
+            Stats::Phase::TCP_CONNECT, Stats::Phase::TLS_HANDSHAKE, Stats::Phase::GREETING, Stats::Phase::AUTH,
+            Stats::Phase::MAILBOX_SELECT, Stats::Phase::MAILBOX_SEARCH, Stats::Phase::METADATA_FETCH,
+            Stats::Phase::MESSAGE_FETCH, Stats::Phase::QUIT
+    };
+
+    Stats& stats = Stats::getInstance();
+    if (stats.isEnabled()) {
+        auto now = std::chrono::steady_clock::now();
+        stats.record(measured[static_cast<size_t>(phase)], now - phaseStarted);
+        if (phase == Phase::CONNECTING) {
+            stats.add(Stats::Counter::CONNECTIONS);
+        }
+        phaseStarted = now;
+    }
+    phase = next;
+}
+
+/**
+ * @brief Queues a command; the parts after a literal wait in `continuation` for the server's `+`.
+ */
+void AsyncSession::send(const IMAPCommand& command) {
+    tag = "A" + std::to_string(tagNumber++);
+    std::vector<std::string> parts = IMAPCommand::splitAtLiterals(tag + " " + command.generate());
+    output += parts[0];
+    continuation.assign(std::make_move_iterator(parts.begin() + 1), std::make_move_iterator(parts.end()));
+}
+
+/**
+ * @brief Sends as much of the queued commands as the socket accepts.
+ */
+void AsyncSession::flush() {
+    while (!output.empty() && sockfd >= 0) {
+        size_t sent;
+        if (ssl) {
+            sslWantsWrite = false;
+            int result = SSL_write(ssl, output.data(), static_cast<int>(output.size()));
+            if (result <= 0) {
+                int error = SSL_get_error(ssl, result);
+                if (error == SSL_ERROR_WANT_WRITE) {
+                    sslWantsWrite = true;
+                    return;
+                } else if (error == SSL_ERROR_WANT_READ) {
+                    return;
+                }
+                throw std::runtime_error("Failed to send command");
+            }
+            sent = static_cast<size_t>(result);
+        } else {
+            ssize_t result = ::send(sockfd, output.data(), output.size(), MSG_NOSIGNAL);
+            if (result < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    return;
+                } else if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error("Failed to send command");
+            }
+            sent = static_cast<size_t>(result);
+        }
+        Stats::getInstance().add(Stats::Counter::SEND_CALLS);
+        Stats::getInstance().add(Stats::Counter::BYTES_SENT, sent);
+        output.erase(0, sent);
+    }
+}
+
+/**
+ * @brief Receives what is available, at most maxUnparsed bytes per call so that other
+ *        sessions of the loop get their turn.
+ *
+ * When the server closes the connection, `serverClosed` is set and the data received before
+ * is left for parse(); handle() decides whether the close was expected.
+ * @throws std::runtime_error if the connection fails.
+ */
+void AsyncSession::receive() {
+    size_t total = 0;
+    while (sockfd >= 0 && !serverClosed && total < maxUnparsed) {
+        if (inputHead > 0 && inputHead == inputTail) {
+            inputHead = inputTail = 0;
+        }
+        if (input.size() - inputTail < readChunk) {
+            if (inputHead > 0) {
+                std::memmove(input.data(), input.data() + inputHead, inputTail - inputHead);
+                inputTail -= inputHead;
+                inputHead = 0;
+            }
+            if (input.size() - inputTail < readChunk) {
+                input.resize(inputTail + readChunk);
+            }
+        }
+
+        size_t received;
+        if (ssl) {
+            sslWantsWrite = false;
+            int result = SSL_read(ssl, input.data() + inputTail, static_cast<int>(readChunk));
+            if (result <= 0) {
+                int error = SSL_get_error(ssl, result);
+                if (error == SSL_ERROR_WANT_READ) {
+                    return;
+                } else if (error == SSL_ERROR_WANT_WRITE) {
+                    sslWantsWrite = true;
+                    return;
+                } else if (error == SSL_ERROR_ZERO_RETURN) {
+                    serverClosed = true;
+                    return;
+                }
+                throw std::runtime_error("Failed to read SSL response");
+            }
+            received = static_cast<size_t>(result);
+        } else {
+            ssize_t result = recv(sockfd, input.data() + inputTail, readChunk, 0);
+            if (result < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    return;
+                } else if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error("Failed to read response");
+            } else if (result == 0) {
+                serverClosed = true;
+                return;
+            }
+            received = static_cast<size_t>(result);
+        }
+        Stats::getInstance().add(Stats::Counter::RECEIVE_CALLS);
+        Stats::getInstance().add(Stats::Counter::BYTES_RECEIVED, received);
+        Stats::getInstance().add(Stats::Counter::RESPONSE_BYTES, received);
+        inputTail += received;
+        total += received;
+    }
+}
+
+/**
+ * @brief Processes all complete lines and literal bytes in the receive buffer.
+ *
+ * Literal bytes of fetched messages are passed to the writer straight from the buffer, those of
+ * a metadata FETCH are kept in the response.
+ */
+void AsyncSession::parse() {
+    while (phase != Phase::DONE && phase != Phase::CONNECTING && phase != Phase::HANDSHAKING) {
+        if (inLiteral) {
+            size_t size = std::min(inputTail - inputHead, literalLeft);
+            if (size > 0 && writingLiteral) {
+                writer.write(input.data() + inputHead, size);
+            } else if (phase == Phase::FILTERING) {
+                response.append(input.data() + inputHead, size);
+            }
+            inputHead += size;
+            literalLeft -= size;
+            if (literalLeft > 0) {
+                return;
+            }
+            inLiteral = false;
+            afterLiteral = true;
+        }
+
+        const char* start = input.data() + inputHead;
+        const char* end = static_cast<const char*>(std::memchr(start, '\n', inputTail - inputHead));
+        if (!end) {
+            return;
+        }
+        std::string_view line(start, end - start);
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        inputHead += end - start + 1;
+
+        if (afterLiteral) {
+            afterLiteral = false;
+            finishLiteral(line);
+        }
+
+        size_t size;
+        if (ResponseParser::literalSize(line, size)) {
+            beginLiteral(line, size);
+            continue;
+        }
+        handleLine(line);
+    }
+}
+
+/**
+ * @brief Handles a complete response line that does not announce a literal.
+ */
+void AsyncSession::handleLine(std::string_view line) {
+    IMAPResponseType status = IMAPResponseType::UNKNOWN;
+
+    if (phase == Phase::GREETING) {
+        status = ResponseParser::greetingStatus(line);
+    } else if (phase == Phase::FETCHING) {
+        for (auto it = inFlight.begin(); it != inFlight.end(); ++it) {
+            status = ResponseParser::taggedStatus(line, *it);
+            if (status != IMAPResponseType::UNKNOWN) {
+                inFlight.erase(it);
+                break;
+            }
+        }
+    } else {
+        status = ResponseParser::taggedStatus(line, tag);
+    }
+
+    if (status == IMAPResponseType::UNKNOWN) {
+        if (!continuation.empty() && line.substr(0, 1) == "+") {
+            output += continuation.front();
+            continuation.pop_front();
+            return;
+        }
+        if (phase == Phase::SELECTING || phase == Phase::SEARCHING || phase == Phase::FILTERING) {
+            response.append(line).append("\r\n");
+        }
+        return;
+    } else if (status == IMAPResponseType::NO) {
+        throw IMAPNoResponseException(response + std::string(line));
+    } else if (status == IMAPResponseType::BAD) {
+        throw IMAPBadResponseException(response + std::string(line));
+    }
+    completed();
+}
+
+/**
+ * @brief Moves to the next step after the running command completed with OK.
+ */
+void AsyncSession::completed() {
+    switch (phase) {
+        case Phase::GREETING:
+            send(*IMAPCommandFactory::createLoginCommand(config.username, config.server, config.password));
+            enter(Phase::LOGGING_IN);
+            break;
+        case Phase::LOGGING_IN:
+            response.clear();
+            send(*IMAPCommandFactory::createSelectCommand(config.mailbox));
+            enter(Phase::SELECTING);
+            break;
+        case Phase::SELECTING:
+            selected();
+            break;
+        case Phase::SEARCHING:
+            searched();
+            break;
+        case Phase::FILTERING:
+            sendMetadataFetch();
+            break;
+        case Phase::FETCHING:
+            sendFetches();
+            break;
+        case Phase::LOGGING_OUT:
+            closeConnection();
+            enter(Phase::DONE);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Starts a literal; only message literals of wanted UIDs are written, others are dropped
+ *        except for the envelope strings of a metadata FETCH.
+ */
+void AsyncSession::beginLiteral(std::string_view line, size_t size) {
+    uint32_t sequenceNumber;
+    writingLiteral = false;
+    messageId = 0;
+
+    if (phase == Phase::FETCHING && ResponseParser::fetchId(line, sequenceNumber)) {
+        uidKnown = ResponseParser::fetchUid(line, messageId);
+        if (!uidKnown || wanted.contains(messageId)) {
+            writer.begin(messageId);
+            writingLiteral = true;
+        }
+    } else if (phase == Phase::FILTERING) {
+        response.append(line).append("\r\n");
+    }
+
+    inLiteral = true;
+    literalLeft = size;
+}
+
+/**
+ * @brief Completes the message written from the last literal, resolving a UID sent after it.
+ * @param rest The rest of the response line following the literal.
+ */
+void AsyncSession::finishLiteral(std::string_view rest) {
+    if (!writingLiteral) {
+        return;
+    }
+    writingLiteral = false;
+
+    if (!uidKnown) {
+        if (!ResponseParser::fetchUid(rest, messageId) || !wanted.contains(messageId)) {
+            writer.discard();
+            return;
+        }
+        writer.setMessageId(messageId);
+    }
+    writer.finish();
+}
+
+/**
+ * @brief Loads the sync state and searches for the UIDs not synced yet, like IMAPClient::search().
+ */
+void AsyncSession::selected() {
+    ResponseParser::responseCode(response, "UIDVALIDITY", uidValidity);
+    ResponseParser::responseCode(response, "UIDNEXT", uidNext);
+    response.clear();
+
+    state = SyncState::open(config.outDir, config.onlyHeaders, config.format, uidValidity);
+    if (config.format != "files") {
+        sink = MessageSink::create(config.format, config.outDir);
+        writer.setSink(sink);
+    }
+
+    if (!state->beginSync(uidNext)) {
+        finishSync();
+        return;
+    }
+
+    send(*IMAPCommandFactory::createSearchCommand(SearchCriteria::forSync(config, state->getFirstUid())));
+    enter(Phase::SEARCHING);
+}
+
+void AsyncSession::searched() {
+    std::vector<uint32_t> found;
+    ResponseParser::searchIds(response, found);
+    response.clear();
+
+    ids = state->takeFound(found, !SearchCriteria::fromConfig(config).empty());
+    if (ids.empty()) {
+        finishSync();
+        return;
+    }
+
+    if (MessageTable::Filter(config).active()) {
+        sequenceSets = SequenceSet::build(ids);
+        enter(Phase::FILTERING);
+        sendMetadataFetch();
+        return;
+    }
+    startFetching();
+}
+
+/**
+ * @brief Sends the metadata FETCH of the next sequence set, like IMAPClient::filterByMetadata(),
+ *        and filters the found messages after the last one.
+ */
+void AsyncSession::sendMetadataFetch() {
+    metadata.parse(response);
+    response.clear();
+
+    if (nextSet < sequenceSets.size()) {
+        send(*IMAPCommandFactory::createFetchMetadataCommand(sequenceSets[nextSet++]));
+        return;
+    }
+    filtered();
+}
+
+/**
+ * @brief Keeps the messages passing the filter; the sync does not advance past the first rejected one.
+ */
+void AsyncSession::filtered() {
+    std::vector<uint32_t> rejected;
+    ids = metadata.select(ids, MessageTable::Filter(config), rejected);
+    if (!rejected.empty()) {
+        state->holdBack(*std::min_element(rejected.begin(), rejected.end()));
+    }
+    sequenceSets.clear();
+    nextSet = 0;
+
+    if (ids.empty()) {
+        finishSync();
+        return;
+    }
+    startFetching();
+}
+
+void AsyncSession::startFetching() {
+    fetched = true;
+    wanted = MessageSet(ids);
+    sequenceSets = SequenceSet::build(ids);
+    std::filesystem::create_directories(config.outDir);
+    enter(Phase::FETCHING);
+    sendFetches();
+}
+
+/**
+ * @brief Keeps up to `pipelineWindow` FETCH commands in flight; finishes the sync after the last one.
+ */
+void AsyncSession::sendFetches() {
+    while (nextSet < sequenceSets.size() && inFlight.size() < static_cast<size_t>(config.pipelineWindow)) {
+        send(*IMAPCommandFactory::createFetchCommand(sequenceSets[nextSet++], config.onlyHeaders));
+        inFlight.push_back(tag);
+    }
+
+    if (inFlight.empty()) {
+        writer.flush();
+        finishSync();
+    }
+}
+
+/**
+ * @brief Closes the sink, saves the sync state like IMAPClient::commitSync(), reports the result and logs out.
+ */
+void AsyncSession::finishSync() {
+    if (sink) {
+        sink->close();
+    }
+    std::filesystem::create_directories(config.outDir);
+    state->commit(!config.onlyNew);
+
+    if (fetched) {
+        IMAPClient::reportSaved(saved.load(), config.mailbox);
+    } else {
+        std::cout << "No message has been downloaded from the " + config.mailbox + " mailbox\n" << std::flush;
+    }
+
+    send(*IMAPCommandFactory::createLogoutCommand());
+    enter(Phase::LOGGING_OUT);
+}
+
+void AsyncSession::fail(const std::string& message) {
+    std::cerr << "Error: " + config.mailbox + ": " + message + "\n";
+    failed = true;
+    if (writingLiteral) {
+        writer.discard();
+        writingLiteral = false;
+    }
+    closeConnection();
+    phase = Phase::DONE;
+}
+
+void AsyncSession::closeConnection() {
+    if (ssl) {
+        SSL_shutdown(ssl);
+        SSL_free(ssl);
+        ssl = nullptr;
+    }
+    if (sockfd >= 0) {
+        close(sockfd);
+        sockfd = -1;
+    }
+}
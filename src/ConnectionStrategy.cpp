@@ -0,0 +1,334 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#include "../include/ConnectionStrategy.h"
+#include "../include/Stats.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <cerrno>
+#include <unistd.h>
+#include <fcntl.h>
+
+/**
+ * @brief Receives more data behind the buffered bytes.
+ * @throws std::runtime_error if the server closed the connection or the socket is non-blocking.
+ */
+void ConnectionStrategy::fill() {
+    if (!tryFill()) {
+        throw std::runtime_error("No data available on a non-blocking connection");
+    }
+}
+
+/**
+ * @brief Receives more data behind the buffered bytes, unless a non-blocking socket has none.
+ *
+ * Unread bytes are moved to the front of the buffer first; the buffer is only enlarged
+ * when it is completely filled with unread data (a line longer than the buffer).
+ * @return False if nothing was received because the socket would block.
+ * @throws std::runtime_error if the server closed the connection.
+ */
+bool ConnectionStrategy::tryFill() {
+    if (buffer.empty()) {
+        buffer.resize(initialBufferSize);
+    }
+
+    if (head > 0) {
+        std::memmove(buffer.data(), buffer.data() + head, tail - head);
+        tail -= head;
+        head = 0;
+    }
+
+    if (tail == buffer.size()) {
+        buffer.resize(buffer.size() * 2);
+    }
+
+    size_t received = inflater ? receiveInflated(buffer.data() + tail, buffer.size() - tail)
+                               : receiveCounted(buffer.data() + tail, buffer.size() - tail);
+    if (received == wouldBlock) {
+        return false;
+    }
+    traffic.received += received;
+    Stats::getInstance().add(Stats::Counter::RESPONSE_BYTES, received);
+    if (received == 0) {
+        throw std::runtime_error("Connection closed by server");
+    }
+    tail += received;
+    return true;
+}
+
+/**
+ * @brief Looks for the end of the next line in the buffered data.
+ *
+ * Bytes already searched are not searched again after more data arrives.
+ * @param length Set to the length of the line including the terminating LF, counted from head.
+ * @return False if no complete line is buffered.
+ */
+bool ConnectionStrategy::findLine(size_t& length) {
+    size_t available = tail - head;
+    if (available > scanned) {
+        const char* lineEnd = static_cast<const char*>(
+                std::memchr(buffer.data() + head + scanned, '\n', available - scanned));
+        if (lineEnd) {
+            scanned = lineEnd - (buffer.data() + head);
+            length = scanned + 1;
+            return true;
+        }
+    }
+    scanned = available;
+    return false;
+}
+
+/**
+ * @brief Makes sure a complete line is buffered.
+ * @return The length of the line including the terminating LF, counted from head.
+ */
+size_t ConnectionStrategy::bufferLine() {
+    size_t length;
+    while (!findLine(length)) {
+        fill();
+    }
+    return length;
+}
+
+/**
+ * @brief Strips the line terminator from a buffered line.
+ */
+static std::string_view withoutTerminator(const char* lineStart, size_t length) {
+    length--;   // LF
+    if (length > 0 && lineStart[length - 1] == '\r') {
+        --length;
+    }
+    return {lineStart, length};
+}
+
+std::string_view ConnectionStrategy::consumeLine(size_t length) {
+    const char* lineStart = buffer.data() + head;
+    head += length;
+    scanned = 0;
+    return withoutTerminator(lineStart, length);
+}
+
+std::string_view ConnectionStrategy::readLine() {
+    return consumeLine(bufferLine());
+}
+
+bool ConnectionStrategy::tryReadLine(std::string_view& line) {
+    size_t length;
+    while (!findLine(length)) {
+        if (!tryFill()) {
+            return false;
+        }
+    }
+    line = consumeLine(length);
+    return true;
+}
+
+std::string_view ConnectionStrategy::peekLine() {
+    size_t length = bufferLine();
+    return withoutTerminator(buffer.data() + head, length);
+}
+
+std::string_view ConnectionStrategy::readExact(size_t size) {
+    while (tail - head < size) {
+        if (buffer.size() < size) {
+            buffer.resize(size);
+        }
+        fill();
+    }
+
+    std::string_view data(buffer.data() + head, size);
+    head += size;
+    scanned = 0;
+    return data;
+}
+
+std::string_view ConnectionStrategy::readSome(size_t maxSize) {
+    if (head == tail) {
+        fill();
+    }
+    return takeBuffered(maxSize);
+}
+
+bool ConnectionStrategy::tryReadSome(size_t maxSize, std::string_view& data) {
+    if (head == tail && !tryFill()) {
+        return false;
+    }
+    data = takeBuffered(maxSize);
+    return true;
+}
+
+bool ConnectionStrategy::readToFile(int fd, size_t size) {
+    bool ok = true;
+    while (size > 0) {
+        std::string_view data = readSome(size);
+        ok = ok && writeAll(fd, data);
+        size -= data.size();
+    }
+    return ok;
+}
+
+std::string_view ConnectionStrategy::takeBuffered(size_t maxSize) {
+    size_t size = std::min(maxSize, tail - head);
+    std::string_view data(buffer.data() + head, size);
+    head += size;
+    scanned = 0;
+    return data;
+}
+
+bool ConnectionStrategy::writeAll(int fd, std::string_view data) {
+    Stats& stats = Stats::getInstance();
+    while (!data.empty()) {
+        auto start = stats.now();
+        ssize_t written = write(fd, data.data(), data.size());
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        stats.diskWrite(static_cast<uint64_t>(written), start);
+        data.remove_prefix(static_cast<size_t>(written));
+    }
+    return true;
+}
+
+void ConnectionStrategy::resetBuffer() {
+    head = 0;
+    tail = 0;
+    scanned = 0;
+    inflater.reset();
+    deflater.reset();
+    compressedHead = 0;
+    compressedTail = 0;
+    traffic = Traffic();
+}
+
+void ConnectionStrategy::sendCommand(const std::string& command) {
+    traffic.sent += command.size();
+    if (!deflater) {
+        transmit(command.data(), command.size());
+        traffic.wireSent += command.size();
+        countSent(command.size());
+        return;
+    }
+
+    deflater->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(command.data()));
+    deflater->avail_in = static_cast<uInt>(command.size());
+    do {
+        // a sync flush makes the server see the complete command right away
+        deflater->next_out = reinterpret_cast<Bytef*>(deflated.data());
+        deflater->avail_out = static_cast<uInt>(deflated.size());
+        if (deflate(deflater.get(), Z_SYNC_FLUSH) == Z_STREAM_ERROR) {
+            throw std::runtime_error("Failed to compress command");
+        }
+        size_t size = deflated.size() - deflater->avail_out;
+        transmit(deflated.data(), size);
+        traffic.wireSent += size;
+        countSent(size);
+    } while (deflater->avail_out == 0);
+}
+
+void ConnectionStrategy::startCompression() {
+    inflater.reset(new z_stream{});
+    deflater.reset(new z_stream{});
+
+    // RFC 4978: raw deflate without zlib header, hence the negative window bits
+    if (inflateInit2(inflater.get(), -15) != Z_OK) {
+        delete inflater.release();
+        throw std::runtime_error("Failed to start decompression");
+    }
+    if (deflateInit2(deflater.get(), Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        delete deflater.release();
+        inflater.reset();
+        throw std::runtime_error("Failed to start compression");
+    }
+
+    // anything the server sent after the COMPRESS response is already compressed
+    compressed.resize(std::max(initialBufferSize, tail - head));
+    deflated.resize(16 * 1024);
+
+    compressedTail = tail - head;
+    std::memcpy(compressed.data(), buffer.data() + head, compressedTail);
+    compressedHead = 0;
+    traffic.received -= compressedTail;
+    head = tail = scanned = 0;
+}
+
+void ConnectionStrategy::setNonBlocking() {
+    int fd = getSocket();
+    int flags = fd < 0 ? -1 : fcntl(fd, F_GETFL);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) != 0) {
+        throw std::runtime_error("Failed to switch the connection to non-blocking mode");
+    }
+}
+
+bool ConnectionStrategy::isCompressed() const {
+    return inflater != nullptr;
+}
+
+const ConnectionStrategy::Traffic& ConnectionStrategy::getTraffic() const {
+    return traffic;
+}
+
+void ConnectionStrategy::countReceived(size_t size) {
+    traffic.received += size;
+    traffic.wireReceived += size;
+    Stats::getInstance().add(Stats::Counter::BYTES_RECEIVED, size);
+    Stats::getInstance().add(Stats::Counter::RESPONSE_BYTES, size);
+}
+
+/**
+ * @brief Counts one transmit() call of the given size in the process stats.
+ */
+void ConnectionStrategy::countSent(size_t size) {
+    Stats::getInstance().add(Stats::Counter::SEND_CALLS);
+    Stats::getInstance().add(Stats::Counter::BYTES_SENT, size);
+}
+
+size_t ConnectionStrategy::receiveCounted(char* data, size_t size) {
+    size_t received = receive(data, size);
+    if (received == wouldBlock) {
+        return wouldBlock;
+    }
+    traffic.wireReceived += received;
+    Stats::getInstance().add(Stats::Counter::RECEIVE_CALLS);
+    Stats::getInstance().add(Stats::Counter::BYTES_RECEIVED, received);
+    return received;
+}
+
+/**
+ * @brief Inflates received data into data, receiving more compressed data as needed.
+ * @return The number of inflated bytes, 0 if the server closed the connection, wouldBlock if
+ *         a non-blocking socket has no data.
+ * @throws std::runtime_error if the received data is not a valid deflate stream.
+ */
+size_t ConnectionStrategy::receiveInflated(char* data, size_t size) {
+    while (true) {
+        if (compressedHead == compressedTail) {
+            size_t received = receiveCounted(compressed.data(), compressed.size());
+            if (received == 0 || received == wouldBlock) {
+                return received;
+            }
+            compressedHead = 0;
+            compressedTail = received;
+        }
+
+        inflater->next_in = reinterpret_cast<Bytef*>(compressed.data() + compressedHead);
+        inflater->avail_in = static_cast<uInt>(compressedTail - compressedHead);
+        inflater->next_out = reinterpret_cast<Bytef*>(data);
+        inflater->avail_out = static_cast<uInt>(std::min<size_t>(size, UINT32_MAX));
+
+        int status = inflate(inflater.get(), Z_SYNC_FLUSH);
+        if (status != Z_OK && status != Z_BUF_ERROR) {
+            throw std::runtime_error("Failed to decompress response");
+        }
+        compressedHead = compressedTail - inflater->avail_in;
+
+        size_t produced = reinterpret_cast<char*>(inflater->next_out) - data;
+        if (produced > 0) {
+            return produced;
+        }
+    }
+}
@@ -0,0 +1,120 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#include "../include/EventLoop.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include <cerrno>
+#include <utility>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+EventLoop::EventLoop(size_t maxSessions) : maxSessions(std::max<size_t>(maxSessions, 1)) {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) {
+        throw std::runtime_error("Failed to create epoll instance");
+    }
+}
+
+EventLoop::~EventLoop() {
+    close(epollFd);
+}
+
+void EventLoop::add(std::unique_ptr<AsyncSession> session) {
+    waiting.push_back(std::move(session));
+}
+
+int EventLoop::run() {
+    epoll_event events[maxEvents];
+    startWaiting();
+
+    while (!active.empty()) {
+        int count = epoll_wait(epollFd, events, maxEvents, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Failed to wait for events");
+        }
+
+        for (int i = 0; i < count; ++i) {
+            auto* entry = static_cast<Active*>(events[i].data.ptr);
+            entry->session->handle(events[i].events);
+            update(*entry);
+        }
+
+        // finished sessions are removed only now, later events of this batch may still point to them
+        for (auto& entry : active) {
+            if (entry->session->isFinished()) {
+                remove(*entry);
+            }
+        }
+        active.erase(std::remove_if(active.begin(), active.end(),
+                                    [](const std::unique_ptr<Active>& entry) { return !entry->session; }),
+                     active.end());
+        startWaiting();
+    }
+    return failed;
+}
+
+/**
+ * @brief Starts waiting sessions until maxSessions are running.
+ */
+void EventLoop::startWaiting() {
+    while (active.size() < maxSessions && !waiting.empty()) {
+        auto entry = std::make_unique<Active>();
+        entry->session = std::move(waiting.front());
+        waiting.pop_front();
+
+        entry->session->start();
+        if (entry->session->isFinished()) {
+            remove(*entry);
+            continue;
+        }
+        update(*entry);
+        active.push_back(std::move(entry));
+    }
+}
+
+/**
+ * @brief Registers the current socket and events of the session, or removes it once finished.
+ *
+ * The socket changes when connecting falls back to the next address.
+ */
+void EventLoop::update(Active& entry) {
+    if (!entry.session || entry.session->isFinished()) {
+        return;
+    }
+
+    int fd = entry.session->getFd();
+    uint32_t interest = entry.session->getInterest();
+    if (fd == entry.fd && interest == entry.interest) {
+        return;
+    }
+
+    epoll_event event{};
+    event.events = interest;
+    event.data.ptr = &entry;
+
+    // the old socket is already closed and thereby removed from epoll
+    if (fd != entry.fd || epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event) != 0) {
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            throw std::runtime_error("Failed to register socket with epoll");
+        }
+    }
+    entry.fd = fd;
+    entry.interest = interest;
+}
+
+void EventLoop::remove(Active& entry) {
+    if (!entry.session) {
+        return;
+    }
+    if (entry.session->hasFailed()) {
+        failed++;
+    }
+    entry.session.reset();
+    entry.fd = -1;
+}
@@ -0,0 +1,93 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#include "../include/Executor.h"
+
+#include <stdexcept>
+#include <cerrno>
+#include <utility>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+Executor::Executor() {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) {
+        throw std::runtime_error("Failed to create epoll instance");
+    }
+}
+
+Executor::~Executor() {
+    close(epollFd);
+}
+
+void Executor::spawn(Task<> task) {
+    task.start();
+    tasks.push_back(std::move(task));
+}
+
+void Executor::run() {
+    epoll_event events[maxEvents];
+    finishTasks();
+
+    while (!tasks.empty()) {
+        if (waiting == 0) {
+            throw std::runtime_error("Tasks are suspended without waiting for a socket");
+        }
+
+        int count = epoll_wait(epollFd, events, maxEvents, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Failed to wait for events");
+        }
+
+        for (int i = 0; i < count; ++i) {
+            waiting--;
+            std::coroutine_handle<>::from_address(events[i].data.ptr).resume();
+        }
+        finishTasks();
+    }
+}
+
+Executor::SocketAwaiter Executor::readable(int fd) {
+    return {*this, fd, EPOLLIN};
+}
+
+Executor::SocketAwaiter Executor::writable(int fd) {
+    return {*this, fd, EPOLLOUT};
+}
+
+/**
+ * @brief Arms a one-shot registration of the socket that resumes the coroutine.
+ *
+ * The socket stays in epoll between waits, so it is modified rather than added again;
+ * sockets closed in the meantime have left epoll and are added anew.
+ */
+void Executor::wait(int fd, uint32_t events, std::coroutine_handle<> handle) {
+    epoll_event event{};
+    event.events = events | EPOLLONESHOT;
+    event.data.ptr = handle.address();
+
+    if (epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event) != 0 &&
+        (errno != ENOENT || epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0)) {
+        throw std::runtime_error("Failed to register socket with epoll");
+    }
+    waiting++;
+}
+
+/**
+ * @brief Drops the finished tasks, rethrowing the exception of the first failed one.
+ */
+void Executor::finishTasks() {
+    for (size_t i = 0; i < tasks.size();) {
+        if (!tasks[i].isDone()) {
+            ++i;
+            continue;
+        }
+        Task<> task = std::move(tasks[i]);
+        tasks.erase(tasks.begin() + static_cast<std::ptrdiff_t>(i));
+        task.result();
+    }
+}
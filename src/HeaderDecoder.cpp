@@ -0,0 +1,359 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#include "HeaderDecoder.h"
+#include "MimeDecoder.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+    /*
+     * Code points of the bytes 0x80-0xFF; bytes below 0x80 are ASCII in every table.
+     * Unassigned bytes map to U+FFFD.
+     */
+
+    /// ISO-8859-2 (Latin-2)
+    constexpr uint16_t iso8859_2[128] = {
+            0x0080, 0x0081, 0x0082, 0x0083, 0x0084, 0x0085, 0x0086, 0x0087,
+            0x0088, 0x0089, 0x008A, 0x008B, 0x008C, 0x008D, 0x008E, 0x008F,
+            0x0090, 0x0091, 0x0092, 0x0093, 0x0094, 0x0095, 0x0096, 0x0097,
+            0x0098, 0x0099, 0x009A, 0x009B, 0x009C, 0x009D, 0x009E, 0x009F,
+            0x00A0, 0x0104, 0x02D8, 0x0141, 0x00A4, 0x013D, 0x015A, 0x00A7,
+            0x00A8, 0x0160, 0x015E, 0x0164, 0x0179, 0x00AD, 0x017D, 0x017B,
+            0x00B0, 0x0105, 0x02DB, 0x0142, 0x00B4, 0x013E, 0x015B, 0x02C7,
+            0x00B8, 0x0161, 0x015F, 0x0165, 0x017A, 0x02DD, 0x017E, 0x017C,
+            0x0154, 0x00C1, 0x00C2, 0x0102, 0x00C4, 0x0139, 0x0106, 0x00C7,
+            0x010C, 0x00C9, 0x0118, 0x00CB, 0x011A, 0x00CD, 0x00CE, 0x010E,
+            0x0110, 0x0143, 0x0147, 0x00D3, 0x00D4, 0x0150, 0x00D6, 0x00D7,
+            0x0158, 0x016E, 0x00DA, 0x0170, 0x00DC, 0x00DD, 0x0162, 0x00DF,
+            0x0155, 0x00E1, 0x00E2, 0x0103, 0x00E4, 0x013A, 0x0107, 0x00E7,
+            0x010D, 0x00E9, 0x0119, 0x00EB, 0x011B, 0x00ED, 0x00EE, 0x010F,
+            0x0111, 0x0144, 0x0148, 0x00F3, 0x00F4, 0x0151, 0x00F6, 0x00F7,
+            0x0159, 0x016F, 0x00FA, 0x0171, 0x00FC, 0x00FD, 0x0163, 0x02D9
+    };
+
+    /// ISO-8859-15 (Latin-9)
+    constexpr uint16_t iso8859_15[128] = {
+            0x0080, 0x0081, 0x0082, 0x0083, 0x0084, 0x0085, 0x0086, 0x0087,
+            0x0088, 0x0089, 0x008A, 0x008B, 0x008C, 0x008D, 0x008E, 0x008F,
+            0x0090, 0x0091, 0x0092, 0x0093, 0x0094, 0x0095, 0x0096, 0x0097,
+            0x0098, 0x0099, 0x009A, 0x009B, 0x009C, 0x009D, 0x009E, 0x009F,
+            0x00A0, 0x00A1, 0x00A2, 0x00A3, 0x20AC, 0x00A5, 0x0160, 0x00A7,
+            0x0161, 0x00A9, 0x00AA, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x00AF,
+            0x00B0, 0x00B1, 0x00B2, 0x00B3, 0x017D, 0x00B5, 0x00B6, 0x00B7,
+            0x017E, 0x00B9, 0x00BA, 0x00BB, 0x0152, 0x0153, 0x0178, 0x00BF,
+            0x00C0, 0x00C1, 0x00C2, 0x00C3, 0x00C4, 0x00C5, 0x00C6, 0x00C7,
+            0x00C8, 0x00C9, 0x00CA, 0x00CB, 0x00CC, 0x00CD, 0x00CE, 0x00CF,
+            0x00D0, 0x00D1, 0x00D2, 0x00D3, 0x00D4, 0x00D5, 0x00D6, 0x00D7,
+            0x00D8, 0x00D9, 0x00DA, 0x00DB, 0x00DC, 0x00DD, 0x00DE, 0x00DF,
+            0x00E0, 0x00E1, 0x00E2, 0x00E3, 0x00E4, 0x00E5, 0x00E6, 0x00E7,
+            0x00E8, 0x00E9, 0x00EA, 0x00EB, 0x00EC, 0x00ED, 0x00EE, 0x00EF,
+            0x00F0, 0x00F1, 0x00F2, 0x00F3, 0x00F4, 0x00F5, 0x00F6, 0x00F7,
+            0x00F8, 0x00F9, 0x00FA, 0x00FB, 0x00FC, 0x00FD, 0x00FE, 0x00FF
+    };
+
+    /// Windows-1250
+    constexpr uint16_t windows1250[128] = {
+            0x20AC, 0xFFFD, 0x201A, 0xFFFD, 0x201E, 0x2026, 0x2020, 0x2021,
+            0xFFFD, 0x2030, 0x0160, 0x2039, 0x015A, 0x0164, 0x017D, 0x0179,
+            0xFFFD, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+            0xFFFD, 0x2122, 0x0161, 0x203A, 0x015B, 0x0165, 0x017E, 0x017A,
+            0x00A0, 0x02C7, 0x02D8, 0x0141, 0x00A4, 0x0104, 0x00A6, 0x00A7,
+            0x00A8, 0x00A9, 0x015E, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x017B,
+            0x00B0, 0x00B1, 0x02DB, 0x0142, 0x00B4, 0x00B5, 0x00B6, 0x00B7,
+            0x00B8, 0x0105, 0x015F, 0x00BB, 0x013D, 0x02DD, 0x013E, 0x017C,
+            0x0154, 0x00C1, 0x00C2, 0x0102, 0x00C4, 0x0139, 0x0106, 0x00C7,
+            0x010C, 0x00C9, 0x0118, 0x00CB, 0x011A, 0x00CD, 0x00CE, 0x010E,
+            0x0110, 0x0143, 0x0147, 0x00D3, 0x00D4, 0x0150, 0x00D6, 0x00D7,
+            0x0158, 0x016E, 0x00DA, 0x0170, 0x00DC, 0x00DD, 0x0162, 0x00DF,
+            0x0155, 0x00E1, 0x00E2, 0x0103, 0x00E4, 0x013A, 0x0107, 0x00E7,
+            0x010D, 0x00E9, 0x0119, 0x00EB, 0x011B, 0x00ED, 0x00EE, 0x010F,
+            0x0111, 0x0144, 0x0148, 0x00F3, 0x00F4, 0x0151, 0x00F6, 0x00F7,
+            0x0159, 0x016F, 0x00FA, 0x0171, 0x00FC, 0x00FD, 0x0163, 0x02D9
+    };
+
+    /// Windows-1251
+    constexpr uint16_t windows1251[128] = {
+            0x0402, 0x0403, 0x201A, 0x0453, 0x201E, 0x2026, 0x2020, 0x2021,
+            0x20AC, 0x2030, 0x0409, 0x2039, 0x040A, 0x040C, 0x040B, 0x040F,
+            0x0452, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+            0xFFFD, 0x2122, 0x0459, 0x203A, 0x045A, 0x045C, 0x045B, 0x045F,
+            0x00A0, 0x040E, 0x045E, 0x0408, 0x00A4, 0x0490, 0x00A6, 0x00A7,
+            0x0401, 0x00A9, 0x0404, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x0407,
+            0x00B0, 0x00B1, 0x0406, 0x0456, 0x0491, 0x00B5, 0x00B6, 0x00B7,
+            0x0451, 0x2116, 0x0454, 0x00BB, 0x0458, 0x0405, 0x0455, 0x0457,
+            0x0410, 0x0411, 0x0412, 0x0413, 0x0414, 0x0415, 0x0416, 0x0417,
+            0x0418, 0x0419, 0x041A, 0x041B, 0x041C, 0x041D, 0x041E, 0x041F,
+            0x0420, 0x0421, 0x0422, 0x0423, 0x0424, 0x0425, 0x0426, 0x0427,
+            0x0428, 0x0429, 0x042A, 0x042B, 0x042C, 0x042D, 0x042E, 0x042F,
+            0x0430, 0x0431, 0x0432, 0x0433, 0x0434, 0x0435, 0x0436, 0x0437,
+            0x0438, 0x0439, 0x043A, 0x043B, 0x043C, 0x043D, 0x043E, 0x043F,
+            0x0440, 0x0441, 0x0442, 0x0443, 0x0444, 0x0445, 0x0446, 0x0447,
+            0x0448, 0x0449, 0x044A, 0x044B, 0x044C, 0x044D, 0x044E, 0x044F
+    };
+
+    /// Windows-1252, the five unassigned bytes map to the C1 controls as in WHATWG
+    constexpr uint16_t windows1252[128] = {
+            0x20AC, 0x0081, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,
+            0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0x008D, 0x017D, 0x008F,
+            0x0090, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+            0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x009D, 0x017E, 0x0178,
+            0x00A0, 0x00A1, 0x00A2, 0x00A3, 0x00A4, 0x00A5, 0x00A6, 0x00A7,
+            0x00A8, 0x00A9, 0x00AA, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x00AF,
+            0x00B0, 0x00B1, 0x00B2, 0x00B3, 0x00B4, 0x00B5, 0x00B6, 0x00B7,
+            0x00B8, 0x00B9, 0x00BA, 0x00BB, 0x00BC, 0x00BD, 0x00BE, 0x00BF,
+            0x00C0, 0x00C1, 0x00C2, 0x00C3, 0x00C4, 0x00C5, 0x00C6, 0x00C7,
+            0x00C8, 0x00C9, 0x00CA, 0x00CB, 0x00CC, 0x00CD, 0x00CE, 0x00CF,
+            0x00D0, 0x00D1, 0x00D2, 0x00D3, 0x00D4, 0x00D5, 0x00D6, 0x00D7,
+            0x00D8, 0x00D9, 0x00DA, 0x00DB, 0x00DC, 0x00DD, 0x00DE, 0x00DF,
+            0x00E0, 0x00E1, 0x00E2, 0x00E3, 0x00E4, 0x00E5, 0x00E6, 0x00E7,
+            0x00E8, 0x00E9, 0x00EA, 0x00EB, 0x00EC, 0x00ED, 0x00EE, 0x00EF,
+            0x00F0, 0x00F1, 0x00F2, 0x00F3, 0x00F4, 0x00F5, 0x00F6, 0x00F7,
+            0x00F8, 0x00F9, 0x00FA, 0x00FB, 0x00FC, 0x00FD, 0x00FE, 0x00FF
+    };
+
+    /// KOI8-R
+    constexpr uint16_t koi8r[128] = {
+            0x2500, 0x2502, 0x250C, 0x2510, 0x2514, 0x2518, 0x251C, 0x2524,
+            0x252C, 0x2534, 0x253C, 0x2580, 0x2584, 0x2588, 0x258C, 0x2590,
+            0x2591, 0x2592, 0x2593, 0x2320, 0x25A0, 0x2219, 0x221A, 0x2248,
+            0x2264, 0x2265, 0x00A0, 0x2321, 0x00B0, 0x00B2, 0x00B7, 0x00F7,
+            0x2550, 0x2551, 0x2552, 0x0451, 0x2553, 0x2554, 0x2555, 0x2556,
+            0x2557, 0x2558, 0x2559, 0x255A, 0x255B, 0x255C, 0x255D, 0x255E,
+            0x255F, 0x2560, 0x2561, 0x0401, 0x2562, 0x2563, 0x2564, 0x2565,
+            0x2566, 0x2567, 0x2568, 0x2569, 0x256A, 0x256B, 0x256C, 0x00A9,
+            0x044E, 0x0430, 0x0431, 0x0446, 0x0434, 0x0435, 0x0444, 0x0433,
+            0x0445, 0x0438, 0x0439, 0x043A, 0x043B, 0x043C, 0x043D, 0x043E,
+            0x043F, 0x044F, 0x0440, 0x0441, 0x0442, 0x0443, 0x0436, 0x0432,
+            0x044C, 0x044B, 0x0437, 0x0448, 0x044D, 0x0449, 0x0447, 0x044A,
+            0x042E, 0x0410, 0x0411, 0x0426, 0x0414, 0x0415, 0x0424, 0x0413,
+            0x0425, 0x0418, 0x0419, 0x041A, 0x041B, 0x041C, 0x041D, 0x041E,
+            0x041F, 0x042F, 0x0420, 0x0421, 0x0422, 0x0423, 0x0416, 0x0412,
+            0x042C, 0x042B, 0x0417, 0x0428, 0x042D, 0x0429, 0x0427, 0x042A
+    };
+
+    /**
+     * @brief A charset name and its table, nullptr for charsets copied unchanged (UTF-8, ASCII).
+     */
+    struct Charset {
+        std::string_view name;
+        const uint16_t* table;
+    };
+
+    // ISO-8859-1 labels are decoded as Windows-1252, its superset in practice (WHATWG Encoding)
+    constexpr Charset charsets[] = {
+            {"utf-8", nullptr}, {"utf8", nullptr}, {"us-ascii", nullptr}, {"ascii", nullptr},
+            {"iso-8859-1", windows1252}, {"iso8859-1", windows1252}, {"latin1", windows1252},
+            {"windows-1252", windows1252}, {"cp1252", windows1252},
+            {"iso-8859-2", iso8859_2}, {"iso8859-2", iso8859_2}, {"latin2", iso8859_2},
+            {"windows-1250", windows1250}, {"cp1250", windows1250},
+            {"iso-8859-15", iso8859_15}, {"iso8859-15", iso8859_15}, {"latin9", iso8859_15},
+            {"windows-1251", windows1251}, {"cp1251", windows1251},
+            {"koi8-r", koi8r},
+    };
+
+    char lower(char c) {
+        return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+        return a.size() == b.size() &&
+               std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) { return lower(x) == lower(y); });
+    }
+
+    const Charset* findCharset(std::string_view name) {
+        name = name.substr(0, name.find('*'));
+        for (const auto& charset : charsets) {
+            if (equalsIgnoreCase(charset.name, name)) {
+                return &charset;
+            }
+        }
+        return nullptr;
+    }
+
+    void appendUtf8(uint16_t codePoint, std::string& output) {
+        if (codePoint < 0x800) {
+            output += static_cast<char>(0xC0 | codePoint >> 6);
+            output += static_cast<char>(0x80 | (codePoint & 0x3F));
+        } else {
+            output += static_cast<char>(0xE0 | codePoint >> 12);
+            output += static_cast<char>(0x80 | (codePoint >> 6 & 0x3F));
+            output += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+    }
+
+    bool isBlank(char c) {
+        return c == ' ' || c == '\t';
+    }
+
+    /**
+     * @brief The parts of an encoded word `=?charset?encoding?text?=`.
+     */
+    struct EncodedWord {
+        std::string_view charset;
+        char encoding = 0;
+        std::string_view text;
+    };
+
+    /**
+     * @brief Parses the encoded word starting at `start` (at its `=?`).
+     * @return The position after the closing `?=`, 0 if there is no valid encoded word.
+     */
+    size_t parseEncodedWord(std::string_view value, size_t start, EncodedWord& word) {
+        size_t pos = start + 2;
+        while (pos < value.size() && value[pos] != '?' && !isBlank(value[pos]) && value[pos] != '\r' &&
+               value[pos] != '\n') {
+            ++pos;
+        }
+        if (pos == start + 2 || pos + 2 >= value.size() || value[pos] != '?' || value[pos + 2] != '?') {
+            return 0;
+        }
+        char encoding = lower(value[pos + 1]);
+        if (encoding != 'b' && encoding != 'q') {
+            return 0;
+        }
+
+        // the text holds neither `?` nor whitespace
+        size_t textStart = pos + 3;
+        size_t textEnd = textStart;
+        while (textEnd < value.size() && value[textEnd] != '?') {
+            if (isBlank(value[textEnd]) || value[textEnd] == '\r' || value[textEnd] == '\n') {
+                return 0;
+            }
+            ++textEnd;
+        }
+        if (textEnd + 1 >= value.size() || value[textEnd + 1] != '=') {
+            return 0;
+        }
+
+        word.charset = value.substr(start + 2, pos - start - 2);
+        word.encoding = encoding;
+        word.text = value.substr(textStart, textEnd - textStart);
+        return textEnd + 2;
+    }
+}
+
+bool HeaderDecoder::findField(std::string_view headers, std::string_view name, std::string_view& value) {
+    size_t lineStart = 0;
+    while (lineStart < headers.size()) {
+        size_t lineEnd = headers.find('\n', lineStart);
+        if (lineEnd == std::string_view::npos) {
+            lineEnd = headers.size();
+        }
+        std::string_view line = headers.substr(lineStart, lineEnd - lineStart);
+        if (line.empty() || line == "\r") {
+            return false;   // end of the header block
+        }
+
+        if (line.size() > name.size() && line[name.size()] == ':' && equalsIgnoreCase(line.substr(0, name.size()), name)) {
+            // continuation lines start with whitespace
+            size_t valueEnd = lineEnd;
+            while (valueEnd + 1 < headers.size() && isBlank(headers[valueEnd + 1])) {
+                valueEnd = headers.find('\n', valueEnd + 1);
+                if (valueEnd == std::string_view::npos) {
+                    valueEnd = headers.size();
+                }
+            }
+            size_t valueStart = lineStart + name.size() + 1;
+            value = headers.substr(valueStart, valueEnd - valueStart);
+            if (!value.empty() && value.back() == '\r') {
+                value.remove_suffix(1);
+            }
+            return true;
+        }
+        lineStart = lineEnd + 1;
+    }
+    return false;
+}
+
+std::string HeaderDecoder::decode(std::string_view value) {
+    std::string output;
+    output.reserve(value.size());
+    std::string bytes;          // an encoded word before the charset conversion
+    size_t whitespace = std::string::npos;     // start of the whitespace written last, npos after text
+    bool afterEncodedWord = false;
+
+    size_t i = 0;
+    while (i < value.size()) {
+        char c = value[i];
+        if (c == '\r' || c == '\n') {
+            // unfolding removes the line break and keeps the whitespace after it
+            ++i;
+            continue;
+        }
+        if (isBlank(c)) {
+            if (whitespace == std::string::npos) {
+                whitespace = output.size();
+            }
+            output += c;
+            ++i;
+            continue;
+        }
+
+        EncodedWord word;
+        size_t end = c == '=' && i + 1 < value.size() && value[i + 1] == '?' ? parseEncodedWord(value, i, word) : 0;
+        if (end != 0) {
+            if (afterEncodedWord && whitespace != std::string::npos) {
+                output.resize(whitespace);  // adjacent encoded words are joined
+            }
+            bytes.clear();
+            if (word.encoding == 'b') {
+                Base64Decoder decoder;
+                decoder.update(word.text, bytes);
+                decoder.finish(bytes);
+            } else {
+                QuotedPrintableDecoder decoder(true);
+                decoder.update(word.text, bytes);
+                decoder.finish(bytes);
+            }
+            toUtf8(word.charset, bytes, output);
+            afterEncodedWord = true;
+            i = end;
+        } else {
+            // plain text up to the next whitespace, line break or possible encoded word
+            size_t textEnd = i + 1;
+            while (textEnd < value.size() && !isBlank(value[textEnd]) && value[textEnd] != '\r' &&
+                   value[textEnd] != '\n' && value[textEnd] != '=') {
+                ++textEnd;
+            }
+            output.append(value, i, textEnd - i);
+            afterEncodedWord = false;
+            i = textEnd;
+        }
+        whitespace = std::string::npos;
+    }
+
+    size_t first = output.find_first_not_of(" \t");
+    if (first == std::string::npos) {
+        return {};
+    }
+    output.erase(output.find_last_not_of(" \t") + 1);
+    output.erase(0, first);
+    return output;
+}
+
+bool HeaderDecoder::toUtf8(std::string_view charset, std::string_view text, std::string& output) {
+    const Charset* known = findCharset(charset);
+    if (!known || !known->table) {
+        output.append(text);
+        return known != nullptr;
+    }
+
+    size_t i = 0;
+    while (i < text.size()) {
+        // ASCII runs are copied as a whole
+        size_t ascii = i;
+        while (ascii < text.size() && static_cast<unsigned char>(text[ascii]) < 0x80) {
+            ++ascii;
+        }
+        output.append(text, i, ascii - i);
+        if (ascii < text.size()) {
+            appendUtf8(known->table[static_cast<unsigned char>(text[ascii]) - 0x80], output);
+            ++ascii;
+        }
+        i = ascii;
+    }
+    return true;
+}
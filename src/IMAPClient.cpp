@@ -11,6 +11,14 @@
 #include "ConnectionStrategy.h"
 #include "SSLConnectionStrategy.h"
 #include "TCPConnectionStrategy.h"
+#include "ResponseParser.h"
+#include "SequenceSet.h"
+#include "SyncState.h"
+#include "MessageSink.h"
+#include "Stats.h"
+#include "HeaderDecoder.h"
+#include "MessageTable.h"
+#include "SearchCriteria.h"
 
 #include <sys/socket.h>
 #include <arpa/inet.h>
@@ -20,12 +28,14 @@
 #include <stdexcept>
 #include <utility>
 #include <vector>
-#include <sstream>
-#include <regex>
+#include <deque>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
 #include <fstream>
 #include <filesystem>
-#include <openssl/bio.h>
-#include <openssl/evp.h>
+#include <system_error>
+#include <fcntl.h>
 
 /**
  * @brief Constructs an IMAPClient with specified configuration.
@@ -34,7 +44,9 @@
  * @param config Configuration struct containing server details, SSL settings, and other options.
  */
 IMAPClient::IMAPClient(ArgParser::Config config)
-        : config(config), currTagNum(1) {
+        : config(config), currTagNum(1),
+          writer([this](uint32_t messageId, const std::string& headers) { return messageFilename(this->config.outDir, messageId, headers); },
+                 [this](uint32_t messageId, const std::string& filename, bool saved) { messageStored(messageId, filename, saved); }) {
 
     if (config.useSSL) {
         strategy = std::make_unique<SSLConnectionStrategy>(
@@ -54,8 +66,10 @@ IMAPClient::IMAPClient(ArgParser::Config config)
  * @throws std::runtime_error if the connection fails.
  */
 void IMAPClient::connect() {
+    connectedAt = std::chrono::steady_clock::now();
     strategy->connect();
     lastCommand = CONNECT;
+    Stats::Timer timer(Stats::Phase::GREETING);
     readWholeResponse();
 }
 
@@ -66,422 +80,840 @@ void IMAPClient::generateNextTag(){
 
 /**
  * @brief Sends the LOGIN command to authenticate with the IMAP server.
+ *
+ * The capabilities sent with the LOGIN response are used when present, otherwise they are
+ * asked for with CAPABILITY if compression or the literals of the search criteria need them.
+ * Compression is enabled right after LOGIN if the server supports it (see compress()).
  */
 void IMAPClient::login(){
+    Stats::Timer timer(Stats::Phase::AUTH);
     auto loginCommand = IMAPCommandFactory::createLoginCommand(config.username, config.server, config.password);
     sendCommand(*loginCommand);
-    readWholeResponse();
+    std::string capabilities = readWholeResponse();
+
+    bool needed = config.compress || SearchCriteria::fromConfig(config).hasLiterals();
+    if (needed && !ResponseParser::listsCapabilities(capabilities)) {
+        auto capabilityCommand = IMAPCommandFactory::createCapabilityCommand();
+        sendCommand(*capabilityCommand);
+        capabilities = readWholeResponse();
+    }
+    literalPlus = ResponseParser::hasCapability(capabilities, "LITERAL+");
+
+    if (config.compress) {
+        compress(capabilities);
+    }
+}
+
+/**
+ * @brief Enables COMPRESS=DEFLATE (RFC 4978) if the server announces it.
+ *
+ * Once the server accepts COMPRESS DEFLATE, the connection strategy deflates everything
+ * sent and inflates everything received.
+ * @param capabilities The response to LOGIN or CAPABILITY listing the capabilities.
+ */
+void IMAPClient::compress(const std::string &capabilities) {
+    if (!ResponseParser::hasCapability(capabilities, "COMPRESS=DEFLATE")) {
+        return;
+    }
+
+    auto compressCommand = IMAPCommandFactory::createCompressCommand();
+    sendCommand(*compressCommand);
+    try {
+        readWholeResponse();
+    } catch (const IMAPNoResponseException&) {
+        return;     // e.g. compression already active at the TLS layer
+    }
+    strategy->startCompression();
 }
 
 /**
  * @brief Sends the SELECT command to choose a mailbox (e.g., INBOX) for further actions.
  */
 void IMAPClient::select(){
+    Stats::Timer timer(Stats::Phase::MAILBOX_SELECT);
     auto selectCommand = IMAPCommandFactory::createSelectCommand(config.mailbox);
     sendCommand(*selectCommand);
-    readWholeResponse();
+    std::string selectResponse = readWholeResponse();
+
+    uidValidity = 0;
+    uidNext = 0;
+    ResponseParser::responseCode(selectResponse, "UIDVALIDITY", uidValidity);
+    ResponseParser::responseCode(selectResponse, "UIDNEXT", uidNext);
 }
 
 /**
- * @brief Executes the SEARCH command based on the user's options to retrieve message IDs.
+ * @brief Executes the UID SEARCH command based on the user's options to retrieve message UIDs.
  *
- * This command searches for new or all messages and stores their IDs in a list.
+ * Only messages newer than the last complete sync of the output directory are searched for,
+ * and messages already saved by an earlier run are left out. The sync state and, for the
+ * mbox, maildir and pack formats, the message sink of the output directory are opened here. If UIDNEXT shows that no message
+ * arrived since the last sync, the command is not sent at all. The search criteria given on the command
+ * line are evaluated by the server (see SearchCriteria), and with a size, date or sender filter the found
+ * messages are narrowed down by their metadata before any body is fetched.
  * @return True if messages matching the criteria were found; otherwise, false.
  * @throws std::runtime_error if the search command fails.
  */
 bool IMAPClient::search(){
-    auto searchCommand = IMAPCommandFactory::createSearchCommand(config.onlyNew);
+    metadata.clear();       // sizes of another mailbox must not decide how its UIDs are fetched
+    state = SyncState::open(config.outDir, config.onlyHeaders, config.format, uidValidity);
+
+    if (config.format != "files") {
+        setSink(MessageSink::create(config.format, config.outDir));
+    }
+
+    if (!state->beginSync(uidNext)) {
+        return false;
+    }
+
+    Stats::Timer timer(Stats::Phase::MAILBOX_SEARCH);
+    SearchCriteria criteria = SearchCriteria::forSync(config, state->getFirstUid());
+    auto searchCommand = IMAPCommandFactory::createSearchCommand(criteria);
     sendCommand(*searchCommand);
     std::string searchResponse = readWholeResponse();
+    timer.stop();
+
+    // tagged OK without any untagged SEARCH data means nothing matched
+    std::vector<uint32_t> found;
+    ResponseParser::searchIds(searchResponse, found);
+    ids = state->takeFound(found, !SearchCriteria::fromConfig(config).empty());
+    if (!ids.empty() && MessageTable::Filter(config).active()) {
+        filterByMetadata();
+    }
+    wanted = MessageSet(ids);
+    return !ids.empty();
+}
 
-    std::regex searchRegex(R"(\* SEARCH\s((?:\d+\s*)+))");
-    std::smatch match;
-
-    if (std::regex_search(searchResponse, match, searchRegex) && match.size() > 1) {
-        std::istringstream iss(match[1].str());
-        int id;
+/**
+ * @brief Fetches the size, arrival time and envelope of the found messages and keeps only those passing the filter.
+ *
+ * This is the first phase of a filtered fetch: the metadata costs a few hundred bytes per message,
+ * so messages failing the filter are never downloaded. The sync does not advance past the first
+ * rejected message, so a later run with other criteria still considers it.
+ */
+void IMAPClient::filterByMetadata() {
+    Stats::Timer timer(Stats::Phase::METADATA_FETCH);
+    metadata.clear();
+    for (const std::string& sequenceSet : SequenceSet::build(ids)) {
+        auto metadataCommand = IMAPCommandFactory::createFetchMetadataCommand(sequenceSet);
+        sendCommand(*metadataCommand);
+        metadata.parse(readWholeResponse());
+    }
+    timer.stop();
 
-        while (iss >> id) {
-            ids.push_back(id);
-        }
-        return true;
+    std::vector<uint32_t> rejected;
+    size_t found = ids.size();
+    ids = metadata.select(ids, MessageTable::Filter(config), rejected);
+    if (!rejected.empty()) {
+        state->holdBack(*std::min_element(rejected.begin(), rejected.end()));
+    }
 
-    } else if (findOk(searchResponse) != std::string::npos){
-        return false;
-    } else {
-        throw std::runtime_error("SEARCH command response does not match with expected");
+    if (config.verbose) {
+        std::cerr << "Filter (" + config.mailbox + "): " + std::to_string(ids.size()) + " of " +
+                     std::to_string(found) + " messages pass, " + std::to_string(rejected.size()) + " skipped\n";
     }
 }
 
 /**
  * @brief Fetches messages from the server and saves them to the output directory.
  *
- * If the `onlyNew` option is enabled, it fetches messages one by one; otherwise,
- * it fetches all messages in bulk. Each message is then saved individually.
+ * The UIDs found by SEARCH are compressed into sequence sets, so the server
+ * transfers only these messages in a few UID FETCH commands. Message bodies are streamed
+ * into their files while they are being received, so the response is never held in
+ * memory as a whole. With `--chunk-size`, messages larger than the chunk size are
+ * downloaded one by one in resumable chunks afterwards (see fetchChunked()).
  */
 void IMAPClient::fetch() {
     std::filesystem::create_directories(config.outDir);
 
-    if (config.onlyNew) {
-        // Fetch messages one by one for new messages only
-        for (int id : ids) {
-            std::string response = fetchById(id);
-            processMessage(response, id, 0);
+    std::vector<uint32_t> large;
+    std::vector<uint32_t> whole = config.chunkSize > 0 && !config.onlyHeaders ? splitBySize(large) : ids;
+
+    Stats::Timer timer(Stats::Phase::MESSAGE_FETCH);
+    fetchPipelined(SequenceSet::build(whole));
+    for (uint32_t uid : large) {
+        fetchChunked(uid);
+    }
+    writer.flush();
+}
+
+/**
+ * @brief Splits the found messages into those fetched whole and those larger than the chunk size.
+ *
+ * The sizes missing from the metadata of a filtered fetch are fetched with `UID FETCH (UID RFC822.SIZE)`.
+ * @param large Receives the UIDs of the messages to download in chunks.
+ * @return The UIDs of the messages to fetch whole, including those without a known size.
+ */
+std::vector<uint32_t> IMAPClient::splitBySize(std::vector<uint32_t>& large) {
+    std::vector<uint32_t> unknown;
+    for (uint32_t uid : ids) {
+        if (metadata.find(uid) == nullptr) {
+            unknown.push_back(uid);
         }
-    } else {
-        // Fetch all messages in bulk
-        auto fetchCommand = IMAPCommandFactory::createFetchCommand(config.onlyHeaders);
-        sendCommand(*fetchCommand);
+    }
+
+    Stats::Timer timer(Stats::Phase::METADATA_FETCH);
+    for (const std::string& sequenceSet : SequenceSet::build(unknown)) {
+        auto sizeCommand = IMAPCommandFactory::createFetchMetadataCommand(sequenceSet, false);
+        sendCommand(*sizeCommand);
+        metadata.parse(readWholeResponse());
+    }
+    timer.stop();
+
+    std::vector<uint32_t> whole;
+    for (uint32_t uid : ids) {
+        const MessageInfo* info = metadata.find(uid);
+        (info != nullptr && info->size > config.chunkSize ? large : whole).push_back(uid);
+    }
+    return whole;
+}
+
+/**
+ * @brief Downloads a large message in chunks into a partial file and stores it once complete.
+ *
+ * The partial file `.imapcl-partial-<uidvalidity>-<uid>` in the output directory holds the bytes
+ * received so far. If the connection drops, the client reconnects and continues from the end of the
+ * file; the file also survives an aborted run, so the next run resumes it. The download fails after
+ * `maxChunkRetries` reconnects in a row that received nothing.
+ *
+ * @param uid The UID of the message.
+ * @throws IMAPNoResponseException if a NO response is received.
+ * @throws IMAPBadResponseException if a BAD response is received.
+ * @throws std::system_error if the partial file cannot be written.
+ * @throws std::runtime_error if the connection keeps failing or the mailbox changed its UIDVALIDITY.
+ */
+void IMAPClient::fetchChunked(uint32_t uid) {
+    std::string path = config.outDir + "/.imapcl-partial-" + std::to_string(uidValidity) + "-" + std::to_string(uid);
+
+    uint32_t validity = uidValidity;
+    std::error_code error;
+    for (int retries = 0;;) {
+        uintmax_t before = std::filesystem::file_size(path, error);
+        try {
+            if (retries > 0) {
+                reconnect();
+            }
+            if (uidValidity == validity && !fetchChunks(uid, path)) {
+                std::filesystem::remove(path);    // expunged in the meantime
+                return;
+            }
+            break;
+        } catch (const IMAPNoResponseException&) {
+            throw;
+        } catch (const IMAPBadResponseException&) {
+            throw;
+        } catch (const std::system_error&) {
+            throw;
+        } catch (const std::runtime_error& e) {
+            uintmax_t after = std::filesystem::file_size(path, error);
+            retries = !error && after > before ? 1 : retries + 1;
+            if (retries > maxChunkRetries) {
+                throw;
+            }
+            std::cerr << "Download of message " + std::to_string(uid) + " interrupted (" + e.what() +
+                         "), resuming\n";
+        }
+    }
 
-        std::string response = readWholeResponse();
-        size_t pos = 0;
+    // the UIDs refer to other messages now, the partial file is left to the next run to ignore
+    if (uidValidity != validity) {
+        throw std::runtime_error("UIDVALIDITY of " + config.mailbox + " changed during the download");
+    }
+    writer.adopt(uid, path);
+}
 
-        // Parse and save messages
-        while ((pos = response.find("* ", pos)) != std::string::npos) {
-            size_t idStart = pos + 2;
-            size_t idEnd = response.find(' ', idStart);
-            if (idEnd == std::string::npos) break;
+/**
+ * @brief Appends `BODY[]<offset.length>` chunks of a message to its partial file until the end of the message.
+ *
+ * Every chunk is streamed from the connection into the file (see ConnectionStrategy::readToFile()),
+ * so no more than a receive buffer of the message is held in memory. The download ends with the first
+ * chunk shorter than the chunk size, so a server reporting an inexact RFC822.SIZE does not matter.
+ *
+ * @param uid The UID of the message.
+ * @param path The partial file, created if missing.
+ * @return False if the server returned no FETCH data for the message.
+ * @throws std::system_error if the partial file cannot be opened or written.
+ */
+bool IMAPClient::fetchChunks(uint32_t uid, const std::string& path) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "Failed to open " + path);
+    }
 
-            int messageId = std::stoi(response.substr(idStart, idEnd - idStart));
+    // the data is written at the file position, which starts at the bytes received by earlier attempts
+    off_t offset = lseek(fd, 0, SEEK_END);
+    if (config.verbose && offset > 0) {
+        std::cerr << "Resuming message " + std::to_string(uid) + " at byte " + std::to_string(offset) + "\n";
+    }
 
-            // Check if found ID is in the list of IDs
-            if (std::find(ids.begin(), ids.end(), messageId) == ids.end()) {
-                pos = idEnd;
-                continue;
+    try {
+        while (true) {
+            bool found = false;
+            bool written = true;
+            auto partialCommand = IMAPCommandFactory::createFetchPartialCommand(uid, offset, config.chunkSize);
+            sendCommand(*partialCommand);
+            std::string response = readWholeResponse([this, uid, fd, &found, &written](const std::string& line, size_t size) {
+                uint32_t messageId;
+                if (ResponseParser::fetchUid(line, messageId) && messageId != uid) {
+                    readLiteral(size, nullptr);
+                    return;
+                }
+                found = true;
+                written = strategy->readToFile(fd, size) && written;
+            });
+
+            if (!written) {
+                throw std::system_error(std::make_error_code(std::errc::io_error), "Failed to write " + path);
             }
 
-            pos = processMessage(response, messageId, pos);
+            // an empty range may come as "" or NIL instead of a literal
+            for (size_t start = 0; !found && start < response.size();) {
+                size_t end = std::min(response.find("\r\n", start), response.size());
+                std::string_view line = std::string_view(response).substr(start, end - start);
+                uint32_t sequenceNumber, messageId;
+                found = ResponseParser::fetchId(line, sequenceNumber) && ResponseParser::fetchUid(line, messageId) &&
+                        messageId == uid;
+                start = end + 2;
+            }
+            if (!found) {
+                ::close(fd);
+                return false;
+            }
+
+            off_t end = lseek(fd, 0, SEEK_CUR);
+            size_t received = static_cast<size_t>(end - offset);
+            offset = end;
+            if (received < config.chunkSize) {
+                break;
+            }
         }
+    } catch (...) {
+        ::close(fd);
+        throw;
     }
 
-    if(messageSaved > 0)
-        std::cout << "Saved " << messageSaved << " messages from the " << config.mailbox << "." << std::endl;
+    if (::close(fd) != 0) {
+        throw std::system_error(errno, std::generic_category(), "Failed to write " + path);
+    }
+    return true;
+}
+
+/**
+ * @brief Opens a new connection after the old one failed and selects the mailbox again.
+ */
+void IMAPClient::reconnect() {
+    strategy->disconnect();
+    connect();
+    login();
+    select();
+}
+
+/**
+ * @brief Prints how many messages were saved from the mailbox.
+ *
+ * @param count The amount of saved messages.
+ * @param mailbox The mailbox the messages were saved from.
+ */
+void IMAPClient::reportSaved(int count, const std::string &mailbox) {
+    // one write per line keeps the output readable when several clients run in parallel
+    if(count > 0)
+        std::cout << "Saved " + std::to_string(count) + " messages from the " + mailbox + ".\n" << std::flush;
     else
-        std::cout << "No message saved from the " << config.mailbox << "." << std::endl;
+        std::cout << "No message saved from the " + mailbox + ".\n" << std::flush;
 }
 
 /**
- * @brief Processes a single message response from the server and saves the message.
+ * @brief Streams one message literal from the connection into its output file.
  *
- * This function extracts the message body from the response based on the provided start position.
- * It saves the message to a file with a formatted name if the message is valid.
+ * The message is identified by the UID item of the untagged FETCH response, which is
+ * usually sent before the literal. If the server sends it after the literal, the writer
+ * is told the UID once the rest of the response line is available.
+ * Literals of messages not returned by SEARCH are read and dropped, saved messages
+ * are added to the sync state once they are written (see messageStored()). Only the header
+ * block is peeked to name the file, the rest of the body is written from the receive buffer
+ * (or spliced) without copies, unless a writer pool collects the message for writing.
  *
- * @param response The server response containing the message data.
- * @param messageId The unique ID of the message being processed.
- * @param startPos The position in the response to start searching for the message body.
- * @return The position in the response after processing the current message.
+ * @param line The response line announcing the literal.
+ * @param size The size of the literal in bytes.
  */
-size_t IMAPClient::processMessage(const std::string &response, int messageId, size_t startPos) {
-    // locate the start of the message body using '{' character
-    size_t bodyStart = response.find('{', startPos);
-    size_t bodyEnd = response.find('}', bodyStart);
+void IMAPClient::saveLiteral(const std::string &line, size_t size) {
+    uint32_t sequenceNumber, messageId = 0;
+    if (!ResponseParser::fetchId(line, sequenceNumber)) {
+        readLiteral(size, nullptr);
+        return;
+    }
 
-    // if either '{' or '}' is not found, return the original start position to skip invalid responses
-    if (bodyStart == std::string::npos || bodyEnd == std::string::npos) {
-        return startPos;
+    // Check if found ID is in the list of IDs
+    bool uidKnown = ResponseParser::fetchUid(line, messageId);
+    if (uidKnown && !wanted.contains(messageId)) {
+        readLiteral(size, nullptr);
+        return;
     }
 
-    // extract the size of the message body enclosed in curly braces, e.g., {12345}
-    int messageSize = std::stoi(response.substr(bodyStart + 1, bodyEnd - bodyStart - 1));
-    size_t messageStart = bodyEnd + 3; // Skip "}\r\n"
+    writer.begin(messageId);
 
-    // extract the message content from the response based on the size.
-    std::string messageBody = response.substr(messageStart, messageSize);
+    // only the headers are looked at, the body goes straight from the connection into the file
+    while (size > 0 && writer.needsHeaders()) {
+        std::string_view data = strategy->readSome(size);
+        writer.write(data.data(), data.size());
+        size -= data.size();
+    }
+    if (writer.outputFd() >= 0) {
+        if (!strategy->readToFile(writer.outputFd(), size)) {
+            writer.writeFailed();
+        }
+    } else {
+        readLiteral(size, [this](const char* data, size_t length) { writer.write(data, length); });
+    }
+
+    if (!uidKnown) {
+        // the rest of the line is consumed by readUntil(), only look at it here
+        if (!ResponseParser::fetchUid(strategy->peekLine(), messageId) || !wanted.contains(messageId)) {
+            writer.discard();
+            return;
+        }
+        writer.setMessageId(messageId);
+    }
+
+    writer.finish();
+}
 
-    if (saveMessage(messageId, messageBody)) {
+/**
+ * @brief Records a message that is on disk; called by the writer, possibly from a writer pool thread.
+ *
+ * @param messageId The UID of the message.
+ * @param filename The file name of the message.
+ * @param saved True if the file was written now, false if it existed already.
+ */
+void IMAPClient::messageStored(uint32_t messageId, const std::string &filename, bool saved) {
+    if (state) {
+        state->add(messageId, filename);
+    }
+
+    if (saved) {
+        Stats::getInstance().add(Stats::Counter::MESSAGES_SAVED);
         messageSaved++;
+        if (progress) {
+            ++*progress;
+        }
     }
+}
 
-    return messageStart + messageSize + 2; // Move to next position
+/**
+ * @brief Sends one FETCH command per sequence set, keeping up to `pipelineWindow`
+ *        commands in flight.
+ *
+ * A new command is sent whenever one of the outstanding commands completes, so the round
+ * trip time is paid once per window instead of once per command. Untagged responses carry
+ * the message number, completions are matched to the outstanding commands by their tags.
+ *
+ * @param sequenceSets The sequence sets to fetch.
+ * @throws IMAPNoResponseException if a NO response is received for any of the commands.
+ * @throws IMAPBadResponseException if a BAD response is received for any of the commands.
+ */
+void IMAPClient::fetchPipelined(const std::vector<std::string>& sequenceSets) {
+    std::deque<std::string> inFlight;   // tags of the outstanding commands
+    size_t next = 0;
+    auto onLiteral = [this](const std::string& line, size_t size) { saveLiteral(line, size); };
+
+    auto completion = [&inFlight](std::string_view line) {
+        for (auto tag = inFlight.begin(); tag != inFlight.end(); ++tag) {
+            IMAPResponseType responseType = ResponseParser::taggedStatus(line, *tag);
+            if (responseType != IMAPResponseType::UNKNOWN) {
+                inFlight.erase(tag);
+                return responseType;
+            }
+        }
+        return IMAPResponseType::UNKNOWN;
+    };
+
+    while (next < sequenceSets.size() || !inFlight.empty()) {
+        while (next < sequenceSets.size() && inFlight.size() < static_cast<size_t>(config.pipelineWindow)) {
+            inFlight.push_back(sendFetch(sequenceSets[next++]));
+        }
+
+        readUntil(completion, onLiteral);
+    }
 }
 
 /**
- * @brief Fetches a specific message by its ID using the FETCH command.
+ * @brief Sends the FETCH command for the messages of a sequence set.
  *
- * @param messageNumber The ID of the message to fetch.
- * @return The complete server response containing the message data.
+ * @param sequenceSet The messages to fetch, e.g. `3:17,20`.
+ * @return The tag of the sent command.
  */
-std::string IMAPClient::fetchById(int messageNumber) {
-    auto fetchCommand = IMAPCommandFactory::createFetchByIdCommand(messageNumber, config.onlyHeaders);
+std::string IMAPClient::sendFetch(const std::string& sequenceSet) {
+    auto fetchCommand = IMAPCommandFactory::createFetchCommand(sequenceSet, config.onlyHeaders);
     sendCommand(*fetchCommand);
-    return readWholeResponse();
+    return currTag;
 }
 
 /**
- * @brief Saves a message to a file in the specified output directory.
+ * @brief Builds the path of the file a message is saved to.
  *
  * The file is named using the format `msg_<messageId>_<subject>`.
  * The subject is extracted from the message headers and sanitized to remove invalid characters.
  *
+ * @param outDir The output directory.
  * @param messageId The unique ID of the message.
- * @param messageBody The full content of the message, including headers and body.
- * @return True if the message was saved successfully; otherwise, false.
+ * @param headers The header block of the message.
+ * @return The full path of the output file.
  */
-bool IMAPClient::saveMessage(int messageId, const std::string& messageBody) const {
-    // locate the end of the headers section, marked by a blank line
-    size_t headersEnd = messageBody.find("\r\n\r\n");
-    std::string headers = messageBody.substr(0, headersEnd);
-
+std::string IMAPClient::messageFilename(const std::string &outDir, uint32_t messageId, const std::string &headers) {
     // extract and decode the subject from the header
     std::string subject = extractAndDecodeSubject(headers);
     subject = validateSubject(subject);
     std::replace(subject.begin(), subject.end(), ' ', '_');
 
-    std::string filename = config.outDir + "/msg_" + std::to_string(messageId) + "_" + subject;
+    // unfolded subjects can be long, the name has to stay below NAME_MAX (255 bytes)
+    constexpr size_t maxSubjectLength = 200;
+    if (subject.size() > maxSubjectLength) {
+        size_t cut = maxSubjectLength;
+        while (cut > 0 && (static_cast<unsigned char>(subject[cut]) & 0xC0) == 0x80) {
+            --cut;      // not inside a UTF-8 sequence
+        }
+        subject.resize(cut);
+    }
 
-    if (std::filesystem::exists(filename))
-        return false;
+    return outDir + "/msg_" + std::to_string(messageId) + "_" + subject;
+}
 
-    std::ofstream outFile(filename);
-    if (outFile) {
-        outFile << messageBody;
-        outFile.close();
-        return true;
-    } else {
-        std::cerr << "Failed to save message " << messageId << " to " << filename << std::endl;
-        return false;
+/**
+ * @brief Records the completed sync in the state file of the output directory.
+ *
+ * The message sink is closed first, so the state never refers to messages that are not
+ * on disk. Without `onlyNew` every message up to the newest one seen by SEARCH has been
+ * saved, so the next run only needs to look at newer UIDs.
+ * @throws std::runtime_error if the sink fails to write the messages.
+ */
+void IMAPClient::commitSync() {
+    if (sink) {
+        sink->close();
     }
+    if (!state) {
+        return;
+    }
+
+    std::filesystem::create_directories(config.outDir);
+    state->commit(!config.onlyNew);
 }
 
 /**
  * @brief Sends the LOGOUT command and disconnects from the server.
  */
 void IMAPClient::logout() {
+    Stats::Timer timer(Stats::Phase::QUIT);
     auto logoutCommand = IMAPCommandFactory::createLogoutCommand();
     sendCommand(*logoutCommand);
     readWholeResponse();
+    timer.stop();
 
+    if (config.verbose) {
+        reportTraffic();
+    }
     strategy->disconnect();
 }
 
 /**
- * @brief Sends an IMAP command using the current connection strategy.
- * @param command The IMAP command to send.
+ * @brief Prints the bytes moved over the connection, before and after compression, and the connection time.
  */
-void IMAPClient::sendCommand(const IMAPCommand& command) {
-    generateNextTag();
-    lastCommand = command.getType();
-    std::string cmdStr = currTag + " " + command.generate();
-
-    strategy->sendCommand(cmdStr);
+void IMAPClient::reportTraffic() const {
+    const ConnectionStrategy::Traffic& traffic = strategy->getTraffic();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - connectedAt;
+
+    auto ratio = [](uint64_t wire, uint64_t data) {
+        char percent[16];
+        std::snprintf(percent, sizeof(percent), "%.1f", data == 0 ? 100.0 : 100.0 * wire / data);
+        return std::string(percent);
+    };
+    std::cerr << "Connection to " + config.server + " (" + config.mailbox + "): " +
+                 (strategy->isCompressed() ? "compressed" : "uncompressed") + ", received " +
+                 std::to_string(traffic.wireReceived) + " bytes on the wire for " + std::to_string(traffic.received) +
+                 " bytes (" + ratio(traffic.wireReceived, traffic.received) + "%), sent " +
+                 std::to_string(traffic.wireSent) + " bytes for " + std::to_string(traffic.sent) + " bytes, " +
+                 std::to_string(elapsed.count()) + " s\n";
 }
 
 /**
- * @brief Reads a single response line from the server.
- * @return The response line as a string.
+ * @brief Sends the LIST command and returns the names of all selectable mailboxes.
+ * @return Mailbox names in the order returned by the server.
  */
-std::string IMAPClient::readResponse() const {
-    return strategy->readResponse();
+std::vector<std::string> IMAPClient::list() {
+    std::vector<std::string> mailboxes;
+    std::string name;
+    bool selectable;
+
+    auto listCommand = IMAPCommandFactory::createListCommand();
+    sendCommand(*listCommand);
+
+    // mailbox names sent as literals
+    std::string response = readWholeResponse([&](const std::string& line, size_t size) {
+        std::string literal;
+        readLiteral(size, [&literal](const char* data, size_t length) { literal.append(data, length); });
+        if (ResponseParser::listEntry(line, name, selectable) && selectable) {
+            mailboxes.push_back(literal);
+        }
+    });
+
+    size_t lineStart = 0, lineEnd;
+    while ((lineEnd = response.find("\r\n", lineStart)) != std::string::npos) {
+        if (ResponseParser::listEntry(std::string_view(response).substr(lineStart, lineEnd - lineStart), name, selectable) &&
+            selectable && !name.empty()) {
+            mailboxes.push_back(name);
+        }
+        lineStart = lineEnd + 2;
+    }
+    return mailboxes;
 }
 
 /**
- * @brief Reads the complete response from the server until an OK, NO, or BAD response is found.
- *
- * This method collects all lines from the server until a final status response is received.
- * It handles responses that span multiple lines.
+ * @brief Switches the client to another mailbox before the next select().
  *
- * @return The full response as a string.
- * @throws IMAPNoResponseException if a NO response is received.
- * @throws IMAPBadResponseException if a BAD response is received.
+ * Lets one authenticated connection sync several mailboxes one after another.
+ * @param mailbox The mailbox to select next.
+ * @param outDir The directory the messages of the mailbox are saved to.
  */
-std::string IMAPClient::readWholeResponse() {
-    bool response_found = false;
-    std::string lastMessage;
-    std::string finalMessage;
-    IMAPResponseType responseType;
+void IMAPClient::setMailbox(const std::string &mailbox, const std::string &outDir) {
+    config.mailbox = mailbox;
+    config.outDir = outDir;
+    ids.clear();
+    wanted = MessageSet();
+    metadata.clear();
+    messageSaved = 0;
+    state.reset();
+    setSink(nullptr);
+}
 
-    while (!response_found) {
-        lastMessage = readResponse();
-        responseType = findResponseType(lastMessage);
+/**
+ * @brief Returns the message numbers found by the last SEARCH.
+ */
+const std::vector<uint32_t>& IMAPClient::getIds() const {
+    return ids;
+}
 
-        if (responseType == IMAPResponseType::OK || responseType == IMAPResponseType::NO || responseType == IMAPResponseType::BAD) {
-            response_found = true;
-        }
+/**
+ * @brief Replaces the messages fetched by the next fetch(), e.g. with one shard of another client's SEARCH.
+ */
+void IMAPClient::setIds(std::vector<uint32_t> messageIds) {
+    ids = std::move(messageIds);
+    wanted = MessageSet(ids);
+}
 
-        finalMessage.append(lastMessage);
-    }
+/**
+ * @brief Returns the metadata fetched by search(), empty unless a filter is set.
+ */
+const MessageTable& IMAPClient::getMetadata() const {
+    return metadata;
+}
 
-    if (responseType == IMAPResponseType::NO) {
-        throw IMAPNoResponseException(finalMessage);
-    } else if (responseType == IMAPResponseType::BAD) {
-        throw IMAPBadResponseException(finalMessage);
-    }
+/**
+ * @brief Returns the sync state loaded by search().
+ */
+std::shared_ptr<SyncState> IMAPClient::getSyncState() const {
+    return state;
+}
 
-    return finalMessage;
+/**
+ * @brief Shares the sync state of another client fetching a part of the same mailbox.
+ */
+void IMAPClient::setSyncState(std::shared_ptr<SyncState> syncState) {
+    state = std::move(syncState);
 }
 
 /**
- * @brief Finds the position of an "OK" response based on the last command sent.
+ * @brief Returns the message sink opened by search(), nullptr when writing one file per message.
  */
-size_t IMAPClient::findOk(const std::string& response) const {
-    size_t idx;
+std::shared_ptr<MessageSink> IMAPClient::getSink() const {
+    return sink;
+}
 
-    switch (lastCommand) {
-        case CONNECT:
-        case LOGIN:
-            idx = response.find("OK");
-            break;
-        case SELECT:
-            idx = response.find("OK [READ-WRITE] Select completed");
-            break;
-        case SEARCH:
-            idx = response.find("OK Search completed");
-            break;
-        case FETCH:
-            idx = response.find("OK Fetch completed");
-            break;
-        case LOGOUT:
-            idx = response.find("OK Logout completed");
-            break;
-        default:
-            break;
-    }
-    return idx;
+/**
+ * @brief Shares the message sink of another client fetching a part of the same mailbox.
+ */
+void IMAPClient::setSink(std::shared_ptr<MessageSink> messageSink) {
+    sink = messageSink;
+    writer.setSink(std::move(messageSink));
 }
 
 /**
- * @brief Finds the position of a "NO" response based on the last command sent.
+ * @brief Returns the amount of messages saved by this client since the mailbox was selected.
  */
-size_t IMAPClient::findNo(const std::string& response) const {
-    size_t idx;
+int IMAPClient::getSavedCount() const {
+    return messageSaved;
+}
 
-    switch (lastCommand) {
-        case LOGIN:
-            idx = response.find("NO [AUTHENTICATIONFAILED] Authentication failed");
-            break;
-        case SELECT:
-            idx = response.find("NO Mailbox doesn't exist");
-            break;
-        default:
-            return std::string::npos;
-    }
-    return idx;
+/**
+ * @brief Lets the threads of the pool write the fetched messages while this client keeps receiving.
+ * @param pool The pool, possibly shared with other clients, or nullptr to write on this thread.
+ */
+void IMAPClient::setWriterPool(std::shared_ptr<WriterPool> pool) {
+    writerPool = pool;
+    writer.setPool(std::move(pool));
 }
 
 /**
- * @brief Finds the position of a "BAD" response based on the last command sent.
+ * @brief Returns the writer pool set by setWriterPool(), or nullptr.
  */
-size_t IMAPClient::findBad(const std::string& response) const {
-    size_t idx;
+std::shared_ptr<WriterPool> IMAPClient::getWriterPool() const {
+    return writerPool;
+}
 
-    switch (lastCommand) {
-        case SEARCH:
-            idx = response.find("BAD Error in IMAP command SEARCH");
-            break;
-        case FETCH:
-            idx = response.find("BAD Error in IMAP command FETCH");
-            break;
-        default:
-            return std::string::npos;
-    }
-    return idx;
+/**
+ * @brief Sets a counter incremented for every saved message, shared by clients working in parallel.
+ */
+void IMAPClient::setProgressCounter(std::atomic<int>* counter) {
+    progress = counter;
 }
 
 /**
- * @brief Determines the response type (OK, NO, BAD) based on the server's response.
+ * @brief Sends an IMAP command using the current connection strategy.
+ * @param command The IMAP command to send.
  */
-IMAPResponseType IMAPClient::findResponseType(const std::string& response) const {
-    if (findOk(response) != std::string::npos) {
-        return IMAPResponseType::OK;
-    } else if (findNo(response) != std::string::npos) {
-        return IMAPResponseType::NO;
-    } else if (findBad(response) != std::string::npos) {
-        return IMAPResponseType::BAD;
+void IMAPClient::sendCommand(const IMAPCommand& command) {
+    generateNextTag();
+    lastCommand = command.getType();
+    std::string cmdStr = currTag + " " + command.generate();
+
+    std::vector<std::string> parts = IMAPCommand::splitAtLiterals(cmdStr);
+    if (parts.size() == 1) {
+        strategy->sendCommand(cmdStr);
+        return;
+    }
+
+    // LITERAL+ (RFC 7888): "{n+}" literals are sent without waiting for the server
+    if (literalPlus) {
+        cmdStr.clear();
+        for (size_t i = 0; i < parts.size(); ++i) {
+            if (i + 1 < parts.size()) {
+                parts[i].insert(parts[i].size() - 3, "+");
+            }
+            cmdStr += parts[i];
+        }
+        strategy->sendCommand(cmdStr);
+        return;
+    }
+
+    for (size_t i = 0; i < parts.size(); ++i) {
+        strategy->sendCommand(parts[i]);
+        if (i + 1 < parts.size()) {
+            // a tagged NO or BAD instead of the continuation request rejects the command
+            readUntil([this](std::string_view line) {
+                return line.substr(0, 1) == "+" ? IMAPResponseType::OK : ResponseParser::taggedStatus(line, currTag);
+            }, nullptr);
+        }
     }
-    return IMAPResponseType::UNKNOWN;
 }
 
 /**
- * @brief Decodes a base64-encoded string.
+ * @brief Reads a literal of the given size and passes it to the sink chunk by chunk.
+ *
+ * The data is passed straight from the receive buffer of the connection, so at most one
+ * buffer of the literal is held in memory regardless of the literal size.
  *
- * This function uses OpenSSL to decode a base64 string and return the decoded data.
- * @param encoded The base64 encoded string.
- * @return The decoded string.
+ * @param size The size of the literal in bytes.
+ * @param sink Receives the literal data; the data is dropped if the sink is empty.
  */
-std::string IMAPClient::decodeBase64(const std::string &encoded) {
-    BIO *bio, *b64;
-    char buffer[1024];
-    std::string decoded;
-
-    // set up a memory BIO to read the base64 data
-    bio = BIO_new_mem_buf(encoded.data(), encoded.size());
-    b64 = BIO_new(BIO_f_base64());
-    BIO_set_flags(b64, BIO_FLAGS_BASE64_NO_NL); // disable newlines
-    bio = BIO_push(b64, bio);
-
-    // read decoded data into buffer
-    int decodedLength;
-    while ((decodedLength = BIO_read(bio, buffer, sizeof(buffer))) > 0) {
-        decoded.append(buffer, decodedLength);
+void IMAPClient::readLiteral(size_t size, const std::function<void(const char*, size_t)>& sink) {
+    while (size > 0) {
+        std::string_view data = strategy->readSome(size);
+        if (sink) {
+            sink(data.data(), data.size());
+        }
+        size -= data.size();
     }
-    BIO_free_all(bio);
-    return decoded;
 }
 
 /**
- * @brief Decodes a quoted-printable encoded string.
+ * @brief Reads the complete response from the server until the tagged OK, NO, or BAD response is found.
+ *
+ * The response is parsed line by line. Literals (`{N}` at the end of a line) are either passed
+ * to the handler, which streams them elsewhere, or kept in the returned text when no handler is given.
+ *
+ * @param onLiteral Optional handler consuming the literals of the response.
+ * @return The response text without the literals consumed by the handler.
+ * @throws IMAPNoResponseException if a NO response is received.
+ * @throws IMAPBadResponseException if a BAD response is received.
+ */
+std::string IMAPClient::readWholeResponse(const LiteralHandler& onLiteral) {
+    return readUntil([this](std::string_view line) {
+        if (lastCommand == CONNECT) {
+            return ResponseParser::greetingStatus(line);
+        }
+        return ResponseParser::taggedStatus(line, currTag);
+    }, onLiteral);
+}
+
+/**
+ * @brief Reads response lines until the completion callback recognizes a status line.
  *
- * @param encoded The quoted-printable encoded string.
- * @return The decoded string.
- */
-std::string IMAPClient::decodeQuotedPrintable(const std::string &encoded) {
-    std::ostringstream decoded;
-    for (size_t i = 0; i < encoded.size(); ++i) {
-        // check for "=XX" pattern representing hex-encoded characters
-        if (encoded[i] == '=' && i + 2 < encoded.size()) {
-            std::string hex = encoded.substr(i + 1, 2);
-            char decodedChar = static_cast<char>(std::stoi(hex, nullptr, 16));
-            decoded << decodedChar;
-            i += 2;
-        } else {
-            decoded << encoded[i];
+ * @param completion Returns the status of a completion line or UNKNOWN for any other line.
+ * @param onLiteral Optional handler consuming the literals of the response.
+ * @return The response text without the literals consumed by the handler.
+ * @throws IMAPNoResponseException if a NO response is received.
+ * @throws IMAPBadResponseException if a BAD response is received.
+ */
+std::string IMAPClient::readUntil(const std::function<IMAPResponseType(std::string_view)>& completion,
+                                  const LiteralHandler& onLiteral) {
+    std::string finalMessage;
+    std::string line;
+    IMAPResponseType responseType = IMAPResponseType::UNKNOWN;
+
+    while (responseType == IMAPResponseType::UNKNOWN) {
+        line.assign(strategy->readLine());
+        size_t literalSize;
+
+        while (ResponseParser::literalSize(line, literalSize)) {
+            if (onLiteral) {
+                onLiteral(line, literalSize);
+            } else {
+                finalMessage.append(line).append("\r\n");
+                readLiteral(literalSize, [&finalMessage](const char* data, size_t length) {
+                    finalMessage.append(data, length);
+                });
+            }
+            // the response line continues after the literal
+            line.assign(strategy->readLine());
         }
+
+        responseType = completion(line);
+        finalMessage.append(line).append("\r\n");
+    }
+
+    if (responseType == IMAPResponseType::NO) {
+        throw IMAPNoResponseException(finalMessage);
+    } else if (responseType == IMAPResponseType::BAD) {
+        throw IMAPBadResponseException(finalMessage);
     }
-    return decoded.str();
+
+    return finalMessage;
 }
 
 /**
  * @brief Extracts and decodes the subject line from email headers.
  *
- * Handles both base64 and quoted-printable encoded subjects.
+ * The Subject field is unfolded and its RFC 2047 encoded words are decoded to UTF-8.
  * @param headers The email headers.
  * @return The decoded subject or "no_subject" if not found.
  */
 std::string IMAPClient::extractAndDecodeSubject(const std::string &headers) {
-    std::regex encodedSubjectRegex(R"(Subject:\s=\?([A-Za-z0-9-]+)\?(B|Q)\?([A-Za-z0-9+/=]+)\?=)", std::regex::icase);
-    std::smatch match;
-
-    // check if the subject is encoded
-    if (std::regex_search(headers, match, encodedSubjectRegex)) {
-        std::string charset = match[1].str();
-        std::string encoding = match[2].str();
-        std::string encodedSubject = match[3].str();
-        if (encoding == "B" || encoding == "b") {
-            return decodeBase64(encodedSubject);
-        } else if (encoding == "Q" || encoding == "q") {
-            return decodeQuotedPrintable(encodedSubject);
-        }
-    }
-
-    // extract plain text subject if not encoded
-    std::regex plainSubjectRegex(R"(Subject:\s(.+))", std::regex::icase);
-    if (std::regex_search(headers, match, plainSubjectRegex)) {
-        return match[1].str();
+    std::string_view value;
+    if (!HeaderDecoder::findField(headers, "Subject", value)) {
+        return "no_subject";
     }
-    return "no_subject";
+    std::string subject = HeaderDecoder::decode(value);
+    return subject.empty() ? "no_subject" : subject;
 }
 
 /**
  * @brief Validates and sanitizes the subject to be used as a filename.
  *
- * Removes any characters that are not allowed in filenames.
+ * Removes any characters that are not allowed in filenames and control characters.
  */
 std::string IMAPClient::validateSubject(const std::string &subject) {
     std::string cleanSubject;
     for (char c : subject) {
         if (c != '/' && c != '\\' && c != ':' && c != '*' && c != '?' &&
             c != '"' && c != '<' && c != '>' && c != '|' && c != '&' &&
-            c != ';' && c != ',' && c != '.') {
+            c != ';' && c != ',' && c != '.' && static_cast<unsigned char>(c) >= 0x20 && c != 0x7F) {
             cleanSubject += c;
         }
     }
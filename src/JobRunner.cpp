@@ -0,0 +1,189 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#include "../include/JobRunner.h"
+#include "IMAPClient.h"
+#include "MailboxSync.h"
+#include "ShardedFetch.h"
+#include "SSLWrapper.h"
+
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <stdexcept>
+#include <algorithm>
+#include <cctype>
+#include <utility>
+
+JobRunner::JobRunner(ArgParser::Config config, std::shared_ptr<WriterPool> writerPool)
+        : config(std::move(config)), writerPool(std::move(writerPool)) {}
+
+int JobRunner::run() {
+    readJobs();
+
+    // the TLS context and trust stores of all jobs are built before the first connection
+    for (const ArgParser::Config& job : jobs) {
+        prepareTLS(job);
+    }
+
+    size_t workerCount = std::min(jobs.size(), static_cast<size_t>(config.jobWorkers));
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers.emplace_back(&JobRunner::worker, this);
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+
+    return failed > 0 ? 1 : 0;
+}
+
+int JobRunner::runJob(const ArgParser::Config& config, const std::shared_ptr<WriterPool>& writerPool) {
+    prepareTLS(config);
+
+    if (config.allMailboxes || config.mailboxes.size() > 1) {
+        return MailboxSync(config, writerPool).run();
+    }
+
+    IMAPClient client(config);
+
+    client.setWriterPool(writerPool);
+
+    client.connect();
+
+    client.login();
+
+    client.select();
+
+    if(client.search()){
+        if (config.connections > 1) {
+            IMAPClient::reportSaved(ShardedFetch(config).run(client), config.mailbox);
+        } else {
+            client.fetch();
+            IMAPClient::reportSaved(client.getSavedCount(), config.mailbox);
+        }
+    } else {
+        std::cout << "No message has been downloaded from the " + config.mailbox + " mailbox\n" << std::flush;
+    }
+
+    client.commitSync();
+
+    client.logout();
+    return 0;
+}
+
+/**
+ * @brief Builds the shared TLS context and loads the certificates of a TLS job, once per process.
+ */
+void JobRunner::prepareTLS(const ArgParser::Config& config) {
+    if (config.useSSL) {
+        SSLWrapper::getInstance().prepareContext(config.cert.empty() ? "" : config.certDir + "/" + config.cert,
+                                                 config.certDir);
+    }
+}
+
+std::vector<std::string> JobRunner::splitArguments(const std::string& line) {
+    std::vector<std::string> arguments;
+    std::string argument;
+    bool inArgument = false, quoted = false;
+
+    for (char c : line) {
+        if (c == '"') {
+            quoted = !quoted;
+            inArgument = true;
+        } else if (!quoted && std::isspace(static_cast<unsigned char>(c))) {
+            if (inArgument) {
+                arguments.push_back(std::move(argument));
+                argument.clear();
+                inArgument = false;
+            }
+        } else {
+            argument += c;
+            inArgument = true;
+        }
+    }
+
+    if (quoted) {
+        throw std::invalid_argument("unterminated quote");
+    }
+    if (inArgument) {
+        arguments.push_back(std::move(argument));
+    }
+    return arguments;
+}
+
+/**
+ * @brief Parses every job line of the jobs file with ArgParser, before any job is started.
+ *
+ * Nested `--jobs` and the process-wide options (`--writers`, `--write-buffer`, `--tls-session-cache`,
+ * `--stats`, `--stats-json`, `--job-workers` and `--verbose`) are rejected on a job line.
+ */
+void JobRunner::readJobs() {
+    std::ifstream jobsFile(config.jobsFile);
+    if (!jobsFile.is_open()) {
+        throw std::runtime_error("Failed to open jobs file");
+    }
+
+    std::string line;
+    for (int lineNumber = 1; std::getline(jobsFile, line); ++lineNumber) {
+        size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#') {
+            continue;
+        }
+
+        try {
+            std::vector<std::string> arguments = splitArguments(line);
+            arguments.insert(arguments.begin(), "imapcl");
+
+            std::vector<char*> argv;
+            for (std::string& argument : arguments) {
+                argv.push_back(argument.data());
+            }
+            argv.push_back(nullptr);
+
+            ArgParser parser;
+            jobs.push_back(parser.parse(static_cast<int>(arguments.size()), argv.data()));
+        } catch (const std::exception& e) {
+            throw std::invalid_argument("jobs file line " + std::to_string(lineNumber) + ": " + e.what());
+        }
+        if (!jobs.back().jobsFile.empty()) {
+            throw std::invalid_argument("jobs file line " + std::to_string(lineNumber) + ": jobs cannot be nested");
+        }
+        // writers, stats, TLS reporting and the session cache are shared by all jobs of the process
+        if (!jobs.back().processOptions.empty()) {
+            throw std::invalid_argument("jobs file line " + std::to_string(lineNumber) + ": " +
+                                        jobs.back().processOptions.front() + " applies to all jobs, give it with --jobs");
+        }
+        jobs.back().verbose = config.verbose;
+    }
+}
+
+/**
+ * @brief Runs jobs until none is left; a failed job is reported and the next one is taken.
+ */
+void JobRunner::worker() {
+    while (true) {
+        size_t job;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (nextJob == jobs.size()) {
+                return;
+            }
+            job = nextJob++;
+        }
+
+        int result;
+        try {
+            result = runJob(jobs[job], writerPool);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " + jobs[job].server + " (" + jobs[job].authFile + "): " + e.what() + "\n";
+            result = 1;
+        }
+
+        if (result != 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            failed++;
+        }
+    }
+}
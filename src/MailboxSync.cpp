@@ -0,0 +1,190 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#include "../include/MailboxSync.h"
+#include "IMAPExceptions.h"
+#include "EventLoop.h"
+
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+MailboxSync::MailboxSync(ArgParser::Config config, std::shared_ptr<WriterPool> writerPool)
+        : config(std::move(config)), writerPool(std::move(writerPool)) {}
+
+int MailboxSync::run() {
+    std::unique_ptr<IMAPClient> first;
+    std::vector<std::string> mailboxes = config.mailboxes;
+
+    if (config.allMailboxes) {
+        // the connection used for LIST becomes the first worker
+        first = std::make_unique<IMAPClient>(config);
+        first->setWriterPool(writerPool);
+        first->connect();
+        first->login();
+        mailboxes = first->list();
+    }
+
+    if (config.eventLoops > 0) {
+        if (first) {
+            first->logout();
+            first.reset();
+        }
+        return runEventLoops(mailboxes);
+    }
+
+    queue.assign(mailboxes.begin(), mailboxes.end());
+    size_t workerCount = std::min(queue.size(), static_cast<size_t>(config.workers));
+
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers.emplace_back(&MailboxSync::worker, this, i == 0 ? std::move(first) : nullptr);
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+
+    return failed > 0 ? 1 : 0;
+}
+
+/**
+ * @brief Syncs mailboxes from the queue over one connection.
+ *
+ * A failed mailbox is reported and skipped. If the failure is not a NO/BAD response,
+ * the state of the connection is unknown, so it is dropped and a new one is opened
+ * for the next mailbox.
+ *
+ * @param client Already authenticated client to start with, or nullptr.
+ */
+void MailboxSync::worker(std::unique_ptr<IMAPClient> client) {
+    std::string mailbox;
+
+    while (nextMailbox(mailbox)) {
+        try {
+            if (!client) {
+                client = std::make_unique<IMAPClient>(config);
+                client->setWriterPool(writerPool);
+                client->connect();
+                client->login();
+            }
+
+            client->setMailbox(mailbox, mailboxDirectory(config.outDir, mailbox));
+            client->select();
+
+            if (client->search()) {
+                client->fetch();
+                IMAPClient::reportSaved(client->getSavedCount(), mailbox);
+            } else {
+                std::cout << "No message has been downloaded from the " + mailbox + " mailbox\n" << std::flush;
+            }
+            client->commitSync();
+        } catch (const IMAPNoResponseException& e) {
+            std::cerr << "Error: " + mailbox + ": " + e.what() + "\n";
+            std::lock_guard<std::mutex> lock(mutex);
+            failed++;
+        } catch (const IMAPBadResponseException& e) {
+            std::cerr << "Error: " + mailbox + ": " + e.what() + "\n";
+            std::lock_guard<std::mutex> lock(mutex);
+            failed++;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " + mailbox + ": " + e.what() + "\n";
+            client.reset();
+            std::lock_guard<std::mutex> lock(mutex);
+            failed++;
+        }
+    }
+
+    if (client) {
+        try {
+            client->logout();
+        } catch (const std::exception& e) {
+            std::cerr << std::string("Error: ") + e.what() + "\n";
+        }
+    }
+}
+
+/**
+ * @brief Syncs the mailboxes as AsyncSessions on `eventLoops` threads.
+ *
+ * Mailboxes are assigned to the loops round-robin, and each loop keeps its share of the
+ * `workers` connections open at the same time.
+ *
+ * @param mailboxes The mailboxes to sync.
+ * @return 0 if every mailbox was synced, 1 otherwise.
+ */
+int MailboxSync::runEventLoops(const std::vector<std::string>& mailboxes) {
+    size_t loopCount = std::min(mailboxes.size(), static_cast<size_t>(config.eventLoops));
+    if (loopCount == 0) {
+        return 0;
+    }
+    size_t sessionsPerLoop = (static_cast<size_t>(config.workers) + loopCount - 1) / loopCount;
+
+    std::vector<std::unique_ptr<EventLoop>> loops;
+    for (size_t i = 0; i < loopCount; ++i) {
+        loops.push_back(std::make_unique<EventLoop>(sessionsPerLoop));
+    }
+    for (size_t i = 0; i < mailboxes.size(); ++i) {
+        ArgParser::Config sessionConfig = config;
+        sessionConfig.mailbox = mailboxes[i];
+        sessionConfig.outDir = mailboxDirectory(config.outDir, mailboxes[i]);
+        loops[i % loopCount]->add(std::make_unique<AsyncSession>(sessionConfig, writerPool));
+    }
+
+    std::vector<std::thread> threads;
+    for (auto& loop : loops) {
+        threads.emplace_back([this, &loop]() {
+            int loopFailed;
+            try {
+                loopFailed = loop->run();
+            } catch (const std::exception& e) {
+                std::cerr << std::string("Error: ") + e.what() + "\n";
+                loopFailed = 1;
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            failed += loopFailed;
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    return failed > 0 ? 1 : 0;
+}
+
+bool MailboxSync::nextMailbox(std::string& mailbox) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (queue.empty()) {
+        return false;
+    }
+    mailbox = std::move(queue.front());
+    queue.pop_front();
+    return true;
+}
+
+/**
+ * @brief Maps a mailbox name onto a subdirectory of the output directory.
+ *
+ * Hierarchy levels separated by '/' become nested directories; empty, "." and ".."
+ * levels are dropped so that a mailbox name can never point outside outDir.
+ */
+std::string MailboxSync::mailboxDirectory(const std::string& outDir, const std::string& mailbox) {
+    std::string directory = outDir;
+    size_t start = 0;
+
+    while (start <= mailbox.size()) {
+        size_t end = mailbox.find('/', start);
+        if (end == std::string::npos) {
+            end = mailbox.size();
+        }
+
+        std::string level = mailbox.substr(start, end - start);
+        if (!level.empty() && level != "." && level != "..") {
+            directory += "/" + level;
+        }
+        start = end + 1;
+    }
+    return directory;
+}
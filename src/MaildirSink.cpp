@@ -0,0 +1,63 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#include "../include/MaildirSink.h"
+#include <filesystem>
+#include <iostream>
+#include <utility>
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
+MaildirSink::MaildirSink(std::string outDir) : outDir(std::move(outDir)) {
+    char host[256] = "localhost";
+    gethostname(host, sizeof(host) - 1);
+    for (char* c = host; *c; ++c) {
+        if (*c == '/' || *c == ':') {
+            *c = '_';   // not allowed in Maildir names
+        }
+    }
+    hostname = host;
+}
+
+MessageSink::Result MaildirSink::store(uint32_t messageId, std::string_view message, std::string& name) {
+    std::call_once(created, [this] {
+        for (const char* sub : {"tmp", "new", "cur"}) {
+            std::filesystem::create_directories(outDir + "/" + sub);
+        }
+    });
+
+    std::string unique = uniqueName();
+    std::string tmpPath = outDir + "/tmp/" + unique;
+
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "Failed to save message " + std::to_string(messageId) + " to " + tmpPath + "\n";
+        return Result::FAILED;
+    }
+    bool written = writeAll(fd, message);
+    if (::close(fd) != 0 || !written || std::rename(tmpPath.c_str(), (outDir + "/new/" + unique).c_str()) != 0) {
+        std::cerr << "Failed to save message " + std::to_string(messageId) + " to " + tmpPath + "\n";
+        std::remove(tmpPath.c_str());
+        return Result::FAILED;
+    }
+
+    name = "new/" + unique;
+    return Result::SAVED;
+}
+
+void MaildirSink::close() {}
+
+/**
+ * @brief Builds `<seconds>.M<microseconds>P<pid>Q<counter>.<host>` as recommended for Maildir.
+ */
+std::string MaildirSink::uniqueName() {
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(now);
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(now - seconds);
+
+    return std::to_string(seconds.count()) + ".M" + std::to_string(micros.count()) + "P" + std::to_string(getpid()) +
+           "Q" + std::to_string(counter++) + "." + hostname;
+}
@@ -0,0 +1,85 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#include "../include/MboxSink.h"
+#include <stdexcept>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+
+MboxSink::MboxSink(const std::string& outDir) : path(outDir + "/mbox") {}
+
+MboxSink::~MboxSink() {
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+/**
+ * @brief Converts the message into the buffer, writing the buffer out once it is large enough.
+ */
+MessageSink::Result MboxSink::store(uint32_t, std::string_view message, std::string& name) {
+    char date[32];
+    std::time_t now = std::time(nullptr);
+    struct tm utc{};
+    gmtime_r(&now, &utc);
+    std::strftime(date, sizeof(date), "%a %b %e %H:%M:%S %Y", &utc);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    buffer.append("From MAILER-DAEMON ").append(date).append("\n");
+
+    size_t lineStart = 0;
+    while (lineStart < message.size()) {
+        size_t lineEnd = message.find('\n', lineStart);
+        if (lineEnd == std::string_view::npos) {
+            lineEnd = message.size();
+        }
+        std::string_view line = message.substr(lineStart, lineEnd - lineStart);
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+
+        // mboxrd: ">From ", ">>From ", ... get one more '>' so readers can undo it
+        size_t quotes = line.find_first_not_of('>');
+        if (quotes != std::string_view::npos && line.compare(quotes, 5, "From ") == 0) {
+            buffer += '>';
+        }
+        buffer.append(line).append("\n");
+        lineStart = lineEnd + 1;
+    }
+    buffer += '\n';
+
+    if (buffer.size() >= flushSize) {
+        flush();
+    }
+    name = "mbox";
+    return failed ? Result::FAILED : Result::SAVED;
+}
+
+void MboxSink::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    flush();
+    if (fd >= 0) {
+        if (::close(fd) != 0) {
+            failed = true;
+        }
+        fd = -1;
+    }
+    if (failed) {
+        throw std::runtime_error("Failed to write " + path);
+    }
+}
+
+void MboxSink::flush() {
+    if (buffer.empty() || failed) {
+        return;
+    }
+    if (fd < 0) {
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    }
+    if (fd < 0 || !writeAll(fd, buffer)) {
+        failed = true;
+    }
+    buffer.clear();
+}
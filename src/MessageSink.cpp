@@ -0,0 +1,40 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#include "../include/MessageSink.h"
+#include "MboxSink.h"
+#include "MaildirSink.h"
+#include "PackSink.h"
+#include "Stats.h"
+#include <stdexcept>
+#include <cerrno>
+#include <unistd.h>
+
+std::shared_ptr<MessageSink> MessageSink::create(const std::string& format, const std::string& outDir) {
+    if (format == "mbox") {
+        return std::make_shared<MboxSink>(outDir);
+    } else if (format == "maildir") {
+        return std::make_shared<MaildirSink>(outDir);
+    } else if (format == "pack") {
+        return std::make_shared<PackSink>(outDir);
+    }
+    throw std::invalid_argument("unknown output format: " + format);
+}
+
+bool MessageSink::writeAll(int fd, std::string_view data) {
+    Stats& stats = Stats::getInstance();
+    while (!data.empty()) {
+        auto start = stats.now();
+        ssize_t written = write(fd, data.data(), data.size());
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        stats.diskWrite(static_cast<uint64_t>(written), start);
+        data.remove_prefix(static_cast<size_t>(written));
+    }
+    return true;
+}
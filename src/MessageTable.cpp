@@ -0,0 +1,343 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#include "../include/MessageTable.h"
+#include "HeaderDecoder.h"
+#include <algorithm>
+#include <charconv>
+#include <cctype>
+#include <cstring>
+#include <cstdio>
+
+namespace {
+    bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+            return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+        });
+    }
+
+    bool containsIgnoreCase(std::string_view text, std::string_view part) {
+        return std::search(text.begin(), text.end(), part.begin(), part.end(), [](char x, char y) {
+            return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+        }) != text.end();
+    }
+
+    template<typename T>
+    bool toNumber(std::string_view text, T& value) {
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        return error == std::errc() && end == text.data() + text.size();
+    }
+
+    /**
+     * @brief Reads the values of a FETCH response: atoms, NIL, quoted strings, literals and lists.
+     *
+     * The reader never moves past the end of a response line except inside a literal, so a
+     * malformed line is skipped with skipLine() without losing the following ones.
+     */
+    class Reader {
+    public:
+        explicit Reader(std::string_view text) : text(text) {}
+
+        [[nodiscard]] bool atEnd() const {
+            return pos >= text.size();
+        }
+
+        /**
+         * @brief Checks whether another value follows on the current line.
+         */
+        bool more() {
+            skipSpaces();
+            return pos < text.size() && text[pos] != '\r' && text[pos] != '\n' && text[pos] != ')';
+        }
+
+        bool consume(char c) {
+            skipSpaces();
+            if (pos < text.size() && text[pos] == c) {
+                ++pos;
+                return true;
+            }
+            return false;
+        }
+
+        std::string_view atom() {
+            skipSpaces();
+            size_t start = pos;
+            while (pos < text.size() && std::strchr(" ()\"{\r\n", text[pos]) == nullptr) {
+                ++pos;
+            }
+            return text.substr(start, pos - start);
+        }
+
+        /**
+         * @brief Reads an nstring.
+         * @return False for NIL or if no string follows.
+         */
+        bool string(std::string& value) {
+            value.clear();
+            skipSpaces();
+            if (pos >= text.size()) {
+                return false;
+            }
+
+            if (text[pos] == '"') {
+                for (++pos; pos < text.size() && text[pos] != '"'; ++pos) {
+                    if (text[pos] == '\\' && pos + 1 < text.size()) {
+                        ++pos;
+                    }
+                    value += text[pos];
+                }
+                ++pos;
+                return true;
+            }
+
+            if (text[pos] == '{') {
+                size_t close = text.find('}', pos);
+                size_t size;
+                if (close == std::string_view::npos || !toNumber(text.substr(pos + 1, close - pos - 1), size) ||
+                    text.substr(close + 1, 2) != "\r\n") {
+                    ++pos;
+                    return false;
+                }
+                pos = std::min(close + 3, text.size());
+                value.assign(text.substr(pos, size));
+                pos = std::min(pos + size, text.size());
+                return true;
+            }
+
+            std::string_view word = atom();
+            if (word.empty() || equalsIgnoreCase(word, "NIL")) {
+                return false;
+            }
+            value.assign(word);
+            return true;
+        }
+
+        /**
+         * @brief Skips one value of any kind, including nested lists.
+         */
+        void skipValue() {
+            std::string ignored;
+            if (consume('(')) {
+                while (more()) {
+                    skipValue();
+                }
+                consume(')');
+            } else {
+                string(ignored);
+            }
+        }
+
+        void skipLine() {
+            size_t end = text.find('\n', pos);
+            pos = end == std::string_view::npos ? text.size() : end + 1;
+        }
+
+    private:
+        std::string_view text;
+        size_t pos = 0;
+
+        void skipSpaces() {
+            while (pos < text.size() && text[pos] == ' ') {
+                ++pos;
+            }
+        }
+    };
+
+    /**
+     * @brief Reads an address list of an envelope into `Name <mailbox@host>` entries.
+     */
+    std::string readAddresses(Reader& reader) {
+        std::string addresses;
+        if (!reader.consume('(')) {
+            reader.skipValue();     // NIL
+            return addresses;
+        }
+
+        std::string name, route, mailbox, host;
+        while (reader.more()) {
+            if (!reader.consume('(')) {
+                reader.skipValue();
+                continue;
+            }
+            reader.string(name);
+            reader.string(route);
+            reader.string(mailbox);
+            reader.string(host);
+            while (reader.more()) {
+                reader.skipValue();
+            }
+            reader.consume(')');
+
+            // the start and the end of a group (RFC 3501, section 7.4.2) have no host
+            if (mailbox.empty() || host.empty()) {
+                continue;
+            }
+            if (!addresses.empty()) {
+                addresses += ", ";
+            }
+            std::string decodedName = HeaderDecoder::decode(name);
+            if (decodedName.empty()) {
+                addresses += mailbox + "@" + host;
+            } else {
+                addresses += decodedName + " <" + mailbox + "@" + host + ">";
+            }
+        }
+        reader.consume(')');
+        return addresses;
+    }
+
+    /**
+     * @brief Reads the date, subject and From of an envelope and skips its other fields.
+     */
+    void readEnvelope(Reader& reader, MessageInfo& info) {
+        if (!reader.consume('(')) {
+            reader.skipValue();
+            return;
+        }
+
+        reader.string(info.date);
+        std::string subject;
+        if (reader.string(subject)) {
+            info.subject = HeaderDecoder::decode(subject);
+        }
+        info.from = readAddresses(reader);
+
+        while (reader.more()) {
+            reader.skipValue();
+        }
+        reader.consume(')');
+    }
+}
+
+MessageTable::Filter::Filter(const ArgParser::Config& config)
+        : maxSize(config.maxSize), receivedAfter(config.receivedAfter),
+          receivedBefore(config.receivedBefore), sender(config.sender) {}
+
+bool MessageTable::Filter::active() const {
+    return maxSize > 0 || receivedAfter > 0 || receivedBefore > 0 || !sender.empty();
+}
+
+bool MessageTable::Filter::matches(const MessageInfo& info) const {
+    if (maxSize > 0 && info.size > maxSize) {
+        return false;
+    }
+    if (receivedAfter > 0 && (info.internalDate == 0 || info.internalDate < receivedAfter)) {
+        return false;
+    }
+    if (receivedBefore > 0 && (info.internalDate == 0 || info.internalDate >= receivedBefore)) {
+        return false;
+    }
+    return sender.empty() || containsIgnoreCase(info.from, sender);
+}
+
+size_t MessageTable::parse(std::string_view response) {
+    Reader reader(response);
+    size_t added = 0;
+    std::string value;
+
+    while (!reader.atEnd()) {
+        // "* <n> FETCH (<item> <value> ...)"
+        if (!reader.consume('*') || reader.atom().empty() ||
+            !equalsIgnoreCase(reader.atom(), "FETCH") || !reader.consume('(')) {
+            reader.skipLine();
+            continue;
+        }
+
+        MessageInfo info;
+        while (reader.more()) {
+            std::string_view item = reader.atom();
+            if (item.empty()) {
+                break;
+            }
+
+            if (equalsIgnoreCase(item, "UID")) {
+                toNumber(reader.atom(), info.uid);
+            } else if (equalsIgnoreCase(item, "RFC822.SIZE")) {
+                toNumber(reader.atom(), info.size);
+            } else if (equalsIgnoreCase(item, "INTERNALDATE")) {
+                if (reader.string(value)) {
+                    parseInternalDate(value, info.internalDate);
+                }
+            } else if (equalsIgnoreCase(item, "ENVELOPE")) {
+                readEnvelope(reader, info);
+            } else {
+                reader.skipValue();
+            }
+        }
+        reader.skipLine();
+
+        if (info.uid > 0) {
+            messages[info.uid] = std::move(info);
+            ++added;
+        }
+    }
+    return added;
+}
+
+std::vector<uint32_t> MessageTable::select(const std::vector<uint32_t>& ids, const Filter& filter,
+                                      std::vector<uint32_t>& rejected) const {
+    std::vector<uint32_t> selected;
+    selected.reserve(ids.size());
+    for (uint32_t uid : ids) {
+        const MessageInfo* info = find(uid);
+        if (info == nullptr || filter.matches(*info)) {
+            selected.push_back(uid);
+        } else {
+            rejected.push_back(uid);
+        }
+    }
+    return selected;
+}
+
+const MessageInfo* MessageTable::find(uint32_t uid) const {
+    auto it = messages.find(uid);
+    return it == messages.end() ? nullptr : &it->second;
+}
+
+size_t MessageTable::size() const {
+    return messages.size();
+}
+
+void MessageTable::clear() {
+    messages.clear();
+}
+
+bool MessageTable::parseInternalDate(std::string_view text, std::time_t& time) {
+    static constexpr const char* months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                             "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+    // the day may be padded with a space instead of a zero
+    while (!text.empty() && text.front() == ' ') {
+        text.remove_prefix(1);
+    }
+
+    int day, year, hour, minute, second, zone;
+    char month[4], sign;
+    if (std::sscanf(std::string(text).c_str(), "%d-%3s-%d %d:%d:%d %c%4d",
+                    &day, month, &year, &hour, &minute, &second, &sign, &zone) != 8 ||
+        (sign != '+' && sign != '-')) {
+        return false;
+    }
+
+    std::tm tm{};
+    tm.tm_mon = -1;
+    for (int i = 0; i < 12; ++i) {
+        if (equalsIgnoreCase(month, months[i])) {
+            tm.tm_mon = i;
+        }
+    }
+    if (tm.tm_mon < 0 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) {
+        return false;
+    }
+    tm.tm_mday = day;
+    tm.tm_year = year - 1900;
+    tm.tm_hour = hour;
+    tm.tm_min = minute;
+    tm.tm_sec = second;
+
+    // the local time is ahead of UTC by a positive zone
+    int offset = (zone / 100 * 60 + zone % 100) * 60;
+    time = timegm(&tm) - (sign == '+' ? offset : -offset);
+    return true;
+}
@@ -0,0 +1,418 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#include "../include/MessageWriter.h"
+#include "../include/Stats.h"
+#include <filesystem>
+#include <iostream>
+#include <atomic>
+#include <algorithm>
+#include <utility>
+#include <string_view>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+/**
+ * @brief Writes all given buffers, continuing after partial writes and interrupts.
+ * @return False if the write failed.
+ */
+static bool writeFully(int fd, struct iovec* iov, int count) {
+    Stats& stats = Stats::getInstance();
+    while (count > 0) {
+        auto start = stats.now();
+        ssize_t written = writev(fd, iov, count);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        stats.diskWrite(static_cast<uint64_t>(written), start);
+
+        // drop the buffers written completely, move into the one written partially
+        auto remaining = static_cast<size_t>(written);
+        while (count > 0 && remaining >= iov->iov_len) {
+            remaining -= iov->iov_len;
+            ++iov;
+            --count;
+        }
+        if (count > 0) {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + remaining;
+            iov->iov_len -= remaining;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Reads up to `length` bytes, continuing after interrupts.
+ * @return The number of bytes read, less than length only at the end of the file, -1 on failure.
+ */
+static ssize_t readFully(int fd, char* data, size_t length) {
+    size_t total = 0;
+    while (total < length) {
+        ssize_t received = read(fd, data + total, length - total);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        } else if (received < 0) {
+            return -1;
+        } else if (received == 0) {
+            break;
+        }
+        total += static_cast<size_t>(received);
+    }
+    return static_cast<ssize_t>(total);
+}
+
+/**
+ * @brief Returns the file name part of a path.
+ */
+static std::string baseName(const std::string& path) {
+    return std::filesystem::path(path).filename().string();
+}
+
+MessageWriter::MessageWriter(NameBuilder nameBuilder, StoredCallback onStored)
+        : nameBuilder(std::move(nameBuilder)), onStored(std::move(onStored)) {}
+
+MessageWriter::~MessageWriter() {
+    flush();
+    closeFile();
+}
+
+void MessageWriter::setPool(std::shared_ptr<WriterPool> writerPool) {
+    flush();
+    pool = std::move(writerPool);
+}
+
+void MessageWriter::setSink(std::shared_ptr<MessageSink> messageSink) {
+    flush();
+    sink = std::move(messageSink);
+}
+
+void MessageWriter::begin(uint32_t id) {
+    closeFile();
+    messageId = id;
+    headerBuffer.clear();
+    headers.clear();
+    filename.clear();
+    tmpFilename.clear();
+    message.clear();
+    opened = false;
+    skipped = false;
+    failed = false;
+    existed = false;
+}
+
+void MessageWriter::setMessageId(uint32_t id) {
+    messageId = id;
+}
+
+/**
+ * @brief Peeks the header block of the message, then writes through without copying.
+ *
+ * Only the bytes up to the blank line ending the headers are copied into headerBuffer;
+ * the rest of the chunk is written together with them by a single writev().
+ */
+void MessageWriter::write(const char* data, size_t length) {
+    if (skipped) {
+        return;
+    }
+
+    if (collecting()) {
+        message.append(data, length);
+        return;
+    }
+
+    if (opened) {
+        struct iovec iov{const_cast<char*>(data), length};
+        if (!failed && !writeFully(fd, &iov, 1)) {
+            failed = true;
+        }
+        return;
+    }
+
+    std::string_view chunk(data, length);
+    size_t headerLength = std::string_view::npos;   // bytes of this chunk belonging to the headers
+
+    // the blank line may be split between two chunks, so look at the last peeked bytes too
+    size_t carry = std::min<size_t>(headerBuffer.size(), 3);
+    std::string boundary = headerBuffer.substr(headerBuffer.size() - carry);
+    boundary.append(chunk.substr(0, 3));
+    size_t boundaryEnd = boundary.find("\r\n\r\n");
+    if (boundaryEnd != std::string::npos) {
+        headerLength = boundaryEnd + 4 - carry;
+    } else if ((headerLength = chunk.find("\r\n\r\n")) != std::string_view::npos) {
+        headerLength += 4;
+    }
+
+    bool complete = headerLength != std::string_view::npos;
+    size_t peek = complete ? headerLength : length;
+    if (headerBuffer.size() + peek >= maxHeaderPeek) {
+        peek = maxHeaderPeek - headerBuffer.size();
+        complete = true;
+    }
+
+    headerBuffer.append(data, peek);
+    if (complete) {
+        open(data + peek, length - peek);
+    }
+}
+
+bool MessageWriter::needsHeaders() const {
+    return !collecting() && !opened && !skipped;
+}
+
+int MessageWriter::outputFd() const {
+    return opened && !failed ? fd : -1;
+}
+
+void MessageWriter::writeFailed() {
+    failed = true;
+}
+
+void MessageWriter::finish() {
+    if (collecting()) {
+        if (!skipped) {
+            submit();
+        }
+        return;
+    }
+
+    if (!opened && !skipped) {
+        open();
+    }
+
+    if (skipped) {
+        if (existed) {
+            onStored(messageId, baseName(filename), false);
+        }
+        return;
+    }
+
+    if (::close(fd) != 0) {
+        failed = true;
+    }
+    fd = -1;
+    opened = false;
+
+    if (failed) {
+        // a partial file would be taken for a saved message by the next run
+        std::cerr << "Failed to save message " << messageId << " to " << filename << std::endl;
+        std::filesystem::remove(filename);
+        return;
+    }
+
+    if (!tmpFilename.empty()) {
+        // the ID arrived after the body, give the temporary file its real name now
+        filename = nameBuilder(messageId, headers);
+        if (std::filesystem::exists(filename)) {
+            std::filesystem::remove(tmpFilename);
+            onStored(messageId, baseName(filename), false);
+            return;
+        }
+        std::filesystem::rename(tmpFilename, filename);
+    }
+
+    onStored(messageId, baseName(filename), true);
+}
+
+void MessageWriter::discard() {
+    if (opened) {
+        closeFile();
+        if (!tmpFilename.empty()) {
+            std::filesystem::remove(tmpFilename);
+        }
+    }
+    message.clear();
+    opened = false;
+    skipped = true;
+    existed = false;
+}
+
+void MessageWriter::adopt(uint32_t id, const std::string& path) {
+    int file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0) {
+        std::cerr << "Failed to read message " + std::to_string(id) + " from " + path + "\n";
+        return;
+    }
+
+    if (collecting()) {
+        begin(id);
+        std::string buffer(1024 * 1024, '\0');
+        ssize_t received;
+        while ((received = readFully(file, buffer.data(), buffer.size())) > 0) {
+            write(buffer.data(), static_cast<size_t>(received));
+        }
+        ::close(file);
+        std::filesystem::remove(path);
+        if (received < 0) {
+            std::cerr << "Failed to read message " + std::to_string(id) + " from " + path + "\n";
+            discard();
+            return;
+        }
+        finish();
+        return;
+    }
+
+    // only the headers are read for naming, the file itself becomes the message file
+    std::string peeked(maxHeaderPeek, '\0');
+    ssize_t received = readFully(file, peeked.data(), peeked.size());
+    ::close(file);
+    if (received < 0) {
+        std::cerr << "Failed to read message " + std::to_string(id) + " from " + path + "\n";
+        return;
+    }
+    peeked.resize(static_cast<size_t>(received));
+
+    std::string name = nameBuilder(id, peeked.substr(0, peeked.find("\r\n\r\n")));
+    if (std::filesystem::exists(name)) {
+        std::filesystem::remove(path);
+        onStored(id, baseName(name), false);
+        return;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(path, name, error);
+    if (error) {
+        std::cerr << "Failed to save message " + std::to_string(id) + " to " + name + "\n";
+        return;
+    }
+    onStored(id, baseName(name), true);
+}
+
+void MessageWriter::flush() {
+    std::unique_lock<std::mutex> lock(pendingMutex);
+    pendingDone.wait(lock, [this] { return pending == 0; });
+}
+
+bool MessageWriter::collecting() const {
+    return pool || sink;
+}
+
+/**
+ * @brief Hands the collected message to the sink, or names it and queues it for a pool thread.
+ *
+ * The file name is built here, on the receiving thread, as it depends on the state of the
+ * client (e.g. the output directory), which may change before the pool gets to it.
+ */
+void MessageWriter::submit() {
+    std::function<void(const std::string&)> task;
+    if (sink) {
+        task = [this, target = sink, id = messageId](const std::string& data) {
+            std::string name;
+            if (target->store(id, data, name) == MessageSink::Result::SAVED) {
+                onStored(id, name, true);
+            }
+        };
+    } else {
+        size_t headersEnd = std::string_view(message).substr(0, maxHeaderPeek).find("\r\n\r\n");
+        task = [this, path = nameBuilder(messageId, message.substr(0, std::min(headersEnd, maxHeaderPeek))),
+                id = messageId](const std::string& data) {
+            store(path, data, id, onStored);
+        };
+    }
+
+    if (!pool) {
+        task(message);
+        message.clear();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        ++pending;
+    }
+    size_t bytes = message.size();
+    pool->submit(bytes, [this, task = std::move(task), data = std::move(message), id = messageId]() {
+        // the pool thread must not throw, e.g. when a sink cannot create its directories
+        try {
+            task(data);
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to save message " + std::to_string(id) + ": " + e.what() + "\n";
+        }
+
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        if (--pending == 0) {
+            pendingDone.notify_all();
+        }
+    });
+    message = std::string();
+}
+
+/**
+ * @brief Writes a complete message into a new file, run by the pool threads.
+ */
+void MessageWriter::store(const std::string& path, const std::string& data, uint32_t messageId, const StoredCallback& onStored) {
+    std::error_code error;
+    if (std::filesystem::exists(path, error)) {
+        onStored(messageId, baseName(path), false);
+        return;
+    }
+
+    int file = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (file < 0) {
+        std::cerr << "Failed to save message " + std::to_string(messageId) + " to " + path + "\n";
+        return;
+    }
+
+    struct iovec iov{const_cast<char*>(data.data()), data.size()};
+    bool written = writeFully(file, &iov, 1);
+    if (::close(file) != 0 || !written) {
+        std::cerr << "Failed to save message " + std::to_string(messageId) + " to " + path + "\n";
+        std::filesystem::remove(path, error);
+        return;
+    }
+
+    onStored(messageId, baseName(path), true);
+}
+
+/**
+ * @brief Resolves the file name from the peeked headers and writes them into the new file.
+ *
+ * @param rest The part of the current chunk following the headers, written in the same call.
+ * @param restLength The length of rest.
+ */
+void MessageWriter::open(const char* rest, size_t restLength) {
+    static std::atomic<unsigned> tmpCounter{0};
+
+    size_t headersEnd = headerBuffer.find("\r\n\r\n");
+    headers = headerBuffer.substr(0, headersEnd);
+    filename = nameBuilder(messageId, headers);
+
+    if (messageId == 0) {
+        std::filesystem::path directory = std::filesystem::path(filename).parent_path();
+        tmpFilename = (directory / (".msg-" + std::to_string(getpid()) + "-" + std::to_string(tmpCounter++) + ".part")).string();
+        filename = tmpFilename;
+    } else {
+        headers.clear();
+        if (std::filesystem::exists(filename)) {
+            skipped = true;
+            existed = true;
+            return;
+        }
+    }
+
+    fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "Failed to save message " << messageId << " to " << filename << std::endl;
+        skipped = true;
+        return;
+    }
+    opened = true;
+
+    struct iovec iov[2] = {{headerBuffer.data(), headerBuffer.size()}, {const_cast<char*>(rest), restLength}};
+    if (!writeFully(fd, iov, rest ? 2 : 1)) {
+        failed = true;
+    }
+    headerBuffer.clear();
+}
+
+void MessageWriter::closeFile() {
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
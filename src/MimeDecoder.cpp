@@ -0,0 +1,477 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#include "MimeDecoder.h"
+
+#include <array>
+#include <atomic>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define IMAPCL_X86 1
+#endif
+
+namespace {
+    constexpr uint8_t invalid = 0x80;   ///< characters skipped by the base64 decoder
+    constexpr uint8_t padding = 0x81;   ///< `=`, ends a group
+
+    constexpr std::array<uint8_t, 256> makeBase64Values() {
+        std::array<uint8_t, 256> values{};
+        for (auto& value : values) {
+            value = invalid;
+        }
+        constexpr std::string_view alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        for (size_t i = 0; i < alphabet.size(); ++i) {
+            values[static_cast<unsigned char>(alphabet[i])] = static_cast<uint8_t>(i);
+        }
+        values['='] = padding;
+        return values;
+    }
+
+    constexpr std::array<uint8_t, 256> base64Values = makeBase64Values();
+
+    SimdLevel detectLevel() {
+#ifdef IMAPCL_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return SimdLevel::AVX2;
+        }
+        if (__builtin_cpu_supports("ssse3") && __builtin_cpu_supports("sse4.1")) {
+            return SimdLevel::SSE4;
+        }
+#endif
+        return SimdLevel::SCALAR;
+    }
+
+    const SimdLevel supported = detectLevel();
+    std::atomic<SimdLevel> current{supported};
+
+    /**
+     * @brief Progress of a block decoder over the input and the output.
+     */
+    struct Blocks {
+        size_t consumed = 0;
+        size_t produced = 0;
+    };
+
+    /**
+     * @brief Decodes groups of four valid characters until the first character outside the alphabet.
+     */
+    void decodeGroups(const unsigned char* input, size_t size, char* output, Blocks& blocks) {
+        while (size - blocks.consumed >= 4) {
+            const unsigned char* in = input + blocks.consumed;
+            uint8_t a = base64Values[in[0]], b = base64Values[in[1]], c = base64Values[in[2]], d = base64Values[in[3]];
+            if ((a | b | c | d) & invalid) {
+                return;
+            }
+            uint32_t value = static_cast<uint32_t>(a) << 18 | static_cast<uint32_t>(b) << 12 |
+                             static_cast<uint32_t>(c) << 6 | d;
+            char* out = output + blocks.produced;
+            out[0] = static_cast<char>(value >> 16);
+            out[1] = static_cast<char>(value >> 8);
+            out[2] = static_cast<char>(value);
+            blocks.consumed += 4;
+            blocks.produced += 3;
+        }
+    }
+
+    size_t findDelimiterScalar(const char* input, size_t size, char extra) {
+        for (size_t i = 0; i < size; ++i) {
+            char c = input[i];
+            if (c == '=' || c == '\r' || c == '\n' || c == extra) {
+                return i;
+            }
+        }
+        return size;
+    }
+
+#ifdef IMAPCL_X86
+    /*
+     * The base64 blocks follow W. Muła and D. Lemire, "Faster Base64 Encoding and Decoding Using
+     * AVX2 Instructions" (2018): the nibbles of every byte index two tables whose AND is nonzero
+     * only for characters outside the alphabet, a third table gives the offset turning a valid
+     * character into its sextet, and multiply-adds pack four sextets into three bytes. A block
+     * is stored as a whole, so 4 (SSE) or 8 (AVX2) bytes past the decoded ones are overwritten;
+     * the callers only decode blocks while enough input follows to guarantee the room.
+     */
+
+    __attribute__((target("ssse3,sse4.1")))
+    void decodeBlocksSse4(const unsigned char* input, size_t size, char* output, Blocks& blocks) {
+        const __m128i lutLo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                            0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+        const __m128i lutHi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                            0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+        const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+        const __m128i mask2F = _mm_set1_epi8(0x2F);
+        const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+        while (size - blocks.consumed >= 32) {
+            __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + blocks.consumed));
+            __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(in, 4), mask2F);
+            __m128i lo = _mm_shuffle_epi8(lutLo, _mm_and_si128(in, mask2F));
+            __m128i hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+            if (!_mm_testz_si128(lo, hi)) {
+                return;
+            }
+            __m128i roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(_mm_cmpeq_epi8(in, mask2F), hiNibbles));
+            __m128i sextets = _mm_add_epi8(in, roll);
+            __m128i merged = _mm_maddubs_epi16(sextets, _mm_set1_epi32(0x01400140));
+            __m128i packed = _mm_shuffle_epi8(_mm_madd_epi16(merged, _mm_set1_epi32(0x00011000)), pack);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + blocks.produced), packed);
+            blocks.consumed += 16;
+            blocks.produced += 12;
+        }
+    }
+
+    __attribute__((target("avx2")))
+    void decodeBlocksAvx2(const unsigned char* input, size_t size, char* output, Blocks& blocks) {
+        const __m256i lutLo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                               0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+                                               0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                               0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+        const __m256i lutHi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                               0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+                                               0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                               0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+        const __m256i lutRoll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+                                                 0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+        const __m256i mask2F = _mm256_set1_epi8(0x2F);
+        const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                              2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+        const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+
+        while (size - blocks.consumed >= 64) {
+            __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + blocks.consumed));
+            __m256i hiNibbles = _mm256_and_si256(_mm256_srli_epi32(in, 4), mask2F);
+            __m256i lo = _mm256_shuffle_epi8(lutLo, _mm256_and_si256(in, mask2F));
+            __m256i hi = _mm256_shuffle_epi8(lutHi, hiNibbles);
+            if (!_mm256_testz_si256(lo, hi)) {
+                return;
+            }
+            __m256i roll = _mm256_shuffle_epi8(lutRoll, _mm256_add_epi8(_mm256_cmpeq_epi8(in, mask2F), hiNibbles));
+            __m256i sextets = _mm256_add_epi8(in, roll);
+            __m256i merged = _mm256_maddubs_epi16(sextets, _mm256_set1_epi32(0x01400140));
+            __m256i packed = _mm256_shuffle_epi8(_mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000)), pack);
+            packed = _mm256_permutevar8x32_epi32(packed, lanes);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + blocks.produced), packed);
+            blocks.consumed += 32;
+            blocks.produced += 24;
+        }
+    }
+
+    __attribute__((target("ssse3,sse4.1")))
+    size_t findDelimiterSse4(const char* input, size_t size, char extra) {
+        const __m128i equals = _mm_set1_epi8('=');
+        const __m128i cr = _mm_set1_epi8('\r');
+        const __m128i lf = _mm_set1_epi8('\n');
+        const __m128i other = _mm_set1_epi8(extra);
+        size_t i = 0;
+        for (; i + 16 <= size; i += 16) {
+            __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+            __m128i found = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(in, equals), _mm_cmpeq_epi8(in, cr)),
+                                         _mm_or_si128(_mm_cmpeq_epi8(in, lf), _mm_cmpeq_epi8(in, other)));
+            int mask = _mm_movemask_epi8(found);
+            if (mask != 0) {
+                return i + __builtin_ctz(static_cast<unsigned>(mask));
+            }
+        }
+        return i + findDelimiterScalar(input + i, size - i, extra);
+    }
+
+    __attribute__((target("avx2")))
+    size_t findDelimiterAvx2(const char* input, size_t size, char extra) {
+        const __m256i equals = _mm256_set1_epi8('=');
+        const __m256i cr = _mm256_set1_epi8('\r');
+        const __m256i lf = _mm256_set1_epi8('\n');
+        const __m256i other = _mm256_set1_epi8(extra);
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32) {
+            __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i));
+            __m256i found = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpeq_epi8(in, equals), _mm256_cmpeq_epi8(in, cr)),
+                    _mm256_or_si256(_mm256_cmpeq_epi8(in, lf), _mm256_cmpeq_epi8(in, other)));
+            auto mask = static_cast<unsigned>(_mm256_movemask_epi8(found));
+            if (mask != 0) {
+                return i + __builtin_ctz(mask);
+            }
+        }
+        return i + findDelimiterSse4(input + i, size - i, extra);
+    }
+#endif
+
+    /**
+     * @brief Decodes the longest prefix of valid base64 groups with the selected instruction set.
+     */
+    Blocks decodeBlocks(const unsigned char* input, size_t size, char* output) {
+        Blocks blocks;
+#ifdef IMAPCL_X86
+        SimdLevel level = current.load(std::memory_order_relaxed);
+        if (level == SimdLevel::AVX2) {
+            decodeBlocksAvx2(input, size, output, blocks);
+        }
+        if (level != SimdLevel::SCALAR) {
+            decodeBlocksSse4(input, size, output, blocks);
+        }
+#endif
+        decodeGroups(input, size, output, blocks);
+        return blocks;
+    }
+
+    /**
+     * @brief Finds the first `=`, CR, LF or `extra` with the selected instruction set.
+     */
+    size_t findDelimiter(const char* input, size_t size, char extra) {
+#ifdef IMAPCL_X86
+        switch (current.load(std::memory_order_relaxed)) {
+            case SimdLevel::AVX2:
+                return findDelimiterAvx2(input, size, extra);
+            case SimdLevel::SSE4:
+                return findDelimiterSse4(input, size, extra);
+            case SimdLevel::SCALAR:
+                break;
+        }
+#endif
+        return findDelimiterScalar(input, size, extra);
+    }
+
+    int hexValue(char c) {
+        if (c >= '0' && c <= '9') {
+            return c - '0';
+        }
+        if (c >= 'A' && c <= 'F') {
+            return c - 'A' + 10;
+        }
+        if (c >= 'a' && c <= 'f') {
+            return c - 'a' + 10;
+        }
+        return -1;
+    }
+
+    bool isBlank(char c) {
+        return c == ' ' || c == '\t';
+    }
+}
+
+SimdLevel MimeDecoder::supportedLevel() {
+    return supported;
+}
+
+SimdLevel MimeDecoder::level() {
+    return current.load(std::memory_order_relaxed);
+}
+
+void MimeDecoder::setLevel(SimdLevel level) {
+    current.store(level > supported ? supported : level, std::memory_order_relaxed);
+}
+
+const char* MimeDecoder::levelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AVX2:
+            return "avx2";
+        case SimdLevel::SSE4:
+            return "sse4";
+        case SimdLevel::SCALAR:
+            break;
+    }
+    return "scalar";
+}
+
+size_t Base64Decoder::update(const char* input, size_t size, char* output) {
+    const auto* in = reinterpret_cast<const unsigned char*>(input);
+    char* out = output;
+    size_t i = 0;
+
+    while (i < size) {
+        if (count == 0) {
+            // between groups, whole runs of valid characters are decoded in blocks
+            Blocks blocks = decodeBlocks(in + i, size - i, out);
+            i += blocks.consumed;
+            out += blocks.produced;
+            if (i == size) {
+                break;
+            }
+        }
+
+        uint8_t value = base64Values[in[i++]];
+        if (value < 64) {
+            bits = bits << 6 | value;
+            if (++count == 4) {
+                out[0] = static_cast<char>(bits >> 16);
+                out[1] = static_cast<char>(bits >> 8);
+                out[2] = static_cast<char>(bits);
+                out += 3;
+                bits = 0;
+                count = 0;
+            }
+        } else if (value == padding) {
+            out += finish(out);
+        }
+        // line breaks and other characters are skipped
+    }
+    return out - output;
+}
+
+void Base64Decoder::update(std::string_view input, std::string& output) {
+    size_t offset = output.size();
+    output.resize(offset + maxDecodedSize(input.size()));
+    output.resize(offset + update(input.data(), input.size(), output.data() + offset));
+}
+
+size_t Base64Decoder::finish(char* output) {
+    size_t written = 0;
+    if (count == 2) {
+        output[0] = static_cast<char>(bits >> 4);
+        written = 1;
+    } else if (count == 3) {
+        output[0] = static_cast<char>(bits >> 10);
+        output[1] = static_cast<char>(bits >> 2);
+        written = 2;
+    }
+    // a single sextet does not make a byte and is dropped
+    bits = 0;
+    count = 0;
+    return written;
+}
+
+void Base64Decoder::finish(std::string& output) {
+    char tail[2];
+    output.append(tail, finish(tail));
+}
+
+std::string Base64Decoder::decode(std::string_view encoded) {
+    Base64Decoder decoder;
+    std::string decoded;
+    decoder.update(encoded, decoded);
+    decoder.finish(decoded);
+    return decoded;
+}
+
+QuotedPrintableDecoder::QuotedPrintableDecoder(bool headerMode) : headerMode(headerMode) {}
+
+size_t QuotedPrintableDecoder::maxDecodedSize(size_t size) const {
+    // held whitespace and an unfinished escape may be written before the new input
+    return size + whitespace.size() + 2;
+}
+
+size_t QuotedPrintableDecoder::update(const char* input, size_t size, char* output) {
+    char* out = output;
+    size_t i = 0;
+    // looked for together with `=` and line breaks; `=` again when there is nothing else
+    char extra = headerMode ? '_' : '=';
+
+    auto flushWhitespace = [&]() {
+        std::memcpy(out, whitespace.data(), whitespace.size());
+        out += whitespace.size();
+        whitespace.clear();
+    };
+
+    while (i < size) {
+        char c = input[i];
+        switch (state) {
+            case State::TEXT: {
+                size_t end = i + findDelimiter(input + i, size - i, extra);
+                size_t textEnd = end;
+                bool lineBreak = end < size && (input[end] == '\r' || input[end] == '\n');
+                if (end == size || lineBreak) {
+                    // whitespace before a line break was added in transport
+                    while (textEnd > i && isBlank(input[textEnd - 1])) {
+                        --textEnd;
+                    }
+                }
+                if (textEnd > i) {
+                    flushWhitespace();
+                    std::memcpy(out, input + i, textEnd - i);
+                    out += textEnd - i;
+                }
+
+                if (end == size) {
+                    // the line may go on in the next chunk
+                    whitespace.append(input + textEnd, end - textEnd);
+                    i = size;
+                } else if (lineBreak) {
+                    whitespace.clear();
+                    *out++ = input[end];
+                    i = end + 1;
+                } else {
+                    flushWhitespace();
+                    if (input[end] == '=') {
+                        state = State::EQUALS;
+                    } else {
+                        *out++ = ' ';
+                    }
+                    i = end + 1;
+                }
+                break;
+            }
+            case State::EQUALS:
+                if (hexValue(c) >= 0) {
+                    firstDigit = c;
+                    state = State::HEX;
+                    ++i;
+                } else if (c == '\r') {
+                    state = State::SOFT_BREAK;
+                    ++i;
+                } else if (c == '\n') {
+                    state = State::TEXT;
+                    ++i;
+                } else {
+                    // not an escape, the `=` is kept and c is read as text
+                    *out++ = '=';
+                    state = State::TEXT;
+                }
+                break;
+            case State::HEX:
+                if (hexValue(c) >= 0) {
+                    *out++ = static_cast<char>(hexValue(firstDigit) << 4 | hexValue(c));
+                    ++i;
+                } else {
+                    *out++ = '=';
+                    *out++ = firstDigit;
+                }
+                state = State::TEXT;
+                break;
+            case State::SOFT_BREAK:
+                if (c == '\n') {
+                    ++i;
+                }
+                state = State::TEXT;
+                break;
+        }
+    }
+    return out - output;
+}
+
+void QuotedPrintableDecoder::update(std::string_view input, std::string& output) {
+    size_t offset = output.size();
+    output.resize(offset + maxDecodedSize(input.size()));
+    output.resize(offset + update(input.data(), input.size(), output.data() + offset));
+}
+
+size_t QuotedPrintableDecoder::finish(char* output) {
+    size_t written = 0;
+    if (state == State::EQUALS) {
+        output[written++] = '=';
+    } else if (state == State::HEX) {
+        output[written++] = '=';
+        output[written++] = firstDigit;
+    }
+    // whitespace at the end of the input ends the last line
+    whitespace.clear();
+    state = State::TEXT;
+    return written;
+}
+
+void QuotedPrintableDecoder::finish(std::string& output) {
+    char tail[2];
+    output.append(tail, finish(tail));
+}
+
+std::string QuotedPrintableDecoder::decode(std::string_view encoded, bool headerMode) {
+    QuotedPrintableDecoder decoder(headerMode);
+    std::string decoded;
+    decoder.update(encoded, decoded);
+    decoder.finish(decoded);
+    return decoded;
+}
@@ -0,0 +1,151 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#include "../include/PackSink.h"
+#include "../include/Stats.h"
+#include <stdexcept>
+#include <cerrno>
+#include <cstdio>
+#include <utility>
+#include <fcntl.h>
+#include <unistd.h>
+
+/**
+ * @brief Appends a number in little-endian byte order.
+ */
+template <typename T>
+static void appendLittleEndian(std::string& out, T value) {
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        out += static_cast<char>(value >> (8 * i) & 0xff);
+    }
+}
+
+PackSink::PackSink(std::string outDir) : outDir(std::move(outDir)) {}
+
+PackSink::~PackSink() {
+    if (dataFd >= 0) {
+        ::close(dataFd);
+        std::remove(dataPath.c_str());
+    }
+}
+
+MessageSink::Result PackSink::store(uint32_t messageId, std::string_view message, std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (failed || (path.empty() && !reserve())) {
+        return Result::FAILED;
+    }
+
+    entries.push_back({messageId, dataSize, message.size()});
+    dataSize += message.size();
+    buffer.append(message);
+    if (buffer.size() >= flushSize) {
+        flush();
+    }
+
+    name = path.substr(path.rfind('/') + 1);
+    return failed ? Result::FAILED : Result::SAVED;
+}
+
+/**
+ * @brief Writes the header and the offset table into the pack file and copies the data behind them.
+ */
+void PackSink::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (path.empty()) {
+        return;     // nothing was stored
+    }
+    flush();
+
+    std::string table = "IMAPPACK";
+    appendLittleEndian(table, static_cast<uint32_t>(entries.size()));
+    for (const Entry& entry : entries) {
+        appendLittleEndian(table, entry.uid);
+        appendLittleEndian(table, entry.offset);
+        appendLittleEndian(table, entry.length);
+    }
+
+    int fd = failed ? -1 : ::open(path.c_str(), O_WRONLY | O_TRUNC | O_CLOEXEC);
+    bool ok = fd >= 0 && writeAll(fd, table);
+
+    // copy in the kernel where possible, otherwise through a buffer
+    off_t offset = 0;
+    while (ok && static_cast<uint64_t>(offset) < dataSize) {
+        auto start = Stats::getInstance().now();
+        ssize_t copied = copy_file_range(dataFd, &offset, fd, nullptr, dataSize - offset, 0);
+        if (copied < 0 && errno == EINTR) {
+            continue;
+        }
+        if (copied < 0 && (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP)) {
+            std::string chunk(1024 * 1024, '\0');
+            ssize_t bytesRead;
+            while (ok && (bytesRead = pread(dataFd, chunk.data(), chunk.size(), offset)) > 0) {
+                ok = writeAll(fd, std::string_view(chunk.data(), bytesRead));
+                offset += bytesRead;
+            }
+            ok = ok && static_cast<uint64_t>(offset) == dataSize;
+            break;
+        }
+        ok = copied > 0;
+        if (ok) {
+            Stats::getInstance().diskWrite(static_cast<uint64_t>(copied), start);
+            offset += copied;
+        }
+    }
+
+    if (fd >= 0 && ::close(fd) != 0) {
+        ok = false;
+    }
+    ::close(dataFd);
+    std::remove(dataPath.c_str());
+    dataFd = -1;
+
+    if (!ok) {
+        std::remove(path.c_str());
+        throw std::runtime_error("Failed to write " + path);
+    }
+
+    // the next run gets a new pack file
+    path.clear();
+    entries.clear();
+    dataSize = 0;
+}
+
+/**
+ * @brief Takes the first free `messages-<n>.pack` name and opens the data file next to it.
+ */
+bool PackSink::reserve() {
+    for (int number = 1; ; ++number) {
+        std::string candidate = outDir + "/messages-" + std::to_string(number) + ".pack";
+        int fd = ::open(candidate.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if (fd >= 0) {
+            ::close(fd);
+            path = candidate;
+            break;
+        }
+        if (errno != EEXIST) {
+            failed = true;
+            return false;
+        }
+    }
+
+    dataPath = outDir + "/.messages.pack." + std::to_string(getpid()) + ".data";
+    dataFd = ::open(dataPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (dataFd < 0) {
+        std::remove(path.c_str());
+        path.clear();
+        failed = true;
+        return false;
+    }
+    return true;
+}
+
+void PackSink::flush() {
+    if (buffer.empty() || failed) {
+        return;
+    }
+    if (!writeAll(dataFd, buffer)) {
+        failed = true;
+    }
+    buffer.clear();
+}
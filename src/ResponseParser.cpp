@@ -0,0 +1,278 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#include "../include/ResponseParser.h"
+#include <charconv>
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+/**
+ * @brief Case-insensitive search of an ASCII word.
+ */
+static bool containsNoCase(std::string_view text, std::string_view word) {
+    auto it = std::search(text.begin(), text.end(), word.begin(), word.end(), [](char a, char b) {
+        return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+    });
+    return it != text.end();
+}
+
+/**
+ * @brief Reads a message number or UID, both are 32-bit unsigned numbers in IMAP.
+ * @return The end of the number, or first if there is no number.
+ * @throws std::runtime_error if the number does not fit into 32 bits.
+ */
+static const char* readNumber(const char* first, const char* last, uint32_t& value) {
+    auto [ptr, ec] = std::from_chars(first, last, value);
+    if (ec == std::errc::result_out_of_range) {
+        throw std::runtime_error("Number out of range in server response: " + std::string(first, ptr));
+    }
+    return ec == std::errc() ? ptr : first;
+}
+
+/**
+ * @brief Reads an atom, NIL or a quoted string starting at pos and moves pos behind it.
+ */
+static std::string readAString(std::string_view line, size_t& pos) {
+    std::string value;
+    if (pos < line.size() && line[pos] == '"') {
+        for (++pos; pos < line.size() && line[pos] != '"'; ++pos) {
+            if (line[pos] == '\\' && pos + 1 < line.size()) {
+                ++pos;
+            }
+            value += line[pos];
+        }
+        ++pos;
+    } else {
+        size_t end = line.find(' ', pos);
+        if (end == std::string_view::npos) {
+            end = line.size();
+        }
+        value = line.substr(pos, end - pos);
+        pos = end;
+    }
+    return value;
+}
+
+/**
+ * @brief Checks whether the line ends with `{N}` (or the non-synchronizing `{N+}`).
+ */
+bool ResponseParser::literalSize(std::string_view line, size_t& size) {
+    if (line.empty() || line.back() != '}') {
+        return false;
+    }
+
+    size_t open = line.rfind('{');
+    if (open == std::string_view::npos) {
+        return false;
+    }
+
+    const char* first = line.data() + open + 1;
+    const char* last = line.data() + line.size() - 1;
+    if (last > first && *(last - 1) == '+') {
+        --last;
+    }
+
+    auto [ptr, ec] = std::from_chars(first, last, size);
+    return ec == std::errc() && ptr == last && ptr != first;
+}
+
+/**
+ * @brief Parses `* <number> FETCH` and returns the message number.
+ */
+bool ResponseParser::fetchId(std::string_view line, uint32_t& messageId) {
+    if (line.size() < 2 || line[0] != '*' || line[1] != ' ') {
+        return false;
+    }
+
+    const char* first = line.data() + 2;
+    const char* end = line.data() + line.size();
+    const char* ptr = readNumber(first, end, messageId);
+    if (ptr == first) {
+        return false;
+    }
+
+    std::string_view rest(ptr, end - ptr);
+    return rest.substr(0, 7) == " FETCH ";
+}
+
+/**
+ * @brief Looks for ` UID <number>` or `(UID <number>` among the FETCH data items.
+ */
+bool ResponseParser::fetchUid(std::string_view text, uint32_t& uid) {
+    size_t pos = 0;
+    while ((pos = text.find("UID ", pos)) != std::string_view::npos) {
+        if (pos == 0 || text[pos - 1] == ' ' || text[pos - 1] == '(') {
+            const char* first = text.data() + pos + 4;
+            if (readNumber(first, text.data() + text.size(), uid) != first) {
+                return true;
+            }
+        }
+        pos += 4;
+    }
+    return false;
+}
+
+/**
+ * @brief Parses `[CODE <number>]` anywhere in the response.
+ */
+bool ResponseParser::responseCode(std::string_view response, std::string_view code, uint32_t& value) {
+    size_t pos = 0;
+    while ((pos = response.find(code, pos)) != std::string_view::npos) {
+        size_t valueStart = pos + code.size() + 1;
+        if (pos > 0 && response[pos - 1] == '[' && valueStart < response.size() && response[valueStart - 1] == ' ') {
+            const char* first = response.data() + valueStart;
+            if (readNumber(first, response.data() + response.size(), value) != first) {
+                return true;
+            }
+        }
+        pos += code.size();
+    }
+    return false;
+}
+
+/**
+ * @brief Returns the status word of `<tag> OK|NO|BAD ...`, or UNKNOWN for any other line.
+ */
+IMAPResponseType ResponseParser::taggedStatus(std::string_view line, std::string_view tag) {
+    if (line.size() <= tag.size() || line.compare(0, tag.size(), tag) != 0 || line[tag.size()] != ' ') {
+        return IMAPResponseType::UNKNOWN;
+    }
+
+    std::string_view status = line.substr(tag.size() + 1);
+    if (status.substr(0, 2) == "OK") {
+        return IMAPResponseType::OK;
+    } else if (status.substr(0, 2) == "NO") {
+        return IMAPResponseType::NO;
+    } else if (status.substr(0, 3) == "BAD") {
+        return IMAPResponseType::BAD;
+    }
+    return IMAPResponseType::UNKNOWN;
+}
+
+/**
+ * @brief Parses `* SEARCH 1 2 3` lines in a single pass without copying the numbers out.
+ */
+bool ResponseParser::searchIds(std::string_view response, std::vector<uint32_t>& ids) {
+    static constexpr std::string_view prefix = "* SEARCH";
+    bool found = false;
+    size_t lineStart = 0;
+
+    while (lineStart < response.size()) {
+        size_t lineEnd = response.find('\n', lineStart);
+        if (lineEnd == std::string_view::npos) {
+            lineEnd = response.size();
+        }
+
+        std::string_view line = response.substr(lineStart, lineEnd - lineStart);
+        if (line.substr(0, prefix.size()) == prefix && (line.size() == prefix.size() || line[prefix.size()] == ' ' || line[prefix.size()] == '\r')) {
+            found = true;
+            const char* pos = line.data() + prefix.size();
+            const char* end = line.data() + line.size();
+
+            while (pos < end) {
+                while (pos < end && *pos == ' ') {
+                    ++pos;
+                }
+
+                uint32_t id;
+                const char* ptr = readNumber(pos, end, id);
+                if (ptr == pos) {
+                    break;  // end of line or a trailing extension such as (MODSEQ ...)
+                }
+                ids.push_back(id);
+                pos = ptr;
+            }
+        }
+        lineStart = lineEnd + 1;
+    }
+    return found;
+}
+
+/**
+ * @brief Parses `* LIST (\HasNoChildren) "/" "Sent Items"`; literal names are left to the caller.
+ */
+bool ResponseParser::listEntry(std::string_view line, std::string& name, bool& selectable) {
+    static constexpr std::string_view prefix = "* LIST (";
+    if (line.substr(0, prefix.size()) != prefix) {
+        return false;
+    }
+
+    size_t flagsEnd = line.find(')', prefix.size());
+    if (flagsEnd == std::string_view::npos || flagsEnd + 2 > line.size()) {
+        return false;
+    }
+
+    std::string_view flags = line.substr(prefix.size(), flagsEnd - prefix.size());
+    selectable = !containsNoCase(flags, "\\Noselect") && !containsNoCase(flags, "\\NonExistent");
+
+    size_t pos = flagsEnd + 2;
+    readAString(line, pos);     // hierarchy delimiter
+    ++pos;
+
+    size_t literal;
+    if (literalSize(line, literal)) {
+        name.clear();
+    } else {
+        name = readAString(line, pos);
+    }
+    return true;
+}
+
+/**
+ * @brief Returns the position after the next capability list marker at or after pos, or npos.
+ */
+static size_t capabilityList(std::string_view response, size_t pos) {
+    while ((pos = response.find("CAPABILITY ", pos)) != std::string_view::npos) {
+        bool untagged = pos >= 2 && response.compare(pos - 2, 2, "* ") == 0;
+        bool code = pos >= 1 && response[pos - 1] == '[';
+        pos += 11;
+        if (untagged || code) {
+            return pos;
+        }
+    }
+    return std::string_view::npos;
+}
+
+/**
+ * @brief Looks for the capability among the space separated atoms of every capability list.
+ */
+bool ResponseParser::hasCapability(std::string_view response, std::string_view capability) {
+    size_t pos = 0;
+    while ((pos = capabilityList(response, pos)) != std::string_view::npos) {
+        size_t end = response.find_first_of("]\r\n", pos);
+        std::string_view list = response.substr(pos, end == std::string_view::npos ? end : end - pos);
+
+        size_t atomStart = 0;
+        while (atomStart < list.size()) {
+            size_t atomEnd = list.find(' ', atomStart);
+            if (atomEnd == std::string_view::npos) {
+                atomEnd = list.size();
+            }
+            std::string_view atom = list.substr(atomStart, atomEnd - atomStart);
+            if (atom.size() == capability.size() && containsNoCase(atom, capability)) {
+                return true;
+            }
+            atomStart = atomEnd + 1;
+        }
+        pos = end == std::string_view::npos ? response.size() : end;
+    }
+    return false;
+}
+
+bool ResponseParser::listsCapabilities(std::string_view response) {
+    return capabilityList(response, 0) != std::string_view::npos;
+}
+
+/**
+ * @brief Maps the untagged greeting onto a response type; PREAUTH counts as OK and BYE as NO.
+ */
+IMAPResponseType ResponseParser::greetingStatus(std::string_view line) {
+    if (line.substr(0, 4) == "* OK" || line.substr(0, 9) == "* PREAUTH") {
+        return IMAPResponseType::OK;
+    } else if (line.substr(0, 5) == "* BYE") {
+        return IMAPResponseType::NO;
+    }
+    return IMAPResponseType::UNKNOWN;
+}
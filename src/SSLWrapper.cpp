@@ -3,8 +3,35 @@
 //
 
 #include "SSLWrapper.h"
+#include "Stats.h"
 #include <iostream>
 #include <cstring>
+#include <climits>
+#include <algorithm>
+#include <stdexcept>
+#include <chrono>
+#include <ctime>
+#include <fcntl.h>
+#include <arpa/inet.h>
+#include <openssl/pem.h>
+
+namespace {
+    /// ex_data slot holding the session cache key ("server:port") of a connection
+    int sessionKeyIndex = -1;
+
+    void freeSessionKey(void*, void* ptr, CRYPTO_EX_DATA*, int, long, void*) {
+        delete static_cast<std::string*>(ptr);
+    }
+
+    bool isIpAddress(const std::string& server) {
+        unsigned char address[sizeof(struct in6_addr)];
+        return inet_pton(AF_INET, server.c_str(), address) == 1 || inet_pton(AF_INET6, server.c_str(), address) == 1;
+    }
+
+    bool isExpired(const SSL_SESSION* session) {
+        return SSL_SESSION_get_time(session) + SSL_SESSION_get_timeout(session) <= std::time(nullptr);
+    }
+}
 
 SSLWrapper::SSLWrapper() : ctx(nullptr) {}
 
@@ -18,6 +45,41 @@ SSLWrapper& SSLWrapper::getInstance() {
 }
 
 void SSLWrapper::initSSL() {
+    std::lock_guard<std::mutex> lock(mutex);
+    initLocked();
+}
+
+void SSLWrapper::prepareContext(const std::string& certFile, const std::string& certDir) {
+    std::lock_guard<std::mutex> lock(mutex);
+    bool ready = ctx && (certFile.empty() || loadedCertificates.count(certFile)) &&
+                 (certDir.empty() || loadedCertDirectories.count(certDir));
+    if (ready) {
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    initLocked();
+    if (!certFile.empty()) {
+        loadCertificate(certFile);
+    }
+    if (!certDir.empty()) {
+        loadCertDirectory(certDir);
+    }
+
+    if (verbose) {
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        std::cerr << "TLS context prepared in " << elapsed.count() << " ms" << std::endl;
+    }
+}
+
+/**
+ * @brief Initializes the library and the context once; the caller holds the mutex.
+ */
+void SSLWrapper::initLocked() {
+    if (ctx) {
+        return;     // already initialized by another connection
+    }
+
     SSL_library_init();
     OpenSSL_add_all_algorithms();
     SSL_load_error_strings();
@@ -28,50 +90,230 @@ void SSLWrapper::initContext() {
     const SSL_METHOD* method = TLS_client_method();
     ctx = SSL_CTX_new(method);
     if (!ctx) {
-        std::cerr << "Failed to create SSL context" << std::endl;
         ERR_print_errors_fp(stderr);
-        exit(EXIT_FAILURE);
+        throw std::runtime_error("Failed to create SSL context");
+    }
+
+    // sessions are cached by server and port in this class, OpenSSL only hands them over
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(ctx, newSessionCallback);
+    if (sessionKeyIndex < 0) {
+        sessionKeyIndex = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, freeSessionKey);
     }
 }
 
 void SSLWrapper::setCertificate(const std::string& certFile) {
+    std::lock_guard<std::mutex> lock(mutex);
+    loadCertificate(certFile);
+}
+
+void SSLWrapper::setCertDirectory(const std::string& certDir) {
+    std::lock_guard<std::mutex> lock(mutex);
+    loadCertDirectory(certDir);
+}
+
+/**
+ * @brief Loads a certificate file unless it is loaded already; the caller holds the mutex.
+ */
+void SSLWrapper::loadCertificate(const std::string& certFile) {
+    if (loadedCertificates.count(certFile)) {
+        return;
+    }
     if (SSL_CTX_use_certificate_file(ctx, certFile.c_str(), SSL_FILETYPE_PEM) <= 0) {
-        std::cerr << "Failed to load certificate file: " << certFile << std::endl;
+        // throwing releases the mutex, exit() would deadlock in the destructor
         ERR_print_errors_fp(stderr);
-        exit(EXIT_FAILURE);
+        throw std::runtime_error("Failed to load certificate file: " + certFile);
     }
+    loadedCertificates.insert(certFile);
 }
 
-void SSLWrapper::setCertDirectory(const std::string& certDir) {
+/**
+ * @brief Adds a certificate directory to the trust store unless it is there already; the caller holds the mutex.
+ */
+void SSLWrapper::loadCertDirectory(const std::string& certDir) {
+    if (loadedCertDirectories.count(certDir)) {
+        return;
+    }
     if (!SSL_CTX_load_verify_locations(ctx, nullptr, certDir.c_str())) {
-        std::cerr << "Failed to load certificate directory: " << certDir << std::endl;
         ERR_print_errors_fp(stderr);
-        exit(EXIT_FAILURE);
+        throw std::runtime_error("Failed to load certificate directory: " + certDir);
     }
+    loadedCertDirectories.insert(certDir);
 }
 
-SSL* SSLWrapper::createSSLConnection(int socket) {
-    SSL* ssl = SSL_new(ctx);
+SSL* SSLWrapper::prepareSSLConnection(int socket, const std::string& server, int port) {
+    SSL* ssl;
+    {
+        // another thread may be loading certificates into the context
+        std::lock_guard<std::mutex> lock(mutex);
+        ssl = ctx ? SSL_new(ctx) : nullptr;
+    }
     if (!ssl) {
         std::cerr << "Failed to create SSL object" << std::endl;
         return nullptr;
     }
 
+    std::string key = server + ":" + std::to_string(port);
+    if (!isIpAddress(server)) {
+        SSL_set_tlsext_host_name(ssl, server.c_str());
+    }
+    if (SSL_SESSION* session = findSession(key)) {
+        SSL_set_session(ssl, session);
+        SSL_SESSION_free(session);
+    }
+    SSL_set_ex_data(ssl, sessionKeyIndex, new std::string(key));
+
     SSL_set_fd(ssl, socket);
+    return ssl;
+}
+
+SSL* SSLWrapper::createSSLConnection(int socket, const std::string& server, int port) {
+    SSL* ssl = prepareSSLConnection(socket, server, port);
+    if (!ssl) {
+        return nullptr;
+    }
+
+    std::string key = server + ":" + std::to_string(port);
+    auto start = std::chrono::steady_clock::now();
     if (SSL_connect(ssl) <= 0) {
         std::cerr << "SSL connection failed" << std::endl;
         ERR_print_errors_fp(stderr);
         SSL_free(ssl);
         return nullptr;
     }
+    Stats::getInstance().record(Stats::Phase::TLS_HANDSHAKE, std::chrono::steady_clock::now() - start);
+
+    if (verbose) {
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        std::cerr << "TLS handshake with " << key << " took " << elapsed.count() << " ms ("
+                  << (SSL_session_reused(ssl) ? "resumed" : "full") << ", " << SSL_get_version(ssl) << ")" << std::endl;
+    }
 
     return ssl;
 }
 
+void SSLWrapper::setSessionCacheFile(const std::string& path) {
+    {
+        std::lock_guard<std::mutex> lock(sessionMutex);
+        sessionCacheFile = path;
+    }
+    loadSessions();
+}
+
+void SSLWrapper::setVerbose(bool enabled) {
+    verbose = enabled;
+}
+
+int SSLWrapper::newSessionCallback(SSL* ssl, SSL_SESSION* session) {
+    auto* key = static_cast<std::string*>(SSL_get_ex_data(ssl, sessionKeyIndex));
+    if (!key) {
+        return 0;
+    }
+    getInstance().storeSession(*key, session);
+    return 1;
+}
+
+void SSLWrapper::storeSession(const std::string& key, SSL_SESSION* session) {
+    std::lock_guard<std::mutex> lock(sessionMutex);
+    SSL_SESSION*& slot = sessions[key];
+    if (slot) {
+        SSL_SESSION_free(slot);
+    }
+    slot = session;
+}
+
+SSL_SESSION* SSLWrapper::findSession(const std::string& key) {
+    std::lock_guard<std::mutex> lock(sessionMutex);
+    auto it = sessions.find(key);
+    if (it == sessions.end() || !SSL_SESSION_is_resumable(it->second) || isExpired(it->second)) {
+        return nullptr;
+    }
+    SSL_SESSION_up_ref(it->second);
+    return it->second;
+}
+
+/**
+ * @brief The file holds a "server:port" line followed by the PEM encoded session for every entry.
+ */
+void SSLWrapper::loadSessions() {
+    std::lock_guard<std::mutex> lock(sessionMutex);
+    BIO* bio = BIO_new_file(sessionCacheFile.c_str(), "r");
+    if (!bio) {
+        ERR_clear_error();  // no cache yet
+        return;
+    }
+
+    char line[1024];
+    while (BIO_gets(bio, line, sizeof(line)) > 0) {
+        std::string key(line);
+        while (!key.empty() && (key.back() == '\n' || key.back() == '\r')) {
+            key.pop_back();
+        }
+        if (key.empty()) {
+            continue;
+        }
+
+        SSL_SESSION* session = PEM_read_bio_SSL_SESSION(bio, nullptr, nullptr, nullptr);
+        if (!session) {
+            std::cerr << "Ignoring malformed TLS session cache: " << sessionCacheFile << std::endl;
+            ERR_clear_error();
+            break;
+        }
+        if (isExpired(session)) {
+            SSL_SESSION_free(session);
+            continue;
+        }
+
+        SSL_SESSION*& slot = sessions[key];
+        if (slot) {
+            SSL_SESSION_free(slot);
+        }
+        slot = session;
+    }
+    BIO_free(bio);
+}
+
+void SSLWrapper::saveSessions() {
+    std::lock_guard<std::mutex> lock(sessionMutex);
+    if (sessionCacheFile.empty()) {
+        return;
+    }
+
+    // the sessions contain the secrets to resume them, keep the file private
+    int fd = open(sessionCacheFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        std::cerr << "Failed to write TLS session cache: " << sessionCacheFile << std::endl;
+        return;
+    }
+    BIO* bio = BIO_new_fd(fd, BIO_CLOSE);
+
+    for (const auto& [key, session] : sessions) {
+        if (!SSL_SESSION_is_resumable(session) || isExpired(session)) {
+            continue;
+        }
+        BIO_printf(bio, "%s\n", key.c_str());
+        PEM_write_bio_SSL_SESSION(bio, session);
+    }
+    BIO_free(bio);
+}
+
+void SSLWrapper::clearSessions() {
+    std::lock_guard<std::mutex> lock(sessionMutex);
+    for (const auto& entry : sessions) {
+        SSL_SESSION_free(entry.second);
+    }
+    sessions.clear();
+}
+
 void SSLWrapper::cleanupSSL() {
+    std::lock_guard<std::mutex> lock(mutex);
     if (ctx) {
+        saveSessions();
+        clearSessions();
         SSL_CTX_free(ctx);
         ctx = nullptr;
+        loadedCertificates.clear();
+        loadedCertDirectories.clear();
     }
 }
 
@@ -82,15 +324,21 @@ void SSLWrapper::closeSSLConnection(SSL* ssl) {
     }
 }
 
-int SSLWrapper::sendData(SSL* ssl, const std::string& data) {
-    return SSL_write(ssl, data.c_str(), data.length());
+int SSLWrapper::sendData(SSL* ssl, std::string_view data) {
+    return SSL_write(ssl, data.data(), static_cast<int>(data.size()));
 }
 
-int SSLWrapper::receiveData(SSL* ssl, std::string& buffer) {
-    char buf[4096];
-    int bytesReceived = SSL_read(ssl, buf, sizeof(buf));
+size_t SSLWrapper::receiveData(SSL* ssl, char* buffer, size_t size) {
+    int bytesReceived = SSL_read(ssl, buffer, static_cast<int>(std::min<size_t>(size, INT_MAX)));
     if (bytesReceived > 0) {
-        buffer.append(buf, bytesReceived);
+        return static_cast<size_t>(bytesReceived);
+    }
+
+    int error = SSL_get_error(ssl, bytesReceived);
+    if (error == SSL_ERROR_ZERO_RETURN) {
+        return 0;
+    } else if (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE) {
+        return noData;
     }
-    return bytesReceived;
+    throw std::runtime_error("Failed to read SSL response");
 }
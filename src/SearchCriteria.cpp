@@ -0,0 +1,229 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#include "../include/SearchCriteria.h"
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+namespace {
+    constexpr std::time_t day = 24 * 3600;
+
+    /**
+     * @brief Checks a sequence set: comma-separated numbers, `*` and ranges of them.
+     */
+    bool validSet(const std::string& set) {
+        size_t start = 0;
+        while (start <= set.size()) {
+            size_t end = std::min(set.find(',', start), set.size());
+            std::string range = set.substr(start, end - start);
+            size_t colon = range.find(':');
+            for (const std::string& number : {range.substr(0, colon),
+                                              colon == std::string::npos ? std::string("*") : range.substr(colon + 1)}) {
+                if (number != "*" && (number.empty() || number.size() > 10 || number[0] == '0' ||
+                                      !std::all_of(number.begin(), number.end(), ::isdigit))) {
+                    return false;
+                }
+            }
+            start = end + 1;
+        }
+        return true;
+    }
+}
+
+SearchCriteria& SearchCriteria::uid(const std::string& set) {
+    if (!validSet(set)) {
+        throw std::invalid_argument("invalid UID set: " + set);
+    }
+    return key("UID " + set);
+}
+
+SearchCriteria& SearchCriteria::unseen() {
+    return key("UNSEEN");
+}
+
+SearchCriteria& SearchCriteria::since(std::time_t time) {
+    return key("SINCE " + formatDate(time));
+}
+
+SearchCriteria& SearchCriteria::before(std::time_t time) {
+    return key("BEFORE " + formatDate(time));
+}
+
+SearchCriteria& SearchCriteria::larger(size_t size) {
+    return key("LARGER " + std::to_string(size));
+}
+
+SearchCriteria& SearchCriteria::smaller(size_t size) {
+    return key("SMALLER " + std::to_string(size));
+}
+
+SearchCriteria& SearchCriteria::from(const std::string& text) {
+    std::string from = "FROM ";
+    addString(from, text);
+    return key(std::move(from));
+}
+
+SearchCriteria& SearchCriteria::header(const std::string& field, const std::string& text) {
+    // field-name = 1*<any printable ASCII except ":"> (RFC 5322, section 3.6.8)
+    if (field.empty() || !std::all_of(field.begin(), field.end(), [](char c) {
+        return c > 0x20 && c < 0x7f && c != ':';
+    })) {
+        throw std::invalid_argument("invalid header field name: " + field);
+    }
+    std::string header = "HEADER ";
+    addString(header, field);
+    header += ' ';
+    addString(header, text);
+    return key(std::move(header));
+}
+
+SearchCriteria& SearchCriteria::add(const SearchCriteria& other) {
+    keys.insert(keys.end(), other.keys.begin(), other.keys.end());
+    utf8 = utf8 || other.utf8;
+    literals = literals || other.literals;
+    return *this;
+}
+
+SearchCriteria& SearchCriteria::negate(const SearchCriteria& other) {
+    utf8 = utf8 || other.utf8;
+    literals = literals || other.literals;
+    return key("NOT " + other.group());
+}
+
+SearchCriteria SearchCriteria::either(const SearchCriteria& first, const SearchCriteria& second) {
+    SearchCriteria criteria;
+    criteria.utf8 = first.utf8 || second.utf8;
+    criteria.literals = first.literals || second.literals;
+    return criteria.key("OR " + first.group() + " " + second.group());
+}
+
+SearchCriteria SearchCriteria::fromConfig(const ArgParser::Config& config) {
+    SearchCriteria criteria;
+    if (!config.uidSet.empty()) {
+        criteria.uid(config.uidSet);
+    }
+    if (config.since > 0) {
+        criteria.since(config.since);
+    }
+    if (config.before > 0) {
+        criteria.before(config.before);
+    }
+    if (config.larger > 0) {
+        criteria.larger(config.larger);
+    }
+    if (config.smaller > 0) {
+        criteria.smaller(config.smaller);
+    }
+
+    if (!config.fromAddresses.empty()) {
+        SearchCriteria senders = SearchCriteria().from(config.fromAddresses[0]);
+        for (size_t i = 1; i < config.fromAddresses.size(); ++i) {
+            senders = either(senders, SearchCriteria().from(config.fromAddresses[i]));
+        }
+        criteria.add(senders);
+    }
+    for (const auto& [field, text] : config.headers) {
+        criteria.header(field, text);
+    }
+
+    // SINCE and BEFORE compare dates in the server's time zone, so a day of slack keeps them a superset
+    if (config.maxSize > 0) {
+        criteria.smaller(config.maxSize + 1);
+    }
+    if (config.receivedAfter > 0) {
+        criteria.since(config.receivedAfter - day);
+    }
+    if (config.receivedBefore > 0) {
+        criteria.before(config.receivedBefore + 2 * day);
+    }
+    return criteria;
+}
+
+SearchCriteria SearchCriteria::forSync(const ArgParser::Config& config, uint32_t firstUid) {
+    SearchCriteria criteria;
+    if (firstUid > 1) {
+        criteria.uid(std::to_string(firstUid) + ":*");
+    }
+    if (config.onlyNew) {
+        criteria.unseen();
+    }
+    return criteria.add(fromConfig(config));
+}
+
+bool SearchCriteria::empty() const {
+    return keys.empty();
+}
+
+bool SearchCriteria::hasLiterals() const {
+    return literals;
+}
+
+std::string SearchCriteria::toString() const {
+    std::string text = utf8 ? "CHARSET UTF-8 " : "";
+    if (keys.empty()) {
+        return text + "ALL";
+    }
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (i > 0) {
+            text += ' ';
+        }
+        text += keys[i];
+    }
+    return text;
+}
+
+std::string SearchCriteria::formatDate(std::time_t time) {
+    static constexpr const char* months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                             "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+    std::tm utc{};
+    gmtime_r(&time, &utc);
+    return std::to_string(utc.tm_mday) + "-" + months[utc.tm_mon] + "-" + std::to_string(utc.tm_year + 1900);
+}
+
+SearchCriteria& SearchCriteria::key(std::string text) {
+    keys.push_back(std::move(text));
+    return *this;
+}
+
+/**
+ * @brief Appends a string argument: quoted, or as a literal if a quoted string cannot hold it.
+ */
+void SearchCriteria::addString(std::string& key, const std::string& value) {
+    bool eightBit = std::any_of(value.begin(), value.end(), [](char c) {
+        return static_cast<unsigned char>(c) >= 0x80;
+    });
+    utf8 = utf8 || eightBit;
+
+    if (eightBit || value.find_first_of(std::string("\r\n\0", 3)) != std::string::npos) {
+        key += "{" + std::to_string(value.size()) + "}\r\n" + value;
+        literals = true;
+        return;
+    }
+
+    key += '"';
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            key += '\\';
+        }
+        key += c;
+    }
+    key += '"';
+}
+
+/**
+ * @brief Returns the keys as one search key, in parentheses if there are several.
+ */
+std::string SearchCriteria::group() const {
+    if (keys.empty()) {
+        return "ALL";
+    } else if (keys.size() == 1) {
+        return keys[0];
+    }
+    std::string text = "(";
+    for (size_t i = 0; i < keys.size(); ++i) {
+        text += (i > 0 ? " " : "") + keys[i];
+    }
+    return text + ")";
+}
@@ -0,0 +1,44 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#include "../include/SequenceSet.h"
+#include <algorithm>
+
+std::vector<std::string> SequenceSet::build(std::vector<uint32_t> ids, size_t maxSetLength) {
+    std::vector<std::string> sets;
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    std::string current;
+    size_t i = 0;
+
+    while (i < ids.size()) {
+        // extend the range as long as the numbers are consecutive
+        size_t j = i;
+        while (j + 1 < ids.size() && ids[j + 1] == ids[j] + 1) {
+            ++j;
+        }
+
+        std::string range = std::to_string(ids[i]);
+        if (j > i) {
+            range += ":" + std::to_string(ids[j]);
+        }
+
+        if (!current.empty() && current.size() + 1 + range.size() > maxSetLength) {
+            sets.push_back(std::move(current));
+            current.clear();
+        }
+
+        if (!current.empty()) {
+            current += ',';
+        }
+        current += range;
+        i = j + 1;
+    }
+
+    if (!current.empty()) {
+        sets.push_back(std::move(current));
+    }
+    return sets;
+}
@@ -0,0 +1,112 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#include "../include/ShardedFetch.h"
+
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <algorithm>
+#include <utility>
+#include <unistd.h>
+
+ShardedFetch::ShardedFetch(ArgParser::Config config) : config(std::move(config)) {}
+
+int ShardedFetch::run(IMAPClient& client) {
+    std::vector<std::vector<uint32_t>> shards = split(client.getIds(), static_cast<size_t>(config.connections));
+    size_t total = client.getIds().size();
+
+    std::vector<std::thread> threads;
+    std::vector<std::exception_ptr> errors(shards.size());
+    std::mutex mutex;
+    std::condition_variable finished;
+    size_t running = shards.size();
+
+    auto runShard = [&](size_t index) {
+        try {
+            if (index == 0) {
+                client.setIds(std::move(shards[0]));
+                client.setProgressCounter(&progress);
+                client.fetch();
+            } else {
+                fetchShard(std::move(shards[index]), client);
+            }
+        } catch (...) {
+            errors[index] = std::current_exception();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        running--;
+        finished.notify_one();
+    };
+
+    for (size_t i = 0; i < shards.size(); ++i) {
+        threads.emplace_back(runShard, i);
+    }
+
+    // merged progress of all connections, only when somebody is watching
+    bool showProgress = isatty(STDERR_FILENO);
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!finished.wait_for(lock, std::chrono::seconds(1), [&running] { return running == 0; })) {
+            if (showProgress) {
+                std::cerr << "\rDownloaded " + std::to_string(progress.load()) + "/" + std::to_string(total) + " messages" << std::flush;
+            }
+        }
+    }
+    if (showProgress) {
+        std::cerr << "\r" << std::string(40, ' ') << "\r" << std::flush;
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    client.setProgressCounter(nullptr);
+
+    for (auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+    return progress.load();
+}
+
+/**
+ * @brief Fetches one shard over a new connection that selects the same mailbox.
+ *
+ * Saved messages are recorded in the sync state shared with the client that did SEARCH,
+ * which also shares its writer pool and message sink.
+ */
+void ShardedFetch::fetchShard(std::vector<uint32_t> ids, const IMAPClient& searched) {
+    IMAPClient client(config);
+    client.setWriterPool(searched.getWriterPool());
+    client.connect();
+    client.login();
+    client.select();
+    client.setIds(std::move(ids));
+    client.setSyncState(searched.getSyncState());
+    client.setSink(searched.getSink());
+    client.setProgressCounter(&progress);
+    client.fetch();
+    client.logout();
+}
+
+/**
+ * @brief Splits message numbers into at most `shards` parts of consecutive numbers with equal sizes.
+ */
+std::vector<std::vector<uint32_t>> ShardedFetch::split(std::vector<uint32_t> ids, size_t shards) {
+    std::vector<std::vector<uint32_t>> result;
+    std::sort(ids.begin(), ids.end());
+
+    shards = std::max<size_t>(1, std::min(shards, ids.size()));
+    size_t begin = 0;
+    for (size_t i = 0; i < shards; ++i) {
+        size_t end = ids.size() * (i + 1) / shards;
+        result.emplace_back(ids.begin() + begin, ids.begin() + end);
+        begin = end;
+    }
+    return result;
+}
@@ -0,0 +1,222 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#include "../include/Stats.h"
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <sys/resource.h>
+
+Stats::Timer::Timer(Phase phase)
+        : phase(phase), running(Stats::getInstance().isEnabled()) {
+    if (running) {
+        start = std::chrono::steady_clock::now();
+    }
+}
+
+Stats::Timer::~Timer() {
+    stop();
+}
+
+void Stats::Timer::stop() {
+    if (running) {
+        Stats::getInstance().record(phase, std::chrono::steady_clock::now() - start);
+        running = false;
+    }
+}
+
+void Stats::Timer::cancel() {
+    running = false;
+}
+
+Stats& Stats::getInstance() {
+    static Stats instance;
+    return instance;
+}
+
+void Stats::enable() {
+    startedAt = std::chrono::steady_clock::now();
+    enabled.store(true, std::memory_order_relaxed);
+}
+
+void Stats::record(Phase phase, std::chrono::nanoseconds elapsed) {
+    if (!isEnabled()) {
+        return;
+    }
+
+    PhaseStats& stats = phases[static_cast<size_t>(phase)];
+    auto ns = static_cast<uint64_t>(std::max<int64_t>(elapsed.count(), 0));
+    stats.count.fetch_add(1, std::memory_order_relaxed);
+    stats.totalNs.fetch_add(ns, std::memory_order_relaxed);
+
+    uint64_t max = stats.maxNs.load(std::memory_order_relaxed);
+    while (ns > max && !stats.maxNs.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+    }
+
+    // bucket i holds samples below 2^i ns, so bit_width() is the bucket index
+    size_t bucket = std::min<size_t>(std::bit_width(ns), buckets - 1);
+    stats.histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+std::chrono::steady_clock::time_point Stats::now() const {
+    return isEnabled() ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+}
+
+void Stats::diskWrite(uint64_t bytes, std::chrono::steady_clock::time_point start) {
+    if (!isEnabled()) {
+        return;
+    }
+    record(Phase::DISK_WRITE, std::chrono::steady_clock::now() - start);
+    add(Counter::DISK_BYTES, bytes);
+    add(Counter::DISK_WRITE_CALLS);
+}
+
+uint64_t Stats::get(Counter counter) const {
+    return counters[static_cast<size_t>(counter)].load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Estimates a percentile as the upper bound of the histogram bucket holding it, at most the maximum.
+ */
+double Stats::percentileMs(const PhaseStats& phase, double fraction) const {
+    uint64_t count = phase.count.load(std::memory_order_relaxed);
+    if (count == 0) {
+        return 0;
+    }
+
+    auto rank = static_cast<uint64_t>(fraction * static_cast<double>(count - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets; ++i) {
+        seen += phase.histogram[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return static_cast<double>(std::min(uint64_t{1} << i, phase.maxNs.load(std::memory_order_relaxed))) / 1e6;
+        }
+    }
+    return static_cast<double>(phase.maxNs.load(std::memory_order_relaxed)) / 1e6;
+}
+
+double Stats::elapsedSeconds() const {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startedAt;
+    return elapsed.count();
+}
+
+const char* Stats::phaseName(Phase phase) {
+    switch (phase) {
+        case Phase::DNS: return "dns";
+        case Phase::TCP_CONNECT: return "tcp_connect";
+        case Phase::TLS_HANDSHAKE: return "tls_handshake";
+        case Phase::GREETING: return "greeting";
+        case Phase::AUTH: return "login";
+        case Phase::MAILBOX_SELECT: return "select";
+        case Phase::MAILBOX_SEARCH: return "search";
+        case Phase::METADATA_FETCH: return "metadata";
+        case Phase::MESSAGE_FETCH: return "fetch";
+        case Phase::DISK_WRITE: return "disk_write";
+        case Phase::QUIT: return "logout";
+        default: return "unknown";
+    }
+}
+
+const char* Stats::counterName(Counter counter) {
+    switch (counter) {
+        case Counter::BYTES_RECEIVED: return "bytes_received";
+        case Counter::RESPONSE_BYTES: return "response_bytes";
+        case Counter::BYTES_SENT: return "bytes_sent";
+        case Counter::RECEIVE_CALLS: return "receive_calls";
+        case Counter::SEND_CALLS: return "send_calls";
+        case Counter::SPLICE_CALLS: return "splice_calls";
+        case Counter::DISK_BYTES: return "disk_bytes";
+        case Counter::DISK_WRITE_CALLS: return "disk_write_calls";
+        case Counter::MESSAGES_SAVED: return "messages_saved";
+        case Counter::CONNECTIONS: return "connections";
+        default: return "unknown";
+    }
+}
+
+/**
+ * @brief Returns the peak resident set size of the process in KiB.
+ */
+long Stats::peakRssKb() {
+    struct rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+void Stats::printSummary(std::ostream& out) const {
+    double seconds = elapsedSeconds();
+    auto received = static_cast<double>(get(Counter::BYTES_RECEIVED));
+    auto responses = static_cast<double>(get(Counter::RESPONSE_BYTES));
+    auto messages = static_cast<double>(get(Counter::MESSAGES_SAVED));
+    char line[192];
+
+    std::snprintf(line, sizeof(line), "%-14s %8s %10s %10s %10s %10s %10s\n",
+                  "phase", "count", "total ms", "avg ms", "p50 ms", "p99 ms", "max ms");
+    out << line;
+    for (size_t i = 0; i < phases.size(); ++i) {
+        const PhaseStats& phase = phases[i];
+        uint64_t count = phase.count.load(std::memory_order_relaxed);
+        if (count == 0) {
+            continue;
+        }
+        double total = static_cast<double>(phase.totalNs.load(std::memory_order_relaxed)) / 1e6;
+        std::snprintf(line, sizeof(line), "%-14s %8llu %10.3f %10.3f %10.3f %10.3f %10.3f\n",
+                      phaseName(static_cast<Phase>(i)), static_cast<unsigned long long>(count), total,
+                      total / static_cast<double>(count), percentileMs(phase, 0.5), percentileMs(phase, 0.99),
+                      static_cast<double>(phase.maxNs.load(std::memory_order_relaxed)) / 1e6);
+        out << line;
+    }
+
+    for (size_t i = 0; i < counters.size(); ++i) {
+        std::snprintf(line, sizeof(line), "%-20s %llu\n", counterName(static_cast<Counter>(i)),
+                      static_cast<unsigned long long>(get(static_cast<Counter>(i))));
+        out << line;
+    }
+
+    std::snprintf(line, sizeof(line), "wall time %.3f s, %.1f messages/s, %.2f MB/s of responses (%.2f MB/s on the wire), "
+                                      "peak RSS %ld KiB\n",
+                  seconds, seconds > 0 ? messages / seconds : 0.0, seconds > 0 ? responses / seconds / 1e6 : 0.0,
+                  seconds > 0 ? received / seconds / 1e6 : 0.0, peakRssKb());
+    out << line;
+}
+
+void Stats::writeJson(std::ostream& out) const {
+    double seconds = elapsedSeconds();
+    auto received = static_cast<double>(get(Counter::BYTES_RECEIVED));
+    auto responses = static_cast<double>(get(Counter::RESPONSE_BYTES));
+    auto messages = static_cast<double>(get(Counter::MESSAGES_SAVED));
+    char number[64];
+
+    auto decimal = [&number](double value) {
+        std::snprintf(number, sizeof(number), "%.6f", value);
+        return number;
+    };
+
+    out << "{\"wall_seconds\":" << decimal(seconds);
+    out << ",\"messages_per_second\":" << decimal(seconds > 0 ? messages / seconds : 0.0);
+    out << ",\"response_bytes_per_second\":" << decimal(seconds > 0 ? responses / seconds : 0.0);
+    out << ",\"wire_bytes_per_second\":" << decimal(seconds > 0 ? received / seconds : 0.0);
+    out << ",\"peak_rss_kb\":" << peakRssKb();
+
+    out << ",\"counters\":{";
+    for (size_t i = 0; i < counters.size(); ++i) {
+        out << (i ? "," : "") << '"' << counterName(static_cast<Counter>(i)) << "\":"
+            << get(static_cast<Counter>(i));
+    }
+
+    out << "},\"phases\":{";
+    for (size_t i = 0; i < phases.size(); ++i) {
+        const PhaseStats& phase = phases[i];
+        uint64_t count = phase.count.load(std::memory_order_relaxed);
+        double total = static_cast<double>(phase.totalNs.load(std::memory_order_relaxed)) / 1e6;
+        out << (i ? "," : "") << '"' << phaseName(static_cast<Phase>(i)) << "\":{\"count\":" << count;
+        out << ",\"total_ms\":" << decimal(total);
+        out << ",\"avg_ms\":" << decimal(count ? total / static_cast<double>(count) : 0.0);
+        out << ",\"p50_ms\":" << decimal(percentileMs(phase, 0.5));
+        out << ",\"p90_ms\":" << decimal(percentileMs(phase, 0.9));
+        out << ",\"p99_ms\":" << decimal(percentileMs(phase, 0.99));
+        out << ",\"max_ms\":" << decimal(static_cast<double>(phase.maxNs.load(std::memory_order_relaxed)) / 1e6)
+            << "}";
+    }
+    out << "}}\n";
+}
@@ -0,0 +1,152 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#include "../include/SyncState.h"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <filesystem>
+#include <algorithm>
+#include <utility>
+#include <charconv>
+#include <limits>
+
+SyncState::SyncState(std::string path) : path(std::move(path)) {}
+
+std::string SyncState::pathFor(const std::string& outDir, bool onlyHeaders, const std::string& format) {
+    std::string stateFile = outDir + (onlyHeaders ? "/.imapcl-state-headers" : "/.imapcl-state");
+    if (format != "files") {
+        stateFile += "-" + format;
+    }
+    return stateFile;
+}
+
+std::shared_ptr<SyncState> SyncState::open(const std::string& outDir, bool onlyHeaders, const std::string& format,
+                                           uint32_t uidValidity) {
+    auto state = std::make_shared<SyncState>(pathFor(outDir, onlyHeaders, format));
+    state->load();
+    state->validate(uidValidity);
+    return state;
+}
+
+void SyncState::load() {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return;
+    }
+
+    std::string line, key;
+    if (!std::getline(file, line) || !(std::istringstream(line) >> key >> uidValidity) || key != "UIDVALIDITY" ||
+        !std::getline(file, line) || !(std::istringstream(line) >> key >> highestUid) || key != "HIGHESTUID") {
+        throw std::runtime_error("Bad sync state file format: " + path);
+    }
+
+    while (std::getline(file, line)) {
+        size_t space = line.find(' ');
+        uint32_t uid;
+        if (space == std::string::npos ||
+            std::from_chars(line.data(), line.data() + space, uid).ptr != line.data() + space) {
+            throw std::runtime_error("Bad sync state file format: " + path);
+        }
+        index[uid] = line.substr(space + 1);
+    }
+}
+
+void SyncState::save() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string tmpPath = path + ".tmp";
+
+    std::ofstream file(tmpPath, std::ios::trunc);
+    file << "UIDVALIDITY " << uidValidity << "\n" << "HIGHESTUID " << highestUid << "\n";
+    for (const auto& [uid, filename] : index) {
+        file << uid << " " << filename << "\n";
+    }
+    file.close();
+
+    if (!file) {
+        throw std::runtime_error("Failed to write sync state file: " + tmpPath);
+    }
+    std::filesystem::rename(tmpPath, path);
+}
+
+void SyncState::validate(uint32_t validity) {
+    if (validity != uidValidity) {
+        uidValidity = validity;
+        highestUid = 0;
+        index.clear();
+    }
+}
+
+uint32_t SyncState::getHighestUid() const {
+    return highestUid;
+}
+
+void SyncState::setHighestUid(uint32_t uid) {
+    highestUid = std::max(highestUid, uid);
+}
+
+bool SyncState::contains(uint32_t uid) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return index.count(uid) != 0;
+}
+
+void SyncState::add(uint32_t uid, const std::string& filename) {
+    std::lock_guard<std::mutex> lock(mutex);
+    index[uid] = filename;
+}
+
+bool SyncState::beginSync(uint32_t uidNext) {
+    pending.clear();
+    if (highestUid == std::numeric_limits<uint32_t>::max()) {
+        firstUid = highestUid;      // the highest possible UID was synced, nothing can follow it
+        coveredUpTo = highestUid;
+        return false;
+    }
+    firstUid = highestUid + 1;
+    coveredUpTo = uidNext > 0 ? uidNext - 1 : 0;
+    return uidNext == 0 || uidNext > firstUid;
+}
+
+uint32_t SyncState::getFirstUid() const {
+    return firstUid;
+}
+
+std::vector<uint32_t> SyncState::takeFound(const std::vector<uint32_t>& found, bool narrowed) {
+    if (narrowed) {
+        coveredUpTo = firstUid - 1;
+    }
+
+    std::vector<uint32_t> ids;
+    for (uint32_t uid : found) {
+        if (!narrowed) {
+            coveredUpTo = std::max(coveredUpTo, uid);
+        }
+        if (uid >= firstUid && !contains(uid)) {
+            ids.push_back(uid);
+        }
+    }
+    pending.insert(pending.end(), ids.begin(), ids.end());
+    return ids;
+}
+
+void SyncState::holdBack(uint32_t uid) {
+    coveredUpTo = std::min(coveredUpTo, uid - 1);
+}
+
+void SyncState::commit(bool advance) {
+    if (advance) {
+        uint32_t upTo = coveredUpTo;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (uint32_t uid : pending) {
+                if (index.count(uid) == 0) {
+                    upTo = std::min(upTo, uid - 1);
+                }
+            }
+        }
+        setHighestUid(upTo);
+    }
+    pending.clear();
+    save();
+}
@@ -0,0 +1,58 @@
+//
+// Created by Andrii Bondarenko (xbonda06) on 17.10.2026.
+//
+
+#include "../include/WriterPool.h"
+#include <utility>
+
+WriterPool::WriterPool(size_t threadCount, size_t memoryLimit) : memoryLimit(memoryLimit) {
+    for (size_t i = 0; i < threadCount; ++i) {
+        threads.emplace_back(&WriterPool::worker, this);
+    }
+}
+
+WriterPool::~WriterPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    available.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void WriterPool::submit(size_t bytes, std::function<void()> task) {
+    std::unique_lock<std::mutex> lock(mutex);
+    released.wait(lock, [this, bytes] { return queuedBytes == 0 || queuedBytes + bytes <= memoryLimit; });
+
+    queuedBytes += bytes;
+    tasks.push_back({bytes, std::move(task)});
+    lock.unlock();
+    available.notify_one();
+}
+
+/**
+ * @brief Runs tasks until the pool is destroyed and no task is left.
+ */
+void WriterPool::worker() {
+    while (true) {
+        std::unique_lock<std::mutex> lock(mutex);
+        available.wait(lock, [this] { return stopping || !tasks.empty(); });
+        if (tasks.empty()) {
+            return;
+        }
+
+        Task task = std::move(tasks.front());
+        tasks.pop_front();
+        lock.unlock();
+
+        task.run();
+        task.run = nullptr;     // the task holds the message, free it before releasing its memory
+
+        lock.lock();
+        queuedBytes -= task.bytes;
+        lock.unlock();
+        released.notify_all();
+    }
+}
@@ -2,40 +2,74 @@
 // Created by Andrii Bondarenko (xbonda06)
 //
 #include <iostream>
+#include <fstream>
 #include "../include/ArgParser.h"
 #include "../include/IMAPClient.h"
 #include "IMAPCommandFactory.h"
 #include "SSLWrapper.h"
+#include "JobRunner.h"
+#include "Stats.h"
+#include "WriterPool.h"
+#include <memory>
+
+/**
+ * @brief Prints the summary requested by `--stats` and writes the JSON requested by `--stats-json`.
+ */
+static void reportStats(const ArgParser::Config& config) {
+    Stats& stats = Stats::getInstance();
+    if (config.stats) {
+        stats.printSummary(std::cerr);
+    }
+
+    if (config.statsJson == "-") {
+        stats.writeJson(std::cout);
+    } else if (!config.statsJson.empty()) {
+        std::ofstream json(config.statsJson);
+        stats.writeJson(json);
+        if (!json) {
+            std::cerr << "Failed to write stats to " << config.statsJson << std::endl;
+        }
+    }
+}
 
 int main(int argc, char* argv[]) {
+    ArgParser::Config config;
     try {
         ArgParser parser;
-        ArgParser::Config config = parser.parse(argc, argv);
-
-        config.port = config.useSSL ? 993 : 143;
+        config = parser.parse(argc, argv);
 
-        IMAPClient client(config);
-
-        client.connect();
+        if (config.stats || !config.statsJson.empty()) {
+            Stats::getInstance().enable();
+        }
 
-        client.login();
+        if (config.useSSL || !config.jobsFile.empty()) {
+            SSLWrapper::getInstance().setVerbose(config.verbose);
+            if (!config.tlsSessionCache.empty()) {
+                SSLWrapper::getInstance().setSessionCacheFile(config.tlsSessionCache);
+            }
+        }
 
-        client.select();
+        std::shared_ptr<WriterPool> writerPool;
+        if (config.writers > 0) {
+            writerPool = std::make_shared<WriterPool>(config.writers, config.writeBuffer * 1024 * 1024);
+        }
 
-        if(client.search()){
-            client.fetch();
+        int result;
+        if (!config.jobsFile.empty()) {
+            result = JobRunner(config, writerPool).run();
         } else {
-            std::cout << "No message has been downloaded from the " + config.mailbox + " mailbox" << std::endl;
+            result = JobRunner::runJob(config, writerPool);
         }
+        // the pool finishes its queued writes before the stats are reported
+        writerPool.reset();
 
-        client.logout();
-
-        if (config.useSSL) {
-            SSLWrapper::getInstance().cleanupSSL();
-        }
+        SSLWrapper::getInstance().cleanupSSL();
+        reportStats(config);
+        return result;
 
     } catch (const std::exception &e) {
         std::cerr << "Error: " << e.what() << std::endl;
+        reportStats(config);
         return 1;
     }
 